@@ -0,0 +1,1145 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "BatchRunner.h"
+#include "core/field/FieldArchivePC.h"
+#include "core/field/FieldArchivePS.h"
+#include "core/Lgp.h"
+#include "core/IsoArchive.h"
+
+void BatchJson::insert(const QString &key, const QString &value)
+{
+	insertRaw(key, quote(value));
+}
+
+void BatchJson::insert(const QString &key, const char *value)
+{
+	insert(key, QString(value));
+}
+
+void BatchJson::insert(const QString &key, qint64 value)
+{
+	insertRaw(key, QString::number(value));
+}
+
+void BatchJson::insert(const QString &key, int value)
+{
+	insertRaw(key, QString::number(value));
+}
+
+void BatchJson::insert(const QString &key, double value)
+{
+	insertRaw(key, QString::number(value, 'f', 2));
+}
+
+void BatchJson::insert(const QString &key, bool value)
+{
+	insertRaw(key, value ? "true" : "false");
+}
+
+void BatchJson::insert(const QString &key, const BatchJson &value)
+{
+	insertRaw(key, value.toString());
+}
+
+void BatchJson::insert(const QString &key, const QList<BatchJson> &values)
+{
+	QStringList items;
+	foreach(const BatchJson &value, values) {
+		items.append(value.toString());
+	}
+	insertRaw(key, "[" + items.join(",") + "]");
+}
+
+void BatchJson::insertRaw(const QString &key, const QString &json)
+{
+	_members.append(quote(key) + ":" + json);
+}
+
+QString BatchJson::toString() const
+{
+	return "{" + _members.join(",") + "}";
+}
+
+QString BatchJson::quote(const QString &str)
+{
+	QString ret("\"");
+	ret.reserve(str.size() + 2);
+
+	foreach(const QChar &c, str) {
+		switch(c.unicode()) {
+		case '"':	ret.append("\\\"");	break;
+		case '\\':	ret.append("\\\\");	break;
+		case '\n':	ret.append("\\n");	break;
+		case '\r':	ret.append("\\r");	break;
+		case '\t':	ret.append("\\t");	break;
+		default:
+			if(c.unicode() < 0x20) {
+				ret.append(QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')));
+			} else {
+				ret.append(c);
+			}
+		}
+	}
+
+	return ret.append('"');
+}
+
+BatchRunner::BatchRunner() :
+	_fieldArchive(NULL), _out(stdout)
+{
+	_out.setCodec("UTF-8");
+
+	_commands.insert("open", &BatchRunner::open);
+	_commands.insert("search-text", &BatchRunner::searchText);
+	_commands.insert("search-opcode", &BatchRunner::searchOpcode);
+	_commands.insert("export", &BatchRunner::exportation);
+	_commands.insert("import", &BatchRunner::importation);
+	_commands.insert("compile", &BatchRunner::compile);
+	_commands.insert("analyze-scripts", &BatchRunner::analyzeScripts);
+	_commands.insert("validate-walkmeshes", &BatchRunner::validateWalkmeshes);
+	_commands.insert("layout-texts", &BatchRunner::layoutTexts);
+	_commands.insert("callers", &BatchRunner::callers);
+	_commands.insert("fields-leading-to", &BatchRunner::fieldsLeadingTo);
+	_commands.insert("route", &BatchRunner::route);
+	_commands.insert("save", &BatchRunner::save);
+	_commands.insert("pack", &BatchRunner::pack);
+	_commands.insert("extract", &BatchRunner::extract);
+	_commands.insert("create-patch", &BatchRunner::createPatch);
+	_commands.insert("apply-patch", &BatchRunner::applyPatch);
+	_commands.insert("close", &BatchRunner::closeCommand);
+}
+
+BatchRunner::~BatchRunner()
+{
+	close();
+}
+
+QString BatchRunner::usage()
+{
+	return QObject::tr("Usage: makoureactor --batch <command> [arguments] [; <command> [arguments]]...\n"
+					   "Without command, one command per line is read from the standard input,\n"
+					   "arguments with spaces can be quoted with \"double\" or 'single' quotes.\n\n"
+					   "Commands:\n"
+					   "  open <path> [--ps|--pc]\n"
+					   "  search-text <regexp> [--case-sensitive]\n"
+					   "  search-opcode <id>\n"
+					   "  export <dir> [--fields[=dec]] [--backgrounds=png|jpg|bmp] [--akaos] [--texts=xml|txt] [--overwrite]\n"
+					   "  import <dir> [--sections=scripts,akaos,camera,walkmesh,models,encounter,inf,background] [--uncompressed]\n"
+					   "  compile\n"
+					   "  analyze-scripts\n"
+					   "  validate-walkmeshes\n"
+					   "  layout-texts [--all]\n"
+					   "  callers <field> <group> <script>\n"
+					   "  fields-leading-to <field>\n"
+					   "  route <from field> <to field>\n"
+					   "  save [path]\n"
+					   "  pack <source dir> <lgp>\n"
+					   "  extract <lgp|iso> <dir>\n"
+					   "  create-patch <base lgp|iso> <modified lgp|iso> <patch>\n"
+					   "  apply-patch <base lgp|iso> <patch> <destination>\n"
+					   "  close\n");
+}
+
+/*!
+ * Runs every command in order and stops at the first failure.
+ * Returns the process exit code.
+ */
+int BatchRunner::exec(const QStringList &arguments)
+{
+	QList<QStringList> commands;
+
+	if(arguments.isEmpty()) {
+		QTextStream in(stdin);
+		in.setCodec("UTF-8");
+		QString line;
+		while(!(line = in.readLine()).isNull()) {
+			QStringList command = splitLine(line);
+			if(!command.isEmpty() && !command.first().startsWith('#')) {
+				commands.append(command);
+			}
+		}
+	} else {
+		QStringList command;
+		foreach(const QString &arg, arguments) {
+			if(arg == ";") {
+				if(!command.isEmpty()) {
+					commands.append(command);
+				}
+				command.clear();
+			} else {
+				command.append(arg);
+			}
+		}
+		if(!command.isEmpty()) {
+			commands.append(command);
+		}
+	}
+
+	if(commands.isEmpty()) {
+		QTextStream(stderr) << usage();
+		return 2;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	int done = 0;
+	bool ok = true;
+
+	foreach(const QStringList &command, commands) {
+		if(!run(command)) {
+			ok = false;
+			break;
+		}
+		++done;
+	}
+
+	BatchJson summary;
+	summary.insert("command", "summary");
+	summary.insert("ok", ok);
+	summary.insert("commands", done);
+	summary.insert("elapsed", timer.elapsed());
+	print(summary);
+
+	return ok ? 0 : 1;
+}
+
+bool BatchRunner::run(const QStringList &command)
+{
+	BatchJson result;
+	result.insert("command", command.first());
+
+	QElapsedTimer timer;
+	timer.start();
+	bool ok;
+
+	Command function = _commands.value(command.first(), NULL);
+	if(function) {
+		ok = (this->*function)(command.mid(1), result);
+	} else {
+		ok = setError(result, QObject::tr("Unknown command"));
+	}
+
+	result.insert("ok", ok);
+	result.insert("elapsed", timer.elapsed());
+	print(result);
+
+	// No field is used between two commands
+	if(_fieldArchive) {
+		_fieldArchive->evictFields();
+	}
+
+	return ok;
+}
+
+void BatchRunner::print(const BatchJson &json)
+{
+	_out << json.toString() << "\n";
+	_out.flush();
+}
+
+void BatchRunner::close()
+{
+	if(_fieldArchive) {
+		_fieldArchive->close();
+		delete _fieldArchive;
+		_fieldArchive = NULL;
+	}
+}
+
+bool BatchRunner::setError(BatchJson &result, const QString &error)
+{
+	result.insert("error", error);
+	return false;
+}
+
+bool BatchRunner::checkArchive(BatchJson &result)
+{
+	if(!_fieldArchive) {
+		return setError(result, QObject::tr("No archive opened"));
+	}
+	return true;
+}
+
+/*!
+ * Returns the ID of the field named name in the opened archive,
+ * or -1 with an error in result.
+ */
+int BatchRunner::findField(const QString &name, BatchJson &result)
+{
+	int fieldID = _fieldArchive->indexOfField(name);
+	if(fieldID < 0) {
+		setError(result, QObject::tr("Field %1 not found").arg(name));
+	}
+	return fieldID;
+}
+
+BatchJson BatchRunner::mapJumpJson(const MapJumpEdge &edge) const
+{
+	BatchJson json;
+	json.insert("field", _fieldArchive->field(edge.fieldID, false)->name());
+	json.insert("group", edge.groupID);
+	json.insert("script", edge.scriptID);
+	json.insert("opcode", edge.opcodeID);
+	if(edge.targetFieldID >= 0) {
+		json.insert("target", _fieldArchive->field(edge.targetFieldID, false)->name());
+	}
+	return json;
+}
+
+/*!
+ * Splits "--key=value" options from positional arguments.
+ */
+QMap<QString, QString> BatchRunner::options(const QStringList &args, QStringList &positional)
+{
+	QMap<QString, QString> ret;
+
+	foreach(const QString &arg, args) {
+		if(arg.startsWith("--")) {
+			int index = arg.indexOf('=');
+			if(index < 0) {
+				ret.insert(arg.mid(2), QString());
+			} else {
+				ret.insert(arg.mid(2, index - 2), arg.mid(index + 1));
+			}
+		} else {
+			positional.append(arg);
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * Splits a line of the standard input on spaces and tabs.
+ * Quotes group an argument, backslashes are kept for Windows paths.
+ */
+QStringList BatchRunner::splitLine(const QString &line)
+{
+	QStringList ret;
+	QString arg;
+	QChar quote;
+	bool inArg = false;
+
+	for(int i=0 ; i<line.size() ; ++i) {
+		const QChar c = line.at(i);
+
+		if(!quote.isNull()) {
+			if(c == quote) {
+				quote = QChar();
+			} else {
+				arg.append(c);
+			}
+		} else if(c == '"' || c == '\'') {
+			quote = c;
+			inArg = true;
+		} else if(c.isSpace()) {
+			if(inArg) {
+				ret.append(arg);
+				arg.clear();
+				inArg = false;
+			}
+		} else {
+			arg.append(c);
+			inArg = true;
+		}
+	}
+
+	if(inArg) {
+		ret.append(arg);
+	}
+
+	return ret;
+}
+
+bool BatchRunner::isIso(const QString &path)
+{
+	QString ext = path.mid(path.lastIndexOf('.') + 1).toLower();
+	return ext == "iso" || ext == "bin" || ext == "img";
+}
+
+bool BatchRunner::observerWasCanceled() const
+{
+	return false;
+}
+
+void BatchRunner::setObserverMaximum(unsigned int max)
+{
+	Q_UNUSED(max)
+}
+
+void BatchRunner::setObserverValue(int value)
+{
+	Q_UNUSED(value)
+}
+
+bool BatchRunner::open(const QStringList &args, BatchJson &result)
+{
+	QStringList positional;
+	QMap<QString, QString> opts = options(args, positional);
+	if(positional.size() != 1) {
+		return setError(result, QObject::tr("Expected: open <path> [--ps|--pc]"));
+	}
+
+	close();
+
+	const QString &path = positional.first();
+	FieldArchiveIO::Type type;
+	bool isPS;
+
+	if(QFileInfo(path).isDir()) {
+		type = FieldArchiveIO::Dir;
+		isPS = opts.contains("ps");
+	} else {
+		QString ext = path.mid(path.lastIndexOf('.') + 1).toLower();
+
+		if(ext == "iso" || ext == "bin" || ext == "img") {
+			isPS = true;
+			type = FieldArchiveIO::Iso;
+		} else if(ext == "dat") {
+			isPS = true;
+			type = FieldArchiveIO::File;
+		} else if(ext == "lgp") {
+			isPS = false;
+			type = FieldArchiveIO::Lgp;
+		} else {
+			isPS = false;
+			type = FieldArchiveIO::File;
+		}
+	}
+
+	if(isPS) {
+		_fieldArchive = new FieldArchivePS(path, type);
+	} else {
+		_fieldArchive = new FieldArchivePC(path, type);
+	}
+	_fieldArchive->setObserver(this);
+
+	result.insert("path", path);
+	result.insert("platform", isPS ? "ps" : "pc");
+
+	FieldArchiveIO::ErrorCode error = _fieldArchive->open();
+	if(error != FieldArchiveIO::Ok) {
+		close();
+		return setError(result, errorString(error));
+	}
+
+	result.insert("fields", _fieldArchive->size());
+
+	return true;
+}
+
+bool BatchRunner::searchText(const QStringList &args, BatchJson &result)
+{
+	QStringList positional;
+	QMap<QString, QString> opts = options(args, positional);
+	if(positional.isEmpty()) {
+		return setError(result, QObject::tr("Expected: search-text <regexp> [--case-sensitive]"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QRegExp text(positional.join(" "), opts.contains("case-sensitive")
+				 ? Qt::CaseSensitive : Qt::CaseInsensitive);
+	if(!text.isValid()) {
+		return setError(result, text.errorString());
+	}
+
+	QList<BatchJson> matches;
+	int fieldID = -1, textID = -1, from = 0, size;
+
+	while(_fieldArchive->searchText(text, fieldID, textID, from, size,
+									FieldArchive::SortByName, FieldArchive::GlobalScope)) {
+		BatchJson match;
+		match.insert("field", _fieldArchive->field(fieldID, false)->name());
+		match.insert("text", textID);
+		match.insert("from", from);
+		match.insert("size", size);
+		matches.append(match);
+		from += qMax(size, 1);
+	}
+
+	result.insert("count", matches.size());
+	result.insert("matches", matches);
+
+	return true;
+}
+
+bool BatchRunner::searchOpcode(const QStringList &args, BatchJson &result)
+{
+	bool ok = args.size() == 1;
+	int opcode = ok ? args.first().toInt(&ok, 0) : 0;
+	if(!ok || opcode < 0 || opcode > 0xFF) {
+		return setError(result, QObject::tr("Expected: search-opcode <id>"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QList<BatchJson> matches;
+	int fieldID = -1, groupID = -1, scriptID = -1, opcodeID = -1;
+
+	while(_fieldArchive->searchOpcode(opcode, fieldID, groupID, scriptID, ++opcodeID,
+									  FieldArchive::SortByName, FieldArchive::GlobalScope)) {
+		BatchJson match;
+		match.insert("field", _fieldArchive->field(fieldID, false)->name());
+		match.insert("group", groupID);
+		match.insert("script", scriptID);
+		match.insert("opcode", opcodeID);
+		matches.append(match);
+	}
+
+	result.insert("count", matches.size());
+	result.insert("matches", matches);
+
+	return true;
+}
+
+bool BatchRunner::exportation(const QStringList &args, BatchJson &result)
+{
+	QStringList positional;
+	QMap<QString, QString> opts = options(args, positional);
+	if(positional.size() != 1) {
+		return setError(result, QObject::tr("Expected: export <dir> [options]"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QMap<FieldArchive::ExportType, QString> toExport;
+	if(opts.contains("fields")) {
+		QString format = opts.value("fields");
+		toExport.insert(FieldArchive::Fields, format.isEmpty() && _fieldArchive->isPS()
+						? QString("DAT") : format);
+	}
+	if(opts.contains("backgrounds")) {
+		QString format = opts.value("backgrounds").isEmpty() ? QString("png") : opts.value("backgrounds");
+		toExport.insert(FieldArchive::Backgrounds, format);
+	}
+	if(opts.contains("akaos")) {
+		toExport.insert(FieldArchive::Akaos, "akao");
+	}
+	if(opts.contains("texts")) {
+		QString format = opts.value("texts").isEmpty() ? QString("xml") : opts.value("texts");
+		if(format != "xml" && format != "txt") {
+			return setError(result, QObject::tr("Unknown text format"));
+		}
+		toExport.insert(FieldArchive::Texts, format);
+	}
+	if(toExport.isEmpty()) {
+		return setError(result, QObject::tr("Nothing to export"));
+	}
+
+	QDir dir(positional.first());
+	if(!dir.mkpath(".")) {
+		return setError(result, QObject::tr("Cannot create the directory %1").arg(dir.path()));
+	}
+
+	QList<int> selectedFields;
+	for(int fieldID = 0 ; fieldID < _fieldArchive->size() ; ++fieldID) {
+		selectedFields.append(fieldID);
+	}
+
+	result.insert("directory", dir.absolutePath());
+	result.insert("fields", selectedFields.size());
+
+	if(!_fieldArchive->exportation(selectedFields, dir.absolutePath(),
+								   opts.contains("overwrite"), toExport)) {
+		return setError(result, QObject::tr("An error occurred when exporting"));
+	}
+
+	return true;
+}
+
+/*!
+ * Imports every field file found in the directory, named like
+ * the ones written by "export --fields".
+ */
+bool BatchRunner::importation(const QStringList &args, BatchJson &result)
+{
+	QStringList positional;
+	QMap<QString, QString> opts = options(args, positional);
+	if(positional.size() != 1) {
+		return setError(result, QObject::tr("Expected: import <dir> [options]"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QMap<QString, Field::FieldSection> sectionNames;
+	sectionNames.insert("scripts", Field::Scripts);
+	sectionNames.insert("akaos", Field::Akaos);
+	sectionNames.insert("camera", Field::Camera);
+	sectionNames.insert("walkmesh", Field::Walkmesh);
+	sectionNames.insert("models", Field::ModelLoader);
+	sectionNames.insert("encounter", Field::Encounter);
+	sectionNames.insert("inf", Field::Inf);
+	sectionNames.insert("background", Field::Background);
+
+	Field::FieldSections parts;
+	QString sections = opts.value("sections", "scripts");
+	foreach(const QString &section, sections.split(',', QString::SkipEmptyParts)) {
+		if(!sectionNames.contains(section)) {
+			return setError(result, QObject::tr("Unknown section %1").arg(section));
+		}
+		parts |= sectionNames.value(section);
+	}
+	if(parts == 0) {
+		return setError(result, QObject::tr("Nothing to import"));
+	}
+
+	QDir dir(positional.first());
+	if(!dir.exists()) {
+		return setError(result, QObject::tr("Directory '%1' not found").arg(dir.path()));
+	}
+
+	bool isDat = _fieldArchive->isPS(),
+	     compressed = !opts.contains("uncompressed");
+	QStringList imported;
+	QList<BatchJson> errors;
+
+	for(int fieldID = 0 ; fieldID < _fieldArchive->size() ; ++fieldID) {
+		Field *field = _fieldArchive->field(fieldID, false);
+		if(!field) {
+			continue;
+		}
+
+		QString fileName = field->name();
+		if(!compressed) {
+			fileName.append(".dec");
+		} else if(isDat) {
+			fileName.append(".DAT");
+		}
+		QString path = dir.filePath(fileName);
+		if(!QFile::exists(path)) {
+			continue;
+		}
+
+		field = _fieldArchive->field(fieldID);
+		if(!field) {
+			continue;
+		}
+
+		// The PS background is in the MIM file next to the DAT file
+		QFile addDevice;
+		if(isDat && parts.testFlag(Field::Background)) {
+			QStringList mimFiles = dir.entryList(QStringList(field->name() + ".MIM"), QDir::Files);
+			if(mimFiles.isEmpty()) {
+				BatchJson error;
+				error.insert("field", field->name());
+				error.insert("error", QObject::tr("MIM file not found"));
+				errors.append(error);
+				continue;
+			}
+			addDevice.setFileName(dir.filePath(mimFiles.first()));
+		}
+
+		if(field->importer(path, isDat, compressed, parts, &addDevice) == 0) {
+			field->setModified(true);
+			imported.append(field->name());
+		} else {
+			BatchJson error;
+			error.insert("field", field->name());
+			error.insert("error", QObject::tr("Invalid file"));
+			errors.append(error);
+		}
+	}
+
+	result.insert("count", imported.size());
+	result.insert("errors", errors);
+
+	return errors.isEmpty();
+}
+
+/*!
+ * Compiles the scripts of the opened fields, like the ones
+ * modified by import or visited by a search.
+ */
+bool BatchRunner::compile(const QStringList &args, BatchJson &result)
+{
+	if(!args.isEmpty()) {
+		return setError(result, QObject::tr("Expected: compile"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QList<FieldCompileReport> reports;
+	bool ok = _fieldArchive->compileScripts(reports);
+
+	QList<BatchJson> errors;
+	qint64 compileTime = 0;
+
+	foreach(const FieldCompileReport &report, reports) {
+		compileTime += report.elapsed;
+		QString name = _fieldArchive->field(report.fieldID, false)->name();
+
+		foreach(const ScriptCompileError &error, report.errors) {
+			BatchJson json;
+			json.insert("field", name);
+			json.insert("group", error.groupID);
+			json.insert("script", error.scriptID);
+			json.insert("opcode", error.opcodeID);
+			json.insert("error", error.errorStr);
+			errors.append(json);
+		}
+	}
+
+	result.insert("fields", reports.size());
+	result.insert("compileTime", compileTime);
+	result.insert("errors", errors);
+
+	return ok;
+}
+
+/*!
+ * Lists the dead code, the invalid jumps and the vars
+ * read by a script but never written.
+ */
+bool BatchRunner::analyzeScripts(const QStringList &args, BatchJson &result)
+{
+	if(!args.isEmpty()) {
+		return setError(result, QObject::tr("Expected: analyze-scripts"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QList<ScriptIssue> issues;
+	_fieldArchive->analyzeScripts(issues);
+
+	QList<BatchJson> matches;
+
+	foreach(const ScriptIssue &issue, issues) {
+		BatchJson json;
+		json.insert("field", _fieldArchive->field(issue.fieldID, false)->name());
+		json.insert("group", issue.groupID);
+		json.insert("script", issue.scriptID);
+		json.insert("opcode", issue.opcodeID);
+		switch(issue.type) {
+		case ScriptIssue::DeadCode:
+			json.insert("issue", "dead-code");
+			break;
+		case ScriptIssue::BadJump:
+			json.insert("issue", "bad-jump");
+			break;
+		case ScriptIssue::UninitializedVar:
+			json.insert("issue", "uninitialized-var");
+			json.insert("bank", int(issue.var.bank));
+			json.insert("address", int(issue.var.address));
+			break;
+		}
+		matches.append(json);
+	}
+
+	result.insert("count", matches.size());
+	result.insert("issues", matches);
+
+	return true;
+}
+
+/*!
+ * Lists the walkmesh triangles with broken geometry or accesses.
+ */
+bool BatchRunner::validateWalkmeshes(const QStringList &args, BatchJson &result)
+{
+	if(!args.isEmpty()) {
+		return setError(result, QObject::tr("Expected: validate-walkmeshes"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QList<WalkmeshIssue> issues;
+	_fieldArchive->validateWalkmeshes(issues);
+
+	QList<BatchJson> errors;
+
+	foreach(const WalkmeshIssue &issue, issues) {
+		BatchJson json;
+		json.insert("field", _fieldArchive->field(issue.fieldID, false)->name());
+		json.insert("triangle", issue.triangleID);
+		json.insert("edge", issue.edge);
+		switch(issue.type) {
+		case WalkmeshError::DegeneratedTriangle:
+			json.insert("error", "degenerated-triangle");
+			break;
+		case WalkmeshError::InvalidAccess:
+			json.insert("error", "invalid-access");
+			break;
+		case WalkmeshError::UnsharedAccess:
+			json.insert("error", "unshared-access");
+			break;
+		case WalkmeshError::AsymmetricAccess:
+			json.insert("error", "asymmetric-access");
+			break;
+		case WalkmeshError::NonManifoldEdge:
+			json.insert("error", "non-manifold-edge");
+			break;
+		}
+		errors.append(json);
+	}
+
+	result.insert("count", errors.size());
+	result.insert("errors", errors);
+
+	return true;
+}
+
+/*!
+ * Lists the text windows too small for their text,
+ * or every text window with --all.
+ */
+bool BatchRunner::layoutTexts(const QStringList &args, BatchJson &result)
+{
+	QStringList positional;
+	QMap<QString, QString> opts = options(args, positional);
+	if(!positional.isEmpty()) {
+		return setError(result, QObject::tr("Expected: layout-texts [--all]"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QList<TextWindowLayout> layouts;
+	_fieldArchive->layoutTexts(layouts);
+
+	QList<BatchJson> windows;
+	int overflowCount = 0;
+
+	foreach(const TextWindowLayout &layout, layouts) {
+		const bool overflowing = layout.isOverflowing();
+		if(overflowing) {
+			++overflowCount;
+		} else if(!opts.contains("all")) {
+			continue;
+		}
+
+		BatchJson json;
+		json.insert("field", _fieldArchive->field(layout.fieldID, false)->name());
+		json.insert("text", layout.textID);
+		json.insert("group", int(layout.window.groupID));
+		json.insert("script", int(layout.window.scriptID));
+		json.insert("opcode", int(layout.window.opcodeID));
+		json.insert("width", int(layout.window.w));
+		json.insert("height", int(layout.window.h));
+		json.insert("requiredWidth", layout.requiredSize.width());
+		json.insert("requiredHeight", layout.requiredSize.height());
+		json.insert("overflowing", overflowing);
+		windows.append(json);
+	}
+
+	result.insert("count", overflowCount);
+	result.insert("windows", windows);
+
+	return true;
+}
+
+/*!
+ * Lists the REQ, REQSW and REQEW opcodes calling a group script.
+ */
+bool BatchRunner::callers(const QStringList &args, BatchJson &result)
+{
+	bool okGroup = args.size() == 3, okScript = okGroup;
+	int groupID = okGroup ? args.at(1).toInt(&okGroup) : 0,
+	    scriptID = okScript ? args.at(2).toInt(&okScript) : 0;
+	if(!okGroup || !okScript) {
+		return setError(result, QObject::tr("Expected: callers <field> <group> <script>"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+	int id = findField(args.first(), result);
+	if(id < 0) {
+		return false;
+	}
+
+	QList<BatchJson> matches;
+
+	foreach(const ExecEdge &edge, _fieldArchive->scriptGraph().callers(id, groupID, scriptID)) {
+		BatchJson match;
+		match.insert("group", edge.groupID);
+		match.insert("script", edge.scriptID);
+		match.insert("opcode", edge.opcodeID);
+		matches.append(match);
+	}
+
+	result.insert("count", matches.size());
+	result.insert("matches", matches);
+
+	return true;
+}
+
+/*!
+ * Lists the MAPJUMP and MINIGAME opcodes going to a field.
+ */
+bool BatchRunner::fieldsLeadingTo(const QStringList &args, BatchJson &result)
+{
+	if(args.size() != 1) {
+		return setError(result, QObject::tr("Expected: fields-leading-to <field>"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+	int id = findField(args.first(), result);
+	if(id < 0) {
+		return false;
+	}
+
+	QList<BatchJson> matches;
+
+	foreach(const MapJumpEdge &edge, _fieldArchive->scriptGraph().mapJumpsTo(id)) {
+		matches.append(mapJumpJson(edge));
+	}
+
+	result.insert("fields", _fieldArchive->scriptGraph().fieldsLeadingTo(id).size());
+	result.insert("matches", matches);
+
+	return true;
+}
+
+/*!
+ * Lists the map jumps of the shortest route between two fields.
+ */
+bool BatchRunner::route(const QStringList &args, BatchJson &result)
+{
+	if(args.size() != 2) {
+		return setError(result, QObject::tr("Expected: route <from field> <to field>"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+	int fromID = findField(args.first(), result);
+	if(fromID < 0) {
+		return false;
+	}
+	int toID = findField(args.at(1), result);
+	if(toID < 0) {
+		return false;
+	}
+
+	QList<BatchJson> steps;
+
+	foreach(const MapJumpEdge &edge, _fieldArchive->scriptGraph().shortestRoute(fromID, toID)) {
+		steps.append(mapJumpJson(edge));
+	}
+
+	if(steps.isEmpty() && fromID != toID) {
+		return setError(result, QObject::tr("No route found"));
+	}
+
+	result.insert("steps", steps);
+
+	return true;
+}
+
+bool BatchRunner::save(const QStringList &args, BatchJson &result)
+{
+	if(args.size() > 1) {
+		return setError(result, QObject::tr("Expected: save [path]"));
+	}
+	if(!checkArchive(result)) {
+		return false;
+	}
+
+	QString path = args.isEmpty() ? QString() : args.first();
+	FieldArchiveIO::ErrorCode error = _fieldArchive->save(path);
+	if(error != FieldArchiveIO::Ok) {
+		return setError(result, errorString(error));
+	}
+
+	result.insert("path", path.isEmpty() ? _fieldArchive->io()->path() : path);
+
+	return true;
+}
+
+bool BatchRunner::pack(const QStringList &args, BatchJson &result)
+{
+	if(args.size() != 2) {
+		return setError(result, QObject::tr("Expected: pack <source dir> <lgp>"));
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	Lgp lgp(args.at(1));
+	if(!lgp.packDirectory(args.first(), QString(), this)) {
+		return setError(result, lgp.errorString());
+	}
+
+	qint64 size = QFileInfo(args.at(1)).size(), elapsed = timer.elapsed();
+
+	result.insert("files", lgp.fileCount());
+	result.insert("bytes", size);
+	result.insert("throughput", elapsed > 0 ? size / 1048.576 / elapsed : 0.0);
+
+	return true;
+}
+
+bool BatchRunner::extract(const QStringList &args, BatchJson &result)
+{
+	if(args.size() != 2) {
+		return setError(result, QObject::tr("Expected: extract <lgp|iso> <dir>"));
+	}
+
+	const QString &path = args.first(), &destination = args.at(1);
+
+	if(isIso(path)) {
+		IsoArchive iso(path);
+		if(!iso.open(QIODevice::ReadOnly)) {
+			return setError(result, iso.errorString());
+		}
+		if(!iso.extractAll(destination, this)) {
+			return setError(result, QObject::tr("Cannot extract %1").arg(path));
+		}
+	} else {
+		Lgp lgp(path);
+		if(!lgp.open()) {
+			return setError(result, lgp.errorString());
+		}
+		if(!lgp.extractAll(destination, this)) {
+			return setError(result, lgp.errorString());
+		}
+		result.insert("files", lgp.fileCount());
+	}
+
+	return true;
+}
+
+/*!
+ * Writes the differences between two LGP archives or two disc images.
+ */
+bool BatchRunner::createPatch(const QStringList &args, BatchJson &result)
+{
+	if(args.size() != 3) {
+		return setError(result, QObject::tr("Expected: create-patch <base lgp|iso> <modified lgp|iso> <patch>"));
+	}
+
+	const QString &basePath = args.first(), &modifiedPath = args.at(1),
+	        &patchPath = args.at(2);
+
+	if(isIso(basePath)) {
+		if(!IsoArchive::createPatch(basePath, modifiedPath, patchPath, this)) {
+			return setError(result, QObject::tr("Cannot create the patch %1").arg(patchPath));
+		}
+	} else {
+		Lgp base(basePath), modified(modifiedPath);
+		if(!base.open()) {
+			return setError(result, base.errorString());
+		}
+		if(!modified.open()) {
+			return setError(result, modified.errorString());
+		}
+
+		// The modified archive is replayed as pending changes of the base
+		foreach(const QString &filePath, modified.fileList()) {
+			QByteArray data = modified.fileData(filePath);
+			if(!base.fileExists(filePath)) {
+				base.addFileData(filePath, data);
+			} else if(base.fileData(filePath) != data) {
+				base.setFileData(filePath, data);
+			}
+		}
+		foreach(const QString &filePath, base.fileList()) {
+			if(!modified.fileExists(filePath)) {
+				base.removeFile(filePath);
+			}
+		}
+
+		if(!base.createPatch(patchPath)) {
+			return setError(result, base.errorString());
+		}
+	}
+
+	result.insert("bytes", QFileInfo(patchPath).size());
+
+	return true;
+}
+
+/*!
+ * Writes into destination the base LGP archive or disc image
+ * modified by a patch made by create-patch.
+ */
+bool BatchRunner::applyPatch(const QStringList &args, BatchJson &result)
+{
+	if(args.size() != 3) {
+		return setError(result, QObject::tr("Expected: apply-patch <base lgp|iso> <patch> <destination>"));
+	}
+
+	const QString &basePath = args.first(), &patchPath = args.at(1),
+	        &destination = args.at(2);
+
+	if(isIso(basePath)) {
+		if(!IsoArchive::applyPatch(basePath, patchPath, destination, this)) {
+			return setError(result, QObject::tr("Cannot apply the patch %1").arg(patchPath));
+		}
+	} else {
+		Lgp base(basePath);
+		if(!base.open()) {
+			return setError(result, base.errorString());
+		}
+		if(!base.applyPatch(patchPath, destination, this)) {
+			return setError(result, base.errorString());
+		}
+		result.insert("files", base.fileCount());
+	}
+
+	result.insert("path", destination);
+
+	return true;
+}
+
+bool BatchRunner::closeCommand(const QStringList &args, BatchJson &result)
+{
+	Q_UNUSED(args)
+	Q_UNUSED(result)
+
+	close();
+
+	return true;
+}
+
+QString BatchRunner::errorString(FieldArchiveIO::ErrorCode error)
+{
+	switch(error)
+	{
+	case FieldArchiveIO::Ok:
+		break;
+	case FieldArchiveIO::Aborted:
+		return QObject::tr("Aborted");
+	case FieldArchiveIO::FieldNotFound:
+		return QObject::tr("Nothing found!");
+	case FieldArchiveIO::FieldExists:
+		return QObject::tr("The file already exists");
+	case FieldArchiveIO::ErrorOpening:
+		return QObject::tr("The file is inaccessible");
+	case FieldArchiveIO::ErrorOpeningTemp:
+		return QObject::tr("Can not create temporary file");
+	case FieldArchiveIO::ErrorRemoving:
+		return QObject::tr("Unable to remove the file, check write permissions.");
+	case FieldArchiveIO::ErrorRenaming:
+		return QObject::tr("Unable to rename the file, check write permissions.");
+	case FieldArchiveIO::ErrorCopying:
+		return QObject::tr("Unable to copy the file, check write permissions.");
+	case FieldArchiveIO::Invalid:
+		return QObject::tr("Invalid archive");
+	case FieldArchiveIO::NotImplemented:
+		return QObject::tr("This error should not appear, thank you for reporting it");
+	}
+	return QString();
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QtCore>
+#include "core/field/FieldArchive.h"
+
+/*!
+ * Minimal JSON object writer, QJsonDocument is not available in Qt 4.
+ */
+class BatchJson
+{
+public:
+	BatchJson() {}
+	void insert(const QString &key, const QString &value);
+	void insert(const QString &key, const char *value);
+	void insert(const QString &key, qint64 value);
+	void insert(const QString &key, int value);
+	void insert(const QString &key, double value);
+	void insert(const QString &key, bool value);
+	void insert(const QString &key, const BatchJson &value);
+	void insert(const QString &key, const QList<BatchJson> &values);
+	QString toString() const;
+	static QString quote(const QString &str);
+private:
+	void insertRaw(const QString &key, const QString &json);
+	QStringList _members;
+};
+
+/*!
+ * Runs archive operations without any widget and prints
+ * one JSON object per command on the standard output.
+ */
+class BatchRunner : public ArchiveObserver
+{
+public:
+	BatchRunner();
+	virtual ~BatchRunner();
+	int exec(const QStringList &arguments);
+	static QString usage();
+
+	bool observerWasCanceled() const;
+	void setObserverMaximum(unsigned int max);
+	void setObserverValue(int value);
+private:
+	typedef bool (BatchRunner::*Command)(const QStringList &, BatchJson &);
+
+	bool run(const QStringList &command);
+	void print(const BatchJson &json);
+	void close();
+	bool setError(BatchJson &result, const QString &error);
+	bool checkArchive(BatchJson &result);
+	int findField(const QString &name, BatchJson &result);
+	BatchJson mapJumpJson(const MapJumpEdge &edge) const;
+	static QMap<QString, QString> options(const QStringList &args, QStringList &positional);
+	static QStringList splitLine(const QString &line);
+	static bool isIso(const QString &path);
+
+	bool open(const QStringList &args, BatchJson &result);
+	bool searchText(const QStringList &args, BatchJson &result);
+	bool searchOpcode(const QStringList &args, BatchJson &result);
+	bool exportation(const QStringList &args, BatchJson &result);
+	bool importation(const QStringList &args, BatchJson &result);
+	bool compile(const QStringList &args, BatchJson &result);
+	bool analyzeScripts(const QStringList &args, BatchJson &result);
+	bool validateWalkmeshes(const QStringList &args, BatchJson &result);
+	bool layoutTexts(const QStringList &args, BatchJson &result);
+	bool callers(const QStringList &args, BatchJson &result);
+	bool fieldsLeadingTo(const QStringList &args, BatchJson &result);
+	bool route(const QStringList &args, BatchJson &result);
+	bool save(const QStringList &args, BatchJson &result);
+	bool pack(const QStringList &args, BatchJson &result);
+	bool extract(const QStringList &args, BatchJson &result);
+	bool createPatch(const QStringList &args, BatchJson &result);
+	bool applyPatch(const QStringList &args, BatchJson &result);
+	bool closeCommand(const QStringList &args, BatchJson &result);
+
+	static QString errorString(FieldArchiveIO::ErrorCode error);
+
+	QMap<QString, Command> _commands;
+	FieldArchive *_fieldArchive;
+	QTextStream _out;
+};
+
+#endif // BATCHRUNNER_H
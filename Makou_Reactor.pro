@@ -79,6 +79,7 @@ HEADERS += \
     core/GZIP.h \
     core/GZIPPS.h \
     core/FF7Text.h \
+    core/FF7TextLayout.h \
     core/FF7Font.h \
     core/Config.h \
     core/field/TutFile.h \
@@ -150,7 +151,14 @@ HEADERS += \
     core/AkaoIO.h \
     core/Akao.h \
     core/Clipboard.h \
-    widgets/ModelColorsLayout.h
+    widgets/ModelColorsLayout.h \
+    core/field/FieldModelMesh.h \
+    core/field/WalkmeshGrid.h \
+    core/field/FieldArchiveJob.h \
+    core/field/ScriptAnalysis.h \
+    core/field/ScriptGraph.h \
+    core/ArchiveExtractor.h \
+    BatchRunner.h
 
 SOURCES += \
     Window.cpp \
@@ -218,6 +226,7 @@ SOURCES += \
     core/GZIP.cpp \
     core/GZIPPS.cpp \
     core/FF7Text.cpp \
+    core/FF7TextLayout.cpp \
     core/FF7Font.cpp \
     core/Config.cpp \
     core/field/TutFile.cpp \
@@ -289,7 +298,14 @@ SOURCES += \
     core/AkaoIO.cpp \
     core/Akao.cpp \
     core/Clipboard.cpp \
-    widgets/ModelColorsLayout.cpp
+    widgets/ModelColorsLayout.cpp \
+    core/field/FieldModelMesh.cpp \
+    core/field/WalkmeshGrid.cpp \
+    core/field/FieldArchiveJob.cpp \
+    core/field/ScriptAnalysis.cpp \
+    core/field/ScriptGraph.cpp \
+    core/ArchiveExtractor.cpp \
+    BatchRunner.cpp
 
 TRANSLATIONS += Makou_Reactor_fr.ts  \
     Makou_Reactor_ja.ts
@@ -67,6 +67,7 @@ Window::Window() :
 	menu->addMenu(_recentMenu);
 	actionSave = menu->addAction(QApplication::style()->standardIcon(QStyle::SP_DialogSaveButton), tr("&Save"), this, SLOT(save()), QKeySequence("Ctrl+S"));
 	actionSaveAs = menu->addAction(tr("Save &As..."), this, SLOT(saveAs()), QKeySequence("Shift+Ctrl+S"));
+	actionReload = menu->addAction(tr("Re&load Changed Files"), this, SLOT(reloadChangedFields()), QKeySequence::Refresh);
 	actionExport = menu->addAction(tr("&Export the current field..."), this, SLOT(exporter()), QKeySequence("Ctrl+E"));
 	actionMassExport = menu->addAction(tr("&Mass Export..."), this, SLOT(massExport()), QKeySequence("Shift+Ctrl+E"));
 	actionImport = menu->addAction(tr("&Import the current field..."), this, SLOT(importer()), QKeySequence("Ctrl+I"));
@@ -94,6 +95,7 @@ Window::Window() :
 	menu->addAction(tr("Variable Mana&ger..."), this, SLOT(varManager()), QKeySequence("Ctrl+G"));
 	actionFind = menu->addAction(QIcon(":/images/find.png"), tr("&Find..."), this, SLOT(searchManager()), QKeySequence::Find);
 	actionMiscOperations = menu->addAction(tr("Miscellaneous Oper&ations..."), this, SLOT(miscOperations()));
+	actionAnalyzeScripts = menu->addAction(tr("Anal&yze Scripts..."), this, SLOT(analyzeScripts()));
 	//menu->addAction(tr("&Police de caractères..."), this, SLOT(fontManager()), QKeySequence("Ctrl+P"));
 
 	/* "Settings" Menu */
@@ -202,6 +204,14 @@ Window::Window() :
 	connect(_scriptManager, SIGNAL(editText(int)), SLOT(textManager(int)));
 	connect(_scriptManager, SIGNAL(changed()), SLOT(setModified()));
 
+	// Directories are watched to reload the fields edited by other programs
+	fileWatcher = new QFileSystemWatcher(this);
+	reloadTimer = new QTimer(this);
+	reloadTimer->setSingleShot(true);
+	reloadTimer->setInterval(500);
+	connect(fileWatcher, SIGNAL(directoryChanged(QString)), SLOT(notifyDirectoryChanged()));
+	connect(reloadTimer, SIGNAL(timeout()), SLOT(reloadChangedFields()));
+
 	fieldList->sortItems(Config::value("fieldListSortColumn").toInt(),
 	                     Qt::SortOrder(Config::value("fieldListSortOrder").toBool()));
 
@@ -214,6 +224,12 @@ Window::Window() :
 Window::~Window()
 {
 	Config::flush();
+	// Dialogs are destroyed after this window
+	foreach(QObject *holder, heldFields.keys()) {
+		if(holder != this) {
+			disconnect(holder, SIGNAL(destroyed(QObject*)), this, SLOT(releaseField(QObject*)));
+		}
+	}
 	if(fieldArchive) {
 		fieldArchive->close();
 	}
@@ -230,6 +246,19 @@ QProgressDialog *Window::progressDialog()
 	return _progressDialog;
 }
 
+/*!
+ * Files modified in place do not always change their directory,
+ * so the stamps are checked again when the window is activated.
+ */
+void Window::changeEvent(QEvent *event)
+{
+	if(event->type() == QEvent::ActivationChange && isActiveWindow()
+	        && actionReload->isEnabled()) {
+		reloadTimer->start();
+	}
+	QMainWindow::changeEvent(event);
+}
+
 void Window::closeEvent(QCloseEvent *event)
 {
 	if(!isEnabled() || closeFile(true) == QMessageBox::Cancel) {
@@ -371,11 +400,17 @@ int Window::closeFile(bool quit)
 			varDialog->setFieldArchive(NULL);
 		}
 
+		reloadTimer->stop();
+		if(!fileWatcher->directories().isEmpty()) {
+			fileWatcher->removePaths(fileWatcher->directories());
+		}
+
 		if(fieldArchive != NULL) {
 			delete fieldArchive;
 			fieldArchive = NULL;
 		}
 		field = NULL;
+		heldFields.clear();
 
 		fieldList->blockSignals(true);
 		fieldList->clear();
@@ -395,6 +430,7 @@ int Window::closeFile(bool quit)
 
 		actionSave->setEnabled(false);
 		actionSaveAs->setEnabled(false);
+		actionReload->setEnabled(false);
 		actionExport->setEnabled(false);
 		actionMassExport->setEnabled(false);
 //		actionMassImport->setEnabled(false);
@@ -405,6 +441,7 @@ int Window::closeFile(bool quit)
 		actionEncounter->setEnabled(false);
 		actionMisc->setEnabled(false);
 		actionMiscOperations->setEnabled(false);
+		actionAnalyzeScripts->setEnabled(false);
 	}
 
 	return QMessageBox::Yes;
@@ -521,7 +558,10 @@ void Window::setObserverMaximum(unsigned int max)
 
 void Window::setObserverValue(int value)
 {
-	QApplication::processEvents();
+	// The modal progress dialog blocks the other inputs
+	QApplication::processEvents(progressDialog()->isVisible()
+	                            ? QEventLoop::AllEvents
+	                            : QEventLoop::ExcludeUserInputEvents);
 
 	taskBarButton->setValue(value);
 	progressDialog()->setValue(value);
@@ -633,6 +673,7 @@ void Window::open(const QString &filePath, FieldArchiveIO::Type type, bool isPS)
 		actionEncounter->setEnabled(true);
 		actionMisc->setEnabled(true);
 		actionMiscOperations->setEnabled(true);
+		actionAnalyzeScripts->setEnabled(true);
 		actionExport->setEnabled(true);
 		actionMassExport->setEnabled(true);
 //		actionMassImport->setEnabled(true);
@@ -644,6 +685,10 @@ void Window::open(const QString &filePath, FieldArchiveIO::Type type, bool isPS)
 	}
 	actionSaveAs->setEnabled(true);
 	actionClose->setEnabled(true);
+	if(fieldArchive->io()->type() == FieldArchiveIO::Dir) {
+		fileWatcher->addPath(fieldArchive->io()->path());
+		actionReload->setEnabled(true);
+	}
 
 #ifdef DEBUG_FUNCTIONS
 	//FieldArchivePC otherArch("", FieldArchiveIO::Lgp);
@@ -796,6 +841,8 @@ void Window::openField(bool reload)
 
 	// Get and set field
 	field = fieldArchive->field(fieldId, true, true);
+	// The edited field must stay in memory
+	holdField(this, field);
 	if(!field) {
 		disableEditors();
 		return;
@@ -808,10 +855,12 @@ void Window::openField(bool reload)
 		//}
 	}
 	if(_textDialog && (reload || _textDialog->isVisible())) {
+		holdField(_textDialog, field);
 		_textDialog->setField(field, reload);
 		_textDialog->setEnabled(true);
 	}
 	if(_modelManager && (reload || _modelManager->isVisible())) {
+		holdField(_modelManager, field);
 		_modelManager->fill(field, reload);
 		_modelManager->setEnabled(true);
 	}
@@ -820,14 +869,17 @@ void Window::openField(bool reload)
 		if(fieldArchive->isPC()) {
 			tutPC = static_cast<FieldArchivePC *>(fieldArchive)->tut(field->name());
 		}
+		holdField(_tutManager, field);
 		_tutManager->fill(field, tutPC, reload);
 		_tutManager->setEnabled(true);
 	}
 	if(_walkmeshManager && (reload || _walkmeshManager->isVisible())) {
+		holdField(_walkmeshManager, field);
 		_walkmeshManager->fill(field, reload);
 		_walkmeshManager->setEnabled(true);
 	}
 	if(_backgroundManager && (reload || _backgroundManager->isVisible())) {
+		holdField(_backgroundManager, field);
 		_backgroundManager->fill(field, reload);
 		_backgroundManager->setEnabled(true);
 	}
@@ -853,6 +905,9 @@ void Window::openField(bool reload)
 	}
 
 	searchDialog->updateRunSearch();
+
+	// Widgets do not use the previous field anymore
+	fieldArchive->evictFields();
 }
 
 void Window::showModel(int grpScriptID)
@@ -875,6 +930,39 @@ void Window::showModel(int grpScriptID)
 	zonePreview->setCurrentIndex(0);
 }
 
+/*!
+ * Pins the field shown by the holder widget and unpins its previous field,
+ * fields used by a widget are never closed to save memory.
+ */
+void Window::holdField(QObject *holder, Field *field)
+{
+	if(!fieldArchive || heldFields.value(holder) == field) {
+		return;
+	}
+
+	Field *previous = heldFields.value(holder);
+	if(field) {
+		fieldArchive->pinField(field);
+		heldFields.insert(holder, field);
+		if(holder != this) {
+			connect(holder, SIGNAL(destroyed(QObject*)), SLOT(releaseField(QObject*)), Qt::UniqueConnection);
+		}
+	} else {
+		heldFields.remove(holder);
+	}
+	if(previous) {
+		fieldArchive->unpinField(previous);
+	}
+}
+
+void Window::releaseField(QObject *holder)
+{
+	Field *previous = heldFields.take(holder);
+	if(fieldArchive && previous) {
+		fieldArchive->unpinField(previous);
+	}
+}
+
 void Window::showModel(Field *field, FieldModelFile *fieldModelFile)
 {
 	if(fieldModel && this->field == field) {
@@ -912,23 +1000,53 @@ void Window::saveAs(bool currentPath)
 {
 	if(!fieldArchive) return;
 
-	int fieldID, groupID, scriptID, opcodeID;
-	QString errorStr;
+	QList<FieldCompileReport> reports;
 
 	setEnabled(false);
-	bool compiled = fieldArchive->compileScripts(fieldID, groupID, scriptID, opcodeID, errorStr);
+	bool compiled = fieldArchive->compileScripts(reports);
 	setEnabled(true);
 
 	if(!compiled) {
-		QMessageBox::warning(this, tr("Compilation Error"), tr("Error Compiling Scripts:\n"
-																   "scene %1 (%2), group %3 (%4), script %5, line %6: %7")
-							 .arg(fieldArchive->field(fieldID)->name())
-							 .arg(fieldID)
-							 .arg(fieldArchive->field(fieldID)->scriptsAndTexts()->grpScript(groupID)->name())
-							 .arg(groupID).arg(scriptID)
-							 .arg(opcodeID+1).arg(errorStr));
-		gotoOpcode(fieldID, groupID, scriptID, opcodeID);
-		_scriptManager->opcodeList()->setErrorLine(opcodeID);
+		int fieldID = -1;
+		ScriptCompileError firstError;
+		QStringList errors;
+
+		foreach(const FieldCompileReport &report, reports) {
+			const Field *f = fieldArchive->field(report.fieldID);
+			foreach(const ScriptCompileError &error, report.errors) {
+				if(fieldID < 0) {
+					fieldID = report.fieldID;
+					firstError = error;
+				}
+				if(error.groupID < 0) {
+					errors.append(tr("scene %1 (%2): %3")
+					              .arg(f->name())
+					              .arg(report.fieldID)
+					              .arg(error.errorStr));
+				} else {
+					errors.append(tr("scene %1 (%2), group %3 (%4), script %5, line %6: %7")
+					              .arg(f->name())
+					              .arg(report.fieldID)
+					              .arg(f->scriptsAndTexts()->grpScript(error.groupID)->name())
+					              .arg(error.groupID).arg(error.scriptID)
+					              .arg(error.opcodeID+1).arg(error.errorStr));
+				}
+			}
+		}
+
+		QMessageBox message(QMessageBox::Warning, tr("Compilation Error"),
+		                    tr("Error Compiling Scripts:\n%1").arg(errors.first()),
+		                    QMessageBox::Ok, this);
+		if(errors.size() > 1) {
+			message.setInformativeText(tr("%n error(s) found.", "With plural", errors.size()));
+			message.setDetailedText(errors.join("\n"));
+		}
+		message.exec();
+
+		if(firstError.groupID >= 0) {
+			gotoOpcode(fieldID, firstError.groupID, firstError.scriptID, firstError.opcodeID);
+			_scriptManager->opcodeList()->setErrorLine(firstError.opcodeID);
+		}
 		return;
 	}
 
@@ -1037,35 +1155,43 @@ void Window::gotoText(int fieldID, int textID, int from, int size)
 	}
 }
 
-/* void Window::notifyFileChanged(const QString &path)
+void Window::notifyDirectoryChanged()
 {
-	if(!QFile::exists(path)) {
-		QMessageBox::warning(this, tr("Fichier supprimé"), tr("Le fichier '%1' a été supprimé par un programme externe !").arg(path));
-	}
-	else
-	{
-		int reponse = QMessageBox::warning(this, tr("Fichier modifié"), tr("Le fichier '%1' a été modifié par un programme externe.\nVoulez-vous recharger ce fichier ?").arg(path)
-			, QMessageBox::Yes | QMessageBox::No);
-		if(reponse == QMessageBox::Yes) {
-			open(path);
-		}
-	}
+	// Other programs often write a file in several steps
+	reloadTimer->start();
 }
 
-void Window::notifyDirectoryChanged(const QString &path)
+/*!
+ * Closes the fields changed on disk by another program,
+ * and refreshes the editors if the current field is one of them.
+ * The current field is only reloaded when it is not modified,
+ * other fields shown by the editors are kept.
+ */
+void Window::reloadChangedFields()
 {
-	if(!QFile::exists(path)) {
-		QMessageBox::warning(this, tr("Dossier supprimé"), tr("Le dossier '%1' a été supprimé par un programme externe !").arg(path));
+	if(!fieldArchive) {
+		return;
 	}
-	else
-	{
-		int reponse = QMessageBox::warning(this, tr("Dossier modifié"), tr("Le dossier '%1' a été modifié par un programme externe.\nVoulez-vous recharger ce dossier ?").arg(path)
-			, QMessageBox::Yes | QMessageBox::No);
-		if(reponse == QMessageBox::Yes) {
-			open(path, true);
+
+	// Every editor is filled again if the current field is reloaded
+	QList<QObject *> holders;
+	if(field && !field->isModified()) {
+		holders = heldFields.keys(field);
+		foreach(QObject *holder, holders) {
+			releaseField(holder);
+		}
+	}
+
+	QList<int> fieldIDs = fieldArchive->reloadChangedFields();
+
+	if(fieldIDs.contains(currentFieldId())) {
+		openField(true);
+	} else {
+		foreach(QObject *holder, holders) {
+			holdField(holder, field);
 		}
 	}
-} */
+}
 
 void Window::exporter()
 {
@@ -1296,6 +1422,7 @@ void Window::textManager(int textID, int from, int size, bool activate)
 	}
 
 	if(field && field->scriptsAndTexts()->isOpen()) {
+		holdField(_textDialog, field);
 		_textDialog->setField(field);
 		_textDialog->setEnabled(true);
 	} else {
@@ -1331,6 +1458,7 @@ void Window::modelManager()
 //			fieldModel->clear();
 //		}
 
+		holdField(_modelManager, field);
 		_modelManager->fill(field);
 		_modelManager->setEnabled(true);
 
@@ -1376,6 +1504,7 @@ void Window::tutManager()
 		if(fieldArchive->isPC()) {
 			tutPC = static_cast<FieldArchivePC *>(fieldArchive)->tut(field->name());
 		}
+		holdField(_tutManager, field);
 		_tutManager->fill(field, tutPC);
 		_tutManager->setEnabled(true);
 	} else {
@@ -1394,6 +1523,7 @@ void Window::walkmeshManager()
 	}
 
 	if(field) {
+		holdField(_walkmeshManager, field);
 		_walkmeshManager->fill(field);
 		_walkmeshManager->setEnabled(true);
 	} else {
@@ -1413,6 +1543,7 @@ void Window::backgroundManager()
 	}
 
 	if(field) {
+		holdField(_backgroundManager, field);
 		_backgroundManager->fill(field);
 		_backgroundManager->setEnabled(true);
 	} else {
@@ -1487,6 +1618,56 @@ void Window::miscOperations()
 	}
 }
 
+void Window::analyzeScripts()
+{
+	if(!fieldArchive) {
+		return;
+	}
+
+	QList<ScriptIssue> issues;
+
+	showProgression(tr("Analyzing..."), false);
+	fieldArchive->analyzeScripts(issues);
+	hideProgression();
+
+	if(issues.isEmpty()) {
+		QMessageBox::information(this, tr("Script Analysis"), tr("No issue found."));
+		return;
+	}
+
+	QStringList lines;
+
+	foreach(const ScriptIssue &issue, issues) {
+		const Field *f = fieldArchive->field(issue.fieldID, false);
+		QString description;
+		switch(issue.type) {
+		case ScriptIssue::DeadCode:
+			description = tr("unreachable code");
+			break;
+		case ScriptIssue::BadJump:
+			description = tr("invalid jump");
+			break;
+		case ScriptIssue::UninitializedVar:
+			description = tr("var %1[%2] is never written")
+			              .arg(issue.var.bank).arg(issue.var.address);
+			break;
+		}
+		lines.append(tr("scene %1 (%2), group %3, script %4, line %5: %6")
+		             .arg(f->name()).arg(issue.fieldID)
+		             .arg(issue.groupID).arg(issue.scriptID)
+		             .arg(issue.opcodeID+1).arg(description));
+	}
+
+	QMessageBox message(QMessageBox::Warning, tr("Script Analysis"),
+	                    lines.first(), QMessageBox::Ok, this);
+	message.setInformativeText(tr("%n issue(s) found.", "With plural", issues.size()));
+	message.setDetailedText(lines.join("\n"));
+	message.exec();
+
+	const ScriptIssue &first = issues.first();
+	gotoOpcode(first.fieldID, first.groupID, first.scriptID, first.opcodeID);
+}
+
 void Window::fontManager()
 {
 	FontManager dialog(this);
@@ -74,8 +74,7 @@ public slots:
 
 	void jpText(bool);
 
-	//	void notifyFileChanged(const QString &path);
-	//	void notifyDirectoryChanged(const QString &path);
+	void reloadChangedFields();
 	void exporter();
 	void massExport();
 	void massImport();
@@ -92,6 +91,7 @@ public slots:
 	void searchManager();
 	void archiveManager();
 	void miscOperations();
+	void analyzeScripts();
 	void fontManager();
 	void about();
 private slots:
@@ -104,7 +104,10 @@ private slots:
 	void toggleFieldList();
 	void toggleBackgroundPreview();
 	void config();
+	void notifyDirectoryChanged();
+	void releaseField(QObject *holder);
 private:
+	void holdField(QObject *holder, Field *field);
 	void setWindowTitle();
 	void restartNow();
 	void showProgression(const QString &message, bool canBeCanceled);
@@ -123,17 +126,18 @@ private:
 
 	FieldArchive *fieldArchive;
 	Field *field;
+	QHash<QObject *, Field *> heldFields; // Pinned for each widget
 	bool firstShow;
 
 	Search *searchDialog;
 	VarManager *varDialog;
 
 	QMenu *_recentMenu;
-	QAction *actionSave, *actionSaveAs, *actionExport;
+	QAction *actionSave, *actionSaveAs, *actionReload, *actionExport;
 	QAction *actionMassExport, *actionImport, *actionMassImport, *actionClose;
 	QAction *actionRun, *actionModels, *actionArchive;
 	QAction *actionEncounter;
-	QAction *actionMisc, *actionMiscOperations, *actionJp_txt;
+	QAction *actionMisc, *actionMiscOperations, *actionAnalyzeScripts, *actionJp_txt;
 	QMenu *menuLang;
 
 	ScriptManager *_scriptManager;
@@ -145,11 +149,14 @@ private:
 
 	QTaskBarButton *taskBarButton;
 	QProgressDialog *_progressDialog;
+	QFileSystemWatcher *fileWatcher;
+	QTimer *reloadTimer;
 	QAction *authorAction;
 	QLabel *authorLbl;
 
 //	FieldModelThread *modelThread;
 protected:
+	void changeEvent(QEvent *event);
 	void closeEvent(QCloseEvent *event);
 	QMenu *createPopupMenu();
 };
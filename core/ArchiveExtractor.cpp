@@ -0,0 +1,343 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ArchiveExtractor.h"
+
+#define EXTRACT_CHUNK_SIZE		4194304 // 4 MB
+#define EXTRACT_MAX_QUEUED		67108864 // 64 MB
+#define EXTRACT_MAX_GAP			65536 // Unused bytes read between two files
+
+class ArchiveExtractorThread : public QThread
+{
+public:
+	explicit ArchiveExtractorThread(ArchiveExtractor *extractor) :
+		_extractor(extractor) {}
+protected:
+	void run() {
+		_extractor->work();
+	}
+private:
+	ArchiveExtractor *_extractor;
+};
+
+static bool entryLessThan(const ExtractEntry &e1, const ExtractEntry &e2)
+{
+	// Entries without position are read at the end
+	if(e1.position < 0 || e2.position < 0) {
+		return e1.position > e2.position;
+	}
+	return e1.position < e2.position;
+}
+
+ArchiveExtractor::ArchiveExtractor(QIODevice *archive) :
+	_archive(archive), _queuedSize(0), _readFinished(false),
+	_bytesExtracted(0), _elapsed(0)
+{
+}
+
+ArchiveExtractor::~ArchiveExtractor()
+{
+}
+
+/*!
+ * Plans the extraction of size bytes at position in the archive.
+ * The directory of destination must exist.
+ */
+void ArchiveExtractor::addEntry(qint64 position, qint64 size, const QString &destination)
+{
+	ExtractEntry entry;
+	entry.position = position;
+	entry.size = size;
+	entry.io = NULL;
+	entry.destination = destination;
+	_entries.append(entry);
+}
+
+/*!
+ * Plans the extraction of a file not stored in the archive,
+ * like a modified file. io must stay valid until extract() returns.
+ */
+void ArchiveExtractor::addEntry(QIODevice *io, const QString &destination)
+{
+	ExtractEntry entry;
+	entry.position = -1;
+	entry.size = io->size();
+	entry.io = io;
+	entry.destination = destination;
+	_entries.append(entry);
+}
+
+/*!
+ * Extracts every entry, returns false on error or cancellation.
+ */
+bool ArchiveExtractor::extract(ArchiveObserver *observer)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	_errorString = QString();
+	_bytesExtracted = 0;
+	_queuedSize = 0;
+	_readFinished = false;
+	_queue.clear();
+
+	qStableSort(_entries.begin(), _entries.end(), entryLessThan);
+
+	if(observer) {
+		observer->setObserverMaximum(_entries.size());
+	}
+
+	QList<QThread *> threads;
+	int threadCount = qBound(1, QThread::idealThreadCount(), qMax(1, _entries.size()));
+	for(int i=0 ; i<threadCount ; ++i) {
+		QThread *thread = new ArchiveExtractorThread(this);
+		threads.append(thread);
+		thread->start();
+	}
+
+	int i = 0;
+	while(i < _entries.size()) {
+		if(hasError()) {
+			break;
+		}
+		if(observer) {
+			if(observer->observerWasCanceled()) {
+				setError(QObject::tr("Canceled"));
+				break;
+			}
+			observer->setObserverValue(i);
+		}
+		int last = batchEnd(i);
+		if(last > i ? !readBatch(i, last) : !readEntry(_entries.at(i))) {
+			break;
+		}
+		i = last + 1;
+	}
+
+	_mutex.lock();
+	_readFinished = true;
+	_notEmpty.wakeAll();
+	_mutex.unlock();
+
+	foreach(QThread *thread, threads) {
+		thread->wait();
+	}
+	qDeleteAll(threads);
+
+	_elapsed = timer.elapsed();
+
+#ifndef QT_NO_DEBUG
+	qDebug() << "ArchiveExtractor::extract" << _entries.size() << "files,"
+	         << _bytesExtracted / 1048576.0 << "MB in" << _elapsed << "ms,"
+	         << throughput() << "MB/s";
+#endif
+
+	return !hasError();
+}
+
+/*!
+ * Average speed of the last extraction, in MB/s.
+ */
+double ArchiveExtractor::throughput() const
+{
+	if(_elapsed <= 0) {
+		return 0.0;
+	}
+	return (_bytesExtracted / 1048576.0) / (_elapsed / 1000.0);
+}
+
+qint64 ArchiveExtractor::readRange(qint64 position, char *data, qint64 size)
+{
+	if(!_archive->seek(position)) {
+		return -1;
+	}
+	return _archive->read(data, size);
+}
+
+/*!
+ * Index of the last entry that can be read with the entry first,
+ * in one read of at most EXTRACT_CHUNK_SIZE bytes.
+ */
+int ArchiveExtractor::batchEnd(int first) const
+{
+	const ExtractEntry &start = _entries.at(first);
+	if(start.io || start.size > EXTRACT_CHUNK_SIZE) {
+		return first;
+	}
+
+	qint64 end = start.position + start.size;
+	int last = first;
+	for(int i=first+1 ; i<_entries.size() ; ++i) {
+		const ExtractEntry &entry = _entries.at(i);
+		if(entry.io || entry.position < end
+		        || entry.position - end > EXTRACT_MAX_GAP
+		        || entry.position + entry.size - start.position > EXTRACT_CHUNK_SIZE) {
+			break;
+		}
+		end = entry.position + entry.size;
+		last = i;
+	}
+
+	return last;
+}
+
+/*!
+ * Reads the entries from first to last in one range of the archive.
+ */
+bool ArchiveExtractor::readBatch(int first, int last)
+{
+	const qint64 start = _entries.at(first).position;
+	QByteArray data;
+	data.resize(_entries.at(last).position + _entries.at(last).size - start);
+
+	if(readRange(start, data.data(), data.size()) != data.size()) {
+		setError(QObject::tr("Cannot read %1 from the archive").arg(_entries.at(first).destination));
+		return false;
+	}
+
+	for(int i=first ; i<=last ; ++i) {
+		const ExtractEntry &entry = _entries.at(i);
+		ExtractChunk chunk;
+		chunk.destination = entry.destination;
+		chunk.offset = 0;
+		chunk.wholeFile = true;
+		chunk.data = data.mid(entry.position - start, entry.size);
+		enqueue(chunk);
+	}
+
+	return true;
+}
+
+bool ArchiveExtractor::readEntry(const ExtractEntry &entry)
+{
+	if(entry.io && !entry.io->isOpen() && !entry.io->open(QIODevice::ReadOnly)) {
+		setError(QObject::tr("Cannot open the data of %1").arg(entry.destination));
+		return false;
+	}
+	if(entry.io) {
+		entry.io->reset();
+	}
+
+	bool wholeFile = entry.size <= EXTRACT_CHUNK_SIZE;
+
+	if(!wholeFile) {
+		// Chunks are written separately, create the file now
+		QFile f(entry.destination);
+		if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			setError(f.errorString());
+			return false;
+		}
+		f.close();
+	}
+
+	qint64 offset = 0;
+
+	do {
+		ExtractChunk chunk;
+		chunk.destination = entry.destination;
+		chunk.offset = offset;
+		chunk.wholeFile = wholeFile;
+		chunk.data.resize(qMin(qint64(EXTRACT_CHUNK_SIZE), entry.size - offset));
+
+		qint64 read = entry.io
+		        ? entry.io->read(chunk.data.data(), chunk.data.size())
+		        : readRange(entry.position + offset, chunk.data.data(), chunk.data.size());
+		if(read != chunk.data.size()) {
+			setError(QObject::tr("Cannot read %1 from the archive").arg(entry.destination));
+			return false;
+		}
+
+		offset += read;
+		enqueue(chunk);
+	} while(offset < entry.size);
+
+	return true;
+}
+
+void ArchiveExtractor::enqueue(const ExtractChunk &chunk)
+{
+	QMutexLocker locker(&_mutex);
+
+	// Limits the memory used when writing is slower than reading
+	while(_queuedSize > EXTRACT_MAX_QUEUED && _errorString.isEmpty()) {
+		_notFull.wait(&_mutex);
+	}
+
+	_queue.enqueue(chunk);
+	_queuedSize += chunk.data.size();
+	_notEmpty.wakeOne();
+}
+
+void ArchiveExtractor::work()
+{
+	forever {
+		ExtractChunk chunk;
+		{
+			QMutexLocker locker(&_mutex);
+			while(_queue.isEmpty() && !_readFinished) {
+				_notEmpty.wait(&_mutex);
+			}
+			if(_queue.isEmpty()) {
+				return;
+			}
+			chunk = _queue.dequeue();
+			_queuedSize -= chunk.data.size();
+			_notFull.wakeOne();
+		}
+
+		if(!hasError() && writeChunk(chunk)) {
+			QMutexLocker locker(&_mutex);
+			_bytesExtracted += chunk.data.size();
+		}
+	}
+}
+
+bool ArchiveExtractor::writeChunk(const ExtractChunk &chunk)
+{
+	QFile f(chunk.destination);
+	if(!f.open(chunk.wholeFile
+	           ? QIODevice::WriteOnly | QIODevice::Truncate
+	           : QIODevice::ReadWrite)) {
+		setError(f.errorString());
+		return false;
+	}
+	if(!chunk.wholeFile && !f.seek(chunk.offset)) {
+		setError(f.errorString());
+		return false;
+	}
+	if(f.write(chunk.data) != chunk.data.size()) {
+		setError(f.errorString());
+		return false;
+	}
+	return true;
+}
+
+void ArchiveExtractor::setError(const QString &errorString)
+{
+	QMutexLocker locker(&_mutex);
+	if(_errorString.isEmpty()) {
+		_errorString = errorString.isEmpty() ? QObject::tr("Unknown error") : errorString;
+	}
+	// Unblock the reader
+	_notFull.wakeAll();
+}
+
+bool ArchiveExtractor::hasError() const
+{
+	QMutexLocker locker(&_mutex);
+	return !_errorString.isEmpty();
+}
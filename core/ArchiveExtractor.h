@@ -0,0 +1,95 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef ARCHIVEEXTRACTOR_H
+#define ARCHIVEEXTRACTOR_H
+
+#include <QtCore>
+#include "Archive.h"
+
+struct ExtractEntry
+{
+	qint64 position; // In the archive, -1 when the data comes from io
+	qint64 size;
+	QIODevice *io;
+	QString destination;
+};
+
+struct ExtractChunk
+{
+	QString destination;
+	qint64 offset; // In the destination file
+	QByteArray data;
+	bool wholeFile;
+};
+
+/*
+ * Extracts many files from an archive at once:
+ * the archive is read sequentially in the calling thread,
+ * sorted by position, and the files are written by worker threads.
+ * Small adjacent files are read together, up to 4 MB at a time.
+ */
+class ArchiveExtractor
+{
+	friend class ArchiveExtractorThread;
+public:
+	explicit ArchiveExtractor(QIODevice *archive);
+	virtual ~ArchiveExtractor();
+	void addEntry(qint64 position, qint64 size, const QString &destination);
+	void addEntry(QIODevice *io, const QString &destination);
+	inline int entryCount() const {
+		return _entries.size();
+	}
+	bool extract(ArchiveObserver *observer = NULL);
+	inline const QString &errorString() const {
+		return _errorString;
+	}
+	inline qint64 bytesExtracted() const {
+		return _bytesExtracted;
+	}
+	inline qint64 elapsed() const {
+		return _elapsed;
+	}
+	double throughput() const;
+protected:
+	virtual qint64 readRange(qint64 position, char *data, qint64 size);
+	inline QIODevice *archive() const {
+		return _archive;
+	}
+private:
+	Q_DISABLE_COPY(ArchiveExtractor)
+	int batchEnd(int first) const;
+	bool readBatch(int first, int last);
+	bool readEntry(const ExtractEntry &entry);
+	void enqueue(const ExtractChunk &chunk);
+	void work();
+	bool writeChunk(const ExtractChunk &chunk);
+	void setError(const QString &errorString);
+	bool hasError() const;
+
+	QIODevice *_archive;
+	QList<ExtractEntry> _entries;
+	QQueue<ExtractChunk> _queue;
+	qint64 _queuedSize;
+	bool _readFinished;
+	mutable QMutex _mutex;
+	QWaitCondition _notEmpty, _notFull;
+	QString _errorString;
+	qint64 _bytesExtracted, _elapsed;
+};
+
+#endif // ARCHIVEEXTRACTOR_H
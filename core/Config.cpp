@@ -18,6 +18,7 @@
 #include "Config.h"
 
 QSettings *Config::settings = 0;
+QMutex Config::mutex;
 
 QString Config::programResourceDir()
 {
@@ -51,16 +52,19 @@ void Config::remove() {
 
 QVariant Config::value(const QString &key, const QVariant &defaultValue)
 {
+	QMutexLocker locker(&mutex);
 	return settings->value(key, defaultValue);
 }
 
 void Config::setValue(const QString &key, const QVariant &value)
 {
+	QMutexLocker locker(&mutex);
 	settings->setValue(key, value);
 }
 
 void Config::append(const QString &key, const QVariant &value)
 {
+	QMutexLocker locker(&mutex);
 	QList<QVariant> list = settings->value(key).toList();
 	list.append(value);
 	settings->setValue(key, list);
@@ -68,6 +72,7 @@ void Config::append(const QString &key, const QVariant &value)
 
 void Config::remove(const QString &key)
 {
+	QMutexLocker locker(&mutex);
 	settings->remove(key);
 }
 
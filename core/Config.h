@@ -33,6 +33,7 @@ public:
 	static void flush();
 private:
 	static QSettings *settings;
+	static QMutex mutex; // Settings are read from worker threads
 };
 
 #endif // CONFIG_H
@@ -0,0 +1,374 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "FF7TextLayout.h"
+#include "FF7Text.h"
+#include "WindowBinFile.h"
+#include "Config.h"
+#include "Data.h"
+
+/*!
+ * Config values are read once, at construction.
+ */
+FF7TextLayout::FF7TextLayout() :
+	_jp(Config::value("jp_txt", false).toBool()),
+	_baseWidth(8 + Config::value("autoSizeMarginRight", 14).toInt()),
+	_spacedCharsW(Config::value("spacedCharactersWidth", 13).toInt())
+{
+}
+
+QSize FF7TextLayout::windowSize(const QByteArray &ff7Text) const
+{
+	QList<int> pagesPos;
+	return windowSize(ff7Text, pagesPos);
+}
+
+/*!
+ * Window size for the text, limited to the screen.
+ */
+QSize FF7TextLayout::windowSize(const QByteArray &ff7Text, QList<int> &pagesPos) const
+{
+	return requiredSize(ff7Text, pagesPos).boundedTo(QSize(322, 226));
+}
+
+QSize FF7TextLayout::requiredSize(const QByteArray &ff7Text) const
+{
+	QList<int> pagesPos;
+	return requiredSize(ff7Text, pagesPos);
+}
+
+/*!
+ * Size needed to show the whole text, can be larger than the screen.
+ */
+QSize FF7TextLayout::requiredSize(const QByteArray &ff7Text, QList<int> &pagesPos) const
+{
+	int line=0, width=_baseWidth - 3, height=25, size=ff7Text.size(), maxW=0, maxH=0;
+	pagesPos.clear();
+	pagesPos.append(0);
+	bool spaced_characters = false;
+
+	for(int i=0 ; i<size ; ++i) {
+		quint8 caract = (quint8)ff7Text.at(i);
+		if(caract==0xff) break;
+		switch(caract) {
+		case 0xe8: // New Page
+		case 0xe9: // New Page 2
+			if(line == 0)	width += 3;
+			if(height>maxH)	maxH = height;
+			if(width>maxW)	maxW = width;
+			++line;
+			width = _baseWidth;
+			height = 25;
+			pagesPos.append(i+1);
+			break;
+		case 0xe7: // \n
+			if(line == 0)	width += 3;
+			if(width>maxW)	maxW = width;
+			++line;
+			width = _baseWidth;
+			height += 16;
+			break;
+		case 0xfa: // Jap 1
+			++i;
+			caract = (quint8)ff7Text.at(i);
+			if(_jp) {
+				width += spaced_characters ? _spacedCharsW : charFullWidth(2, caract);
+			} else if(caract < 0xd2) {
+				width += spaced_characters ? _spacedCharsW : 1;
+			}
+			break;
+		case 0xfb: // Jap 2
+			++i;
+			if(_jp) {
+				caract = (quint8)ff7Text.at(i);
+				width += spaced_characters ? _spacedCharsW : charFullWidth(3, caract);
+			}
+			break;
+		case 0xfc: // Jap 3
+			++i;
+			if(_jp) {
+				caract = (quint8)ff7Text.at(i);
+				width += spaced_characters ? _spacedCharsW : charFullWidth(4, caract);
+			}
+			break;
+		case 0xfd: // Jap 4
+			++i;
+			if(_jp) {
+				caract = (quint8)ff7Text.at(i);
+				width += spaced_characters ? _spacedCharsW : charFullWidth(5, caract);
+			}
+			break;
+		case 0xfe: // Jap 5 + add
+			++i;
+			if(i >= size)		break;
+			caract = (quint8)ff7Text.at(i);
+			if(caract == 0xdd)
+				++i;
+			else if(caract == 0xde || caract == 0xdf || caract == 0xe1) {
+				if(caract == 0xe1)		width += spaced_characters ? _spacedCharsW * 4 : 12;
+				int zeroId = !_jp ? 0x10 : 0x33;
+				width += spaced_characters ? _spacedCharsW : charFullWidth(0, zeroId);
+			} else if(caract == 0xe2)
+				i += 4;
+			else if(caract == 0xe9)
+				spaced_characters = !spaced_characters;
+			else if(caract < 0xd2 && _jp)
+				width += spaced_characters ? _spacedCharsW : charFullWidth(6, caract);
+			break;
+		default:
+			if(!_jp && caract==0xe0) {// {CHOICE}
+				width += spaced_characters ? _spacedCharsW * 10 : 30;
+			} else if(!_jp && caract==0xe1) {// \t
+				width += spaced_characters ? _spacedCharsW * 4 : 12;
+			} else if(!_jp && caract>=0xe2 && caract<=0xe4) {// duo
+				const char *duo = optimisedDuo[caract-0xe2];
+				width += spaced_characters ? _spacedCharsW : charFullWidth(1, (quint8)duo[0]);
+				width += spaced_characters ? _spacedCharsW : charFullWidth(1, (quint8)duo[1]);
+			} else if(caract>=0xea && caract<=0xf5) {// Character names
+				width += spaced_characters ? _spacedCharsW * name(caract-0xea).size() : nameWidth(caract-0xea);
+			} else if(caract>=0xf6 && caract<=0xf9) {// Keys
+				width += 17;
+			} else {
+				if(_jp) {
+					width += spaced_characters ? _spacedCharsW : charFullWidth(1, caract);
+				} else {
+					width += spaced_characters ? _spacedCharsW : charFullWidth(0, caract);
+				}
+			}
+			break;
+		}
+	}
+
+	if(height>maxH)	maxH = height;
+	if(width>maxW)	maxW = width;
+
+	return QSize(maxW, maxH);
+}
+
+int FF7TextLayout::textWidth(const QByteArray &ff7Text)
+{
+	int width = 0;
+
+	foreach(const quint8 &c, ff7Text) {
+		if(c<0xe0) {
+			width += charFullWidth(0, c);
+		}
+	}
+
+	return width;
+}
+
+quint8 FF7TextLayout::charWidth(int tableId, int charId)
+{
+	return Data::windowBin.isValid() &&
+			(tableId != 0 || !Data::windowBin.isJp())
+			? Data::windowBin.charWidth(tableId == 0 ? 0 : tableId - 1, charId)
+			: CHAR_WIDTH(builtInCharWidth[tableId][charId]);
+}
+
+quint8 FF7TextLayout::leftPadding(int tableId, int charId)
+{
+	return Data::windowBin.isValid() &&
+			(tableId != 0 || !Data::windowBin.isJp())
+			? Data::windowBin.charLeftPadding(tableId == 0 ? 0 : tableId - 1, charId)
+			: LEFT_PADD(builtInCharWidth[tableId][charId]);
+}
+
+quint8 FF7TextLayout::charFullWidth(int tableId, int charId)
+{
+	return charWidth(tableId, charId) + leftPadding(tableId, charId);
+}
+
+/*!
+ * Not thread safe the first time, see updateNames().
+ */
+const QByteArray &FF7TextLayout::name(int nameId)
+{
+	if(names.isEmpty()) {
+		fillNames();
+	}
+	return names.at(nameId);
+}
+
+int FF7TextLayout::nameWidth(int nameId)
+{
+	if(names.isEmpty()) {
+		fillNames();
+	}
+	return namesWidth[nameId];
+}
+
+void FF7TextLayout::updateNames()
+{
+	names.clear();
+	fillNames();
+}
+
+void FF7TextLayout::fillNames()
+{
+	QStringList dataNames = Data::char_names;
+	for(int i=0 ; i<9 ; ++i) {
+		QString customName = Config::value(QString("customCharName%1").arg(i)).toString();
+		if(!customName.isEmpty()) {
+			dataNames.replace(i, customName);
+		}
+	}
+	dataNames.replace(9, QCoreApplication::translate("TextPreview", "Member 1"));
+	dataNames.replace(10, QCoreApplication::translate("TextPreview", "Member 2"));
+	dataNames.replace(11, QCoreApplication::translate("TextPreview", "Member 3"));
+
+	for(int i=0 ; i<12 ; ++i) {
+		QByteArray nameData = FF7Text(dataNames.at(i), false).data();
+		names.append(nameData);
+		namesWidth[i] = textWidth(nameData);
+	}
+}
+
+quint8 FF7TextLayout::builtInCharWidth[7][256] =
+{
+	{ // International
+		3, 3, 72, 10, 7, 10, 9, 3, 72, 72, 7, 7, 39, 5, 38, 6,
+		8, 71, 8, 8, 8, 8, 8, 8, 8, 8, 69, 4, 7, 8, 7, 6,
+		10, 9, 7, 8, 8, 7, 7, 8, 8, 3, 6, 7, 7, 11, 8, 9,
+		7, 9, 7, 7, 7, 8, 9, 11, 8, 9, 7, 4, 6, 4, 7, 8,
+		4, 7, 7, 6, 7, 7, 6, 7, 7, 3, 4, 6, 3, 11, 7, 7,
+		7, 7, 5, 6, 6, 7, 7, 11, 7, 7, 6, 5, 3, 5, 8, 68,
+		73, 76, 72, 73, 73, 9, 8, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+		7, 7, 4, 4, 4, 4, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+		11, 6, 7, 8, 11, 6, 7, 7, 9, 9, 11, 4, 5, 8, 12, 9,
+		11, 7, 7, 7, 9, 7, 7, 7, 9, 8, 4, 6, 6, 9, 11, 7,
+		6, 3, 8, 7, 8, 8, 9, 7, 7, 9, 1, 9, 9, 9, 12, 11,
+		8, 12, 6, 6, 4, 4, 7, 7, 7, 9, 7, 9, 5, 5, 7, 7,
+		8, 3, 4, 6, 13, 9, 7, 9, 7, 7, 3, 4, 4, 3, 9, 9,
+		8, 9, 8, 8, 8, 3, 6, 7, 5, 6, 3, 6, 5, 6, 5, 5,
+		1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	},{ // Jap - 0
+		13, 13, 11, 13, 12, 13, 12, 12, 12, 13, 12, 12, 11, 12, 12, 10,
+		12, 12, 12, 11, 13, 11, 12, 9, 12, 12, 12, 13, 10, 12, 12, 12,
+		12, 12, 12, 12, 12, 12, 8, 11, 12, 13, 12, 10, 12, 12, 12, 12,
+		12, 11, 13, 8, 70, 8, 8, 9, 8, 8, 7, 8, 8, 39, 41, 8,
+		12, 11, 9, 11, 10, 12, 12, 12, 11, 11, 10, 12, 10, 10, 10, 8,
+		11, 11, 10, 9, 11, 10, 11, 9, 10, 11, 11, 11, 9, 10, 10, 11,
+		11, 10, 10, 11, 11, 10, 6, 9, 10, 10, 11, 12, 10, 11, 11, 11,
+		11, 12, 10, 12, 11, 10, 9, 12, 11, 12, 9, 11, 10, 12, 9, 12,
+		11, 11, 10, 11, 11, 10, 10, 9, 8, 8, 11, 10, 8, 11, 9, 10,
+		11, 11, 11, 11, 9, 10, 10, 12, 10, 11, 9, 10, 9, 8, 9, 9,
+		9, 9, 7, 8, 8, 9, 8, 8, 7, 8, 9, 8, 9, 10, 69, 41,
+		73, 74, 4, 9, 10, 9, 9, 9, 9, 9, 9, 9, 69, 7, 8, 9,
+		11, 9, 9, 9, 10, 9, 9, 11, 9, 9, 11, 9, 11, 10, 70, 9,
+		9, 13, 12, 13, 13, 70, 10, 6, 6, 11, 13, 10, 9, 72, 72, 72,
+		72, 9, 9, 1, 1, 1, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	},{ // Jap - 1
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 10,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 11,
+		13, 12, 10, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	},{ // Jap - 2
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13,
+		13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 9, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 12, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	},{ // Jap - 3
+		12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		10, 13, 13, 12, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	},{ // Jap - 4
+		13, 13, 13, 13, 13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	},{ // Jap - 5
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 11, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	}
+};
+
+const char *FF7TextLayout::optimisedDuo[3] =
+{
+	"\x0c\x00",//', '
+	"\x0e\x02",//'."'
+	"\xa9\x02" //'..."'
+};
+
+QList<QByteArray> FF7TextLayout::names;
+
+int FF7TextLayout::namesWidth[12];
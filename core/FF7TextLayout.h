@@ -0,0 +1,55 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef FF7TEXTLAYOUT_H
+#define FF7TEXTLAYOUT_H
+
+#include <QtCore>
+
+/*
+ * Measures FF7 texts without any widget, with char widths
+ * from Data::windowBin or from the built-in tables.
+ */
+class FF7TextLayout
+{
+public:
+	FF7TextLayout();
+	QSize windowSize(const QByteArray &ff7Text) const;
+	QSize windowSize(const QByteArray &ff7Text, QList<int> &pagesPos) const;
+	QSize requiredSize(const QByteArray &ff7Text) const;
+	QSize requiredSize(const QByteArray &ff7Text, QList<int> &pagesPos) const;
+	static int textWidth(const QByteArray &ff7Text);
+	static quint8 charWidth(int tableId, int charId);
+	static quint8 leftPadding(int tableId, int charId);
+	static quint8 charFullWidth(int tableId, int charId);
+	static const QByteArray &name(int nameId);
+	static int nameWidth(int nameId);
+	static void updateNames();
+
+	static const char *optimisedDuo[3];
+private:
+	static void fillNames();
+
+	bool _jp;
+	int _baseWidth, _spacedCharsW;
+
+	static quint8 builtInCharWidth[7][256];
+	static QList<QByteArray> names;
+	static int namesWidth[12];
+};
+
+#endif // FF7TEXTLAYOUT_H
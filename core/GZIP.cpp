@@ -29,37 +29,134 @@ QByteArray GZIP::compress(const QByteArray &ungzip, int level, Strategy strategy
 	return compress(ungzip.constData(), ungzip.size(), level, strategy);
 }
 
+/*!
+ * Inflates s into buffer, which is grown when full if growable.
+ * s.next_out must point into buffer.
+ */
+static int gzipInflate(z_stream &s, char *buffer, QByteArray *growable)
+{
+	int ret;
+
+	forever {
+		ret = inflate(&s, Z_NO_FLUSH);
+
+		if(ret == Z_STREAM_END) {
+			// Concatenated gzip members, like gzread()
+			if(s.avail_in >= 2 && s.next_in[0] == 0x1f && s.next_in[1] == 0x8b
+					&& inflateReset(&s) == Z_OK) {
+				continue;
+			}
+			break;
+		}
+
+		if(ret == Z_BUF_ERROR && s.avail_out == 0 && s.avail_in > 0 && growable) {
+			const int written = (char *)s.next_out - buffer;
+			growable->resize(qMax(written * 2, 4096));
+			buffer = growable->data();
+			s.next_out = (Bytef *)buffer + written;
+			s.avail_out = growable->size() - written;
+		} else if(ret != Z_OK) {
+			break;
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * Inflates data directly into out, returns the number of bytes written
+ * (at most outSize) or -1 on error.
+ */
+int GZIP::decompress(const char *data, int size, char *out, int outSize)
+{
+	z_stream s;
+	s.zalloc = Z_NULL;
+	s.zfree = Z_NULL;
+	s.opaque = Z_NULL;
+	s.next_in = (Bytef *)data;
+	s.avail_in = size;
+
+	if(inflateInit2(&s, MAX_WBITS + 16) != Z_OK) { // gzip header only
+		return -1;
+	}
+
+	s.next_out = (Bytef *)out;
+	s.avail_out = outSize;
+
+	int ret = gzipInflate(s, out, 0);
+
+	if(ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+		qWarning() << "GZIP::decompress error" << ret << s.msg;
+	}
+
+	int written = outSize - s.avail_out;
+	inflateEnd(&s);
+
+	return ret == Z_STREAM_END || ret == Z_BUF_ERROR || written > 0 ? written : -1;
+}
+
 QByteArray GZIP::decompress(const char *data, int size, int decSize, Strategy strategy)
 {
-	QTemporaryFile temp;
-	if(!temp.open()) {
+	Q_UNUSED(strategy); // Only used for compression
+	z_stream s;
+	s.zalloc = Z_NULL;
+	s.zfree = Z_NULL;
+	s.opaque = Z_NULL;
+	s.next_in = (Bytef *)data;
+	s.avail_in = size;
+
+	if(inflateInit2(&s, MAX_WBITS + 16) != Z_OK) { // gzip header only
 		return QByteArray();
 	}
-	temp.write(data, size);
-	temp.close();
 
-	return decompress(temp.fileName(), decSize, strategy);
+	// decSize is a hint, the buffer grows if it is wrong
+	QByteArray ungzip;
+	ungzip.resize(decSize > 0 ? decSize : qMax(size * 4, 4096));
+	s.next_out = (Bytef *)ungzip.data();
+	s.avail_out = ungzip.size();
+
+	int ret = gzipInflate(s, ungzip.data(), &ungzip);
+
+	if(ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+		qWarning() << "GZIP::decompress error" << ret << s.msg;
+	}
+
+	ungzip.resize(ungzip.size() - s.avail_out);
+	inflateEnd(&s);
+
+	return ungzip;
 }
 
 QByteArray GZIP::compress(const char *ungzip, int size, int level, Strategy strategy)
 {
-	QString tempPath = QDir::tempPath() + "/qt_temp.gz";
+	z_stream s;
+	s.zalloc = Z_NULL;
+	s.zfree = Z_NULL;
+	s.opaque = Z_NULL;
 
-	gzFile file2 = gzopen(tempPath.toLatin1(), gzMode("w", level, strategy).toLatin1());
-	if(!file2) {
+	// Same parameters than gzopen()
+	if(deflateInit2(&s, level >= 0 && level <= 9 ? level : Z_DEFAULT_COMPRESSION,
+					Z_DEFLATED, MAX_WBITS + 16, 8, zStrategy(strategy)) != Z_OK) {
 		return QByteArray();
 	}
-	gzwrite(file2, ungzip, size);
-	gzclose(file2);
-	QFile finalFile(tempPath);
-	if(!finalFile.open(QIODevice::ReadOnly)) {
+
+	QByteArray gzip;
+	gzip.resize(deflateBound(&s, size));
+	s.next_in = (Bytef *)ungzip;
+	s.avail_in = size;
+	s.next_out = (Bytef *)gzip.data();
+	s.avail_out = gzip.size();
+
+	int ret = deflate(&s, Z_FINISH);
+	gzip.resize(gzip.size() - s.avail_out);
+	deflateEnd(&s);
+
+	if(ret != Z_STREAM_END) {
+		qWarning() << "GZIP::compress error" << ret;
 		return QByteArray();
 	}
 
-	QByteArray data = finalFile.readAll();
-	finalFile.remove();
-
-	return data;
+	return gzip;
 }
 
 QByteArray GZIP::decompress(const QString &path, int decSize, Strategy strategy)
@@ -81,6 +178,18 @@ QByteArray GZIP::decompress(const QString &path, int decSize, Strategy strategy)
 	return ungzip;
 }
 
+int GZIP::zStrategy(Strategy strategy)
+{
+	switch (strategy) {
+	case StrategyDefault:     return Z_DEFAULT_STRATEGY;
+	case StrategyFiltered:    return Z_FILTERED;
+	case StrategyHuffmanOnly: return Z_HUFFMAN_ONLY;
+	case StrategyRle:         return Z_RLE;
+	case StrategyFixed:       return Z_FIXED;
+	}
+	return Z_DEFAULT_STRATEGY;
+}
+
 char GZIP::strategyToChar(Strategy strategy)
 {
 	switch (strategy) {
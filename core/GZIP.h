@@ -35,8 +35,10 @@ public:
 	static QByteArray compress(const QByteArray &ungzip, int level = -1, Strategy strategy = StrategyDefault);
 	static QByteArray decompress(const char *data, int size, int decSize, Strategy strategy = StrategyDefault);
 	static QByteArray compress(const char *ungzip, int size, int level = -1, Strategy strategy = StrategyDefault);
+	static int decompress(const char *data, int size, char *out, int outSize);
 	static QByteArray decompress(const QString &path, int decSize, Strategy strategy = StrategyDefault);
 private:
+	static int zStrategy(Strategy strategy);
 	static char strategyToChar(Strategy strategy);
 	static QString gzMode(const char *mode, int level = -1, Strategy strategy = StrategyDefault);
 };
@@ -32,8 +32,12 @@ QByteArray GZIPPS::compress(const char *ungzip, int size, const QByteArray &head
 {
 	Q_ASSERT(header.size() == 4);
 
-	QByteArray ret;
+	QByteArray gzip = GZIP::compress(ungzip, size, level), ret;
+	if(gzip.isEmpty()) {
+		return QByteArray();
+	}
+	ret.reserve(GZIPPS_HEADER_SIZE + gzip.size());
 	ret.append((char *)&size, 4); // = decSize
 	ret.append(header);
-	return ret.append(GZIP::compress(ungzip, size, level));
+	return ret.append(gzip);
 }
@@ -16,6 +16,7 @@
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "IsoArchive.h"
+#include "ArchiveExtractor.h"
 
 IsoFileOrDirectory::IsoFileOrDirectory(const QString &name, quint32 location, quint32 size, qint64 structPosition) :
 	structPosition(structPosition), _name(name), _location(location), _size(size),
@@ -991,6 +992,483 @@ void IsoArchive::repairLocationSectors(IsoDirectory *directory, IsoArchive *newI
 	}
 }
 
+#define ISO_PATCH_MAGIC			"MRISOPATCH"
+#define ISO_PATCH_MAGIC_SIZE	10
+#define ISO_PATCH_VERSION		2
+#define ISO_PATCH_CHUNK_SECTORS	1024
+#define ISO_PATCH_MAX_RANGE		8192 // sectors
+#define ISO_PATCH_MAX_CANDIDATES	16 // Base sectors compared to find a move
+#define ISO_SECTOR_BODY_POS		16 // After sync and address
+#define ISO_SECTOR_BODY_SIZE	(SECTOR_SIZE - ISO_SECTOR_BODY_POS - SECTOR_SIZE_FOOTER)
+
+enum IsoPatchRangeType {
+	IsoPatchData, // Compressed sectors
+	IsoPatchCopy, // Base sectors moved, with their new address
+	IsoPatchCopyNoFooter // Same, with an empty EDC/ECC like IsoArchiveIO::writeSector()
+};
+
+/*
+ * Reads an image by blocks of sectors, for sequential and moved reads.
+ */
+class IsoPatchReader
+{
+public:
+	explicit IsoPatchReader(QFile *file) :
+		_file(file), _first(0), _count(0) {}
+	// Returns NULL after the end of the file, size receives the sector size
+	const char *sector(quint32 num, int *size) {
+		if(num < _first || num >= _first + _count) {
+			_first = num;
+			_data.clear();
+			if(_file->seek(qint64(num) * SECTOR_SIZE)) {
+				_data = _file->read(qint64(ISO_PATCH_CHUNK_SECTORS) * SECTOR_SIZE);
+			}
+			_count = (_data.size() + SECTOR_SIZE - 1) / SECTOR_SIZE;
+			if(_count == 0) {
+				return NULL;
+			}
+		}
+		const int offset = (num - _first) * SECTOR_SIZE;
+		*size = qMin(SECTOR_SIZE, _data.size() - offset);
+		return _data.constData() + offset;
+	}
+private:
+	QFile *_file;
+	quint32 _first, _count;
+	QByteArray _data;
+};
+
+/*
+ * Writes the ranges of a patch, in the order of the result sectors.
+ */
+class IsoPatchWriter
+{
+public:
+	explicit IsoPatchWriter(QFile *patch) :
+		rangeCount(0), _patch(patch), _dataStart(0),
+		_copyStart(0), _copySource(0), _copyCount(0), _copyType(IsoPatchCopy) {}
+	bool appendData(quint32 sector, const char *data, int size) {
+		if(!flushCopy()) {
+			return false;
+		}
+		if(_data.isEmpty()) {
+			_dataStart = sector;
+		}
+		_data.append(data, size);
+		return _data.size() < ISO_PATCH_MAX_RANGE * SECTOR_SIZE || flushData();
+	}
+	// Returns false if the sector does not follow the current copy
+	bool extendCopy(quint32 sector, quint32 source, quint8 type) {
+		if(_copyCount == 0 || _copyStart + _copyCount != sector
+		        || _copySource + _copyCount != source || _copyType != type) {
+			return false;
+		}
+		++_copyCount;
+		return true;
+	}
+	bool appendCopy(quint32 sector, quint32 source, quint8 type) {
+		if(!flush()) {
+			return false;
+		}
+		_copyStart = sector;
+		_copySource = source;
+		_copyCount = 1;
+		_copyType = type;
+		return true;
+	}
+	inline quint32 copyNextSource() const {
+		return _copySource + _copyCount;
+	}
+	inline quint8 copyType() const {
+		return _copyType;
+	}
+	inline bool hasCopy() const {
+		return _copyCount > 0;
+	}
+	bool flush() {
+		return flushData() && flushCopy();
+	}
+	quint32 rangeCount;
+private:
+	bool writeRange(quint32 firstSector, quint32 sectorCount, quint8 type, const QByteArray &params) {
+		QByteArray range;
+		range.append((char *)&firstSector, 4);
+		range.append((char *)&sectorCount, 4);
+		range.append((char)type);
+		range.append(params);
+		rangeCount += 1;
+		return _patch->write(range) == range.size();
+	}
+	bool flushData() {
+		if(_data.isEmpty()) {
+			return true;
+		}
+		const QByteArray compressed = qCompress(_data, 9);
+		const quint32 sectorCount = (_data.size() + SECTOR_SIZE - 1) / SECTOR_SIZE,
+		        compressedSize = compressed.size();
+		_data.clear();
+		return writeRange(_dataStart, sectorCount, IsoPatchData,
+		                  QByteArray((char *)&compressedSize, 4).append(compressed));
+	}
+	bool flushCopy() {
+		if(_copyCount == 0) {
+			return true;
+		}
+		const quint32 count = _copyCount;
+		_copyCount = 0;
+		return writeRange(_copyStart, count, _copyType, QByteArray((char *)&_copySource, 4));
+	}
+
+	QFile *_patch;
+	QByteArray _data;
+	quint32 _dataStart, _copyStart, _copySource, _copyCount;
+	quint8 _copyType;
+};
+
+static bool isoSectorBodyIsEmpty(const char *sector)
+{
+	for(int i=ISO_SECTOR_BODY_POS ; i<ISO_SECTOR_BODY_POS + ISO_SECTOR_BODY_SIZE ; ++i) {
+		if(sector[i] != '\0') {
+			return false;
+		}
+	}
+	return true;
+}
+
+static uint isoSectorBodyHash(const char *sector)
+{
+	return qHash(QByteArray::fromRawData(sector + ISO_SECTOR_BODY_POS, ISO_SECTOR_BODY_SIZE));
+}
+
+/*
+ * Returns how modifiedSector, at the address sector, can be rebuilt
+ * from baseSector, or IsoPatchData if it cannot.
+ */
+static quint8 isoSectorRelocation(const char *baseSector, const char *modifiedSector, quint32 sector)
+{
+	const QByteArray address = IsoArchiveIO::int2Header(sector);
+	if(memcmp(baseSector, modifiedSector, 12) != 0 // Sync
+	        || memcmp(modifiedSector + 12, address.constData(), 3) != 0
+	        || baseSector[15] != modifiedSector[15] // Mode
+	        || memcmp(baseSector + ISO_SECTOR_BODY_POS, modifiedSector + ISO_SECTOR_BODY_POS, ISO_SECTOR_BODY_SIZE) != 0) {
+		return IsoPatchData;
+	}
+
+	const char *baseFooter = baseSector + SECTOR_SIZE - SECTOR_SIZE_FOOTER,
+	        *modifiedFooter = modifiedSector + SECTOR_SIZE - SECTOR_SIZE_FOOTER;
+	if(memcmp(baseFooter, modifiedFooter, SECTOR_SIZE_FOOTER) == 0) {
+		return IsoPatchCopy;
+	}
+	for(int i=0 ; i<SECTOR_SIZE_FOOTER ; ++i) {
+		if(modifiedFooter[i] != '\0') {
+			return IsoPatchData;
+		}
+	}
+	return IsoPatchCopyNoFooter;
+}
+
+/*!
+ * Writes in patchPath the raw sectors of modifiedPath that differ
+ * from basePath, for example a disc before and after a save.
+ * Sectors moved by the save (files after a bigger file) are stored as
+ * copies from the base image, only their address and EDC/ECC change.
+ * The patch only depends on the two images.
+ */
+bool IsoArchive::createPatch(const QString &basePath, const QString &modifiedPath,
+                             const QString &patchPath, ArchiveObserver *observer)
+{
+	QFile base(basePath), modified(modifiedPath), patch(patchPath);
+	if(!base.open(QIODevice::ReadOnly) || !modified.open(QIODevice::ReadOnly)) {
+		qWarning() << "IsoArchive::createPatch cannot open" << base.errorString() << modified.errorString();
+		return false;
+	}
+	if(!patch.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "IsoArchive::createPatch cannot open" << patch.errorString();
+		return false;
+	}
+
+	const qint64 baseSize = base.size(), resultSize = modified.size();
+	const quint32 baseSectorCount = baseSize / SECTOR_SIZE,
+	        sectorCount = (resultSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+	quint32 rangeCount = 0;
+	const quint16 version = ISO_PATCH_VERSION;
+
+	QByteArray header(ISO_PATCH_MAGIC, ISO_PATCH_MAGIC_SIZE);
+	header.append((char *)&version, 2);
+	header.append((char *)&baseSize, 8);
+	header.append((char *)&resultSize, 8);
+	header.append((char *)&rangeCount, 4); // Updated at the end
+	if(patch.write(header) != header.size()) {
+		patch.remove();
+		return false;
+	}
+
+	if(observer) {
+		observer->setObserverMaximum(baseSectorCount + sectorCount);
+	}
+
+	IsoPatchReader baseReader(&base), movedReader(&base), modifiedReader(&modified);
+	IsoPatchWriter writer(&patch);
+	QMultiHash<uint, quint32> baseSectors; // Body hash -> base sector
+	const char *data;
+	int size;
+
+	// Index of the base sectors, to find the moved ones
+	for(quint32 sector=0 ; sector<baseSectorCount ; ++sector) {
+		if(observer && sector % ISO_PATCH_CHUNK_SECTORS == 0) {
+			if(observer->observerWasCanceled()) {
+				patch.remove();
+				return false;
+			}
+			observer->setObserverValue(sector);
+		}
+		data = baseReader.sector(sector, &size);
+		if(data == NULL) {
+			patch.remove();
+			return false;
+		}
+		if(!isoSectorBodyIsEmpty(data)) {
+			baseSectors.insert(isoSectorBodyHash(data), sector);
+		}
+	}
+
+	for(quint32 sector=0 ; sector<sectorCount ; ++sector) {
+		if(observer && sector % ISO_PATCH_CHUNK_SECTORS == 0) {
+			if(observer->observerWasCanceled()) {
+				patch.remove();
+				return false;
+			}
+			observer->setObserverValue(baseSectorCount + sector);
+		}
+
+		const char *modifiedData = modifiedReader.sector(sector, &size);
+		if(modifiedData == NULL) {
+			patch.remove();
+			return false;
+		}
+
+		// Unchanged
+		int baseDataSize = 0;
+		const char *baseData = sector < (baseSize + SECTOR_SIZE - 1) / SECTOR_SIZE
+		        ? baseReader.sector(sector, &baseDataSize) : NULL;
+		if(baseData && baseDataSize == size && memcmp(baseData, modifiedData, size) == 0) {
+			if(!writer.flush()) {
+				patch.remove();
+				return false;
+			}
+			continue;
+		}
+
+		if(size == SECTOR_SIZE) {
+			int movedSize;
+
+			// Next sector of the current move
+			if(writer.hasCopy() && writer.copyNextSource() < baseSectorCount) {
+				const quint32 source = writer.copyNextSource();
+				data = movedReader.sector(source, &movedSize);
+				if(data && movedSize == SECTOR_SIZE
+				        && writer.extendCopy(sector, source, isoSectorRelocation(data, modifiedData, sector))) {
+					continue;
+				}
+			}
+
+			// Start of a move, empty sectors are cheaper as data
+			if(!isoSectorBodyIsEmpty(modifiedData)) {
+				QList<quint32> candidates = baseSectors.values(isoSectorBodyHash(modifiedData));
+				quint8 type = IsoPatchData;
+				quint32 source = 0;
+				for(int i=0 ; i<candidates.size() && i<ISO_PATCH_MAX_CANDIDATES && type == IsoPatchData ; ++i) {
+					source = candidates.at(i);
+					data = movedReader.sector(source, &movedSize);
+					if(data && movedSize == SECTOR_SIZE) {
+						type = isoSectorRelocation(data, modifiedData, sector);
+					}
+				}
+				if(type != IsoPatchData) {
+					if(!writer.appendCopy(sector, source, type)) {
+						patch.remove();
+						return false;
+					}
+					continue;
+				}
+			}
+		}
+
+		if(!writer.appendData(sector, modifiedData, size)) {
+			patch.remove();
+			return false;
+		}
+	}
+
+	if(!writer.flush()
+	        || !patch.seek(ISO_PATCH_MAGIC_SIZE + 2 + 8 + 8)
+	        || patch.write((char *)&writer.rangeCount, 4) != 4) {
+		patch.remove();
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * Writes into destination the image basePath modified by the patch
+ * made by createPatch(). The base image is read in order, except
+ * for the sectors moved by the modification.
+ */
+bool IsoArchive::applyPatch(const QString &basePath, const QString &patchPath,
+                            const QString &destination, ArchiveObserver *observer)
+{
+	QFile base(basePath), patch(patchPath), out(destination);
+	if(!base.open(QIODevice::ReadOnly) || !patch.open(QIODevice::ReadOnly)) {
+		qWarning() << "IsoArchive::applyPatch cannot open" << base.errorString() << patch.errorString();
+		return false;
+	}
+
+	quint16 version;
+	qint64 baseSize, resultSize;
+	quint32 rangeCount;
+
+	if(patch.read(ISO_PATCH_MAGIC_SIZE) != QByteArray(ISO_PATCH_MAGIC, ISO_PATCH_MAGIC_SIZE)
+	        || patch.read((char *)&version, 2) != 2
+	        || version != ISO_PATCH_VERSION
+	        || patch.read((char *)&baseSize, 8) != 8
+	        || patch.read((char *)&resultSize, 8) != 8
+	        || patch.read((char *)&rangeCount, 4) != 4) {
+		qWarning() << "IsoArchive::applyPatch invalid patch";
+		return false;
+	}
+
+	if(baseSize != base.size()) {
+		qWarning() << "IsoArchive::applyPatch this patch was made for another image";
+		return false;
+	}
+
+	if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "IsoArchive::applyPatch cannot open" << out.errorString();
+		return false;
+	}
+
+	const quint32 baseSectorCount = baseSize / SECTOR_SIZE,
+	        sectorCount = (resultSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+	quint32 sector = 0;
+
+	if(observer) {
+		observer->setObserverMaximum(sectorCount);
+	}
+
+	for(quint32 i=0 ; i<=rangeCount ; ++i) {
+		quint32 firstSector = sectorCount, rangeSectorCount = 0, compressedSize, source = 0;
+		char type = IsoPatchData;
+		QByteArray sectors;
+
+		if(i < rangeCount) {
+			if(patch.read((char *)&firstSector, 4) != 4
+			        || patch.read((char *)&rangeSectorCount, 4) != 4
+			        || !patch.getChar(&type)
+			        || firstSector < sector || firstSector > sectorCount
+			        || rangeSectorCount > sectorCount - firstSector) {
+				qWarning() << "IsoArchive::applyPatch invalid patch";
+				out.remove();
+				return false;
+			}
+			if(type == IsoPatchData) {
+				if(patch.read((char *)&compressedSize, 4) != 4) {
+					qWarning() << "IsoArchive::applyPatch invalid patch";
+					out.remove();
+					return false;
+				}
+				sectors = qUncompress(patch.read(compressedSize));
+			} else if((type != IsoPatchCopy && type != IsoPatchCopyNoFooter)
+			          || patch.read((char *)&source, 4) != 4
+			          || source > baseSectorCount
+			          || rangeSectorCount > baseSectorCount - source
+			          || qint64(firstSector + rangeSectorCount) * SECTOR_SIZE > resultSize) {
+				qWarning() << "IsoArchive::applyPatch invalid patch";
+				out.remove();
+				return false;
+			}
+		}
+
+		// Unchanged sectors before the range
+		if(!base.seek(qint64(sector) * SECTOR_SIZE)) {
+			out.remove();
+			return false;
+		}
+		while(sector < firstSector) {
+			if(observer) {
+				if(observer->observerWasCanceled()) {
+					out.remove();
+					return false;
+				}
+				observer->setObserverValue(sector);
+			}
+
+			const quint32 count = qMin(quint32(ISO_PATCH_CHUNK_SECTORS), firstSector - sector);
+			const qint64 size = qMin(qint64(count) * SECTOR_SIZE, resultSize - qint64(sector) * SECTOR_SIZE);
+			const QByteArray data = base.read(size);
+			if(data.size() != size || out.write(data) != size) {
+				out.remove();
+				return false;
+			}
+			sector += count;
+		}
+
+		if(i >= rangeCount) {
+			break;
+		}
+
+		if(type == IsoPatchData) {
+			if(sectors.size() != qMin(qint64(rangeSectorCount) * SECTOR_SIZE,
+			                          resultSize - qint64(firstSector) * SECTOR_SIZE)
+			        || out.write(sectors) != sectors.size()) {
+				qWarning() << "IsoArchive::applyPatch invalid patch";
+				out.remove();
+				return false;
+			}
+			sector += rangeSectorCount;
+			continue;
+		}
+
+		// Moved sectors: new address, and maybe no EDC/ECC
+		if(!base.seek(qint64(source) * SECTOR_SIZE)) {
+			out.remove();
+			return false;
+		}
+		const quint32 lastSector = firstSector + rangeSectorCount;
+		while(sector < lastSector) {
+			if(observer) {
+				if(observer->observerWasCanceled()) {
+					out.remove();
+					return false;
+				}
+				observer->setObserverValue(sector);
+			}
+
+			const quint32 count = qMin(quint32(ISO_PATCH_CHUNK_SECTORS), lastSector - sector);
+			QByteArray data = base.read(qint64(count) * SECTOR_SIZE);
+			if(data.size() != qint64(count) * SECTOR_SIZE) {
+				out.remove();
+				return false;
+			}
+			char *rawData = data.data();
+			for(quint32 j=0 ; j<count ; ++j) {
+				char *sectorData = rawData + j * SECTOR_SIZE;
+				memcpy(sectorData + 12, IsoArchiveIO::int2Header(sector + j).constData(), 3);
+				if(type == IsoPatchCopyNoFooter) {
+					memset(sectorData + SECTOR_SIZE - SECTOR_SIZE_FOOTER, 0, SECTOR_SIZE_FOOTER);
+				}
+			}
+			if(out.write(data) != data.size()) {
+				out.remove();
+				return false;
+			}
+			sector += count;
+		}
+	}
+
+	return true;
+}
+
 IsoDirectory *IsoArchive::rootDirectory() const
 {
 	return _rootDirectory;
@@ -1268,39 +1746,79 @@ bool IsoArchive::extractDir(const QString &path, const QString &destination) con
 	return error;
 }
 
-void IsoArchive::extractAll(const QString &destination) const
+/*
+ * Reads whole raw sectors at once, then removes their headers and footers.
+ */
+class IsoArchiveExtractor : public ArchiveExtractor
+{
+public:
+	explicit IsoArchiveExtractor(IsoArchiveIO *io) :
+		ArchiveExtractor(io) {}
+protected:
+	qint64 readRange(qint64 position, char *data, qint64 size) {
+		IsoArchiveIO *io = static_cast<IsoArchiveIO *>(archive());
+
+		if(position % SECTOR_SIZE_DATA != 0) {
+			return io->seekIso(position) ? io->readIso(data, size) : -1;
+		}
+
+		qint64 sectorCount = (size + SECTOR_SIZE_DATA - 1) / SECTOR_SIZE_DATA;
+		if(!io->seekToSector(position / SECTOR_SIZE_DATA)) {
+			return -1;
+		}
+		QByteArray raw = io->read(sectorCount * SECTOR_SIZE);
+
+		qint64 read = 0;
+		for(qint64 i=0 ; i<sectorCount && read < size ; ++i) {
+			qint64 start = i * SECTOR_SIZE + SECTOR_SIZE_HEADER,
+			        len = qMin(qMin(qint64(SECTOR_SIZE_DATA), size - read), raw.size() - start);
+			if(len <= 0) {
+				break;
+			}
+			memcpy(data + read, raw.constData() + start, len);
+			read += len;
+		}
+
+		return read;
+	}
+};
+
+/*!
+ * Extracts every file, except special directories, into destination.
+ * The disc is read in the order of the sectors, and the files
+ * are written in parallel.
+ */
+bool IsoArchive::extractAll(const QString &destination, ArchiveObserver *observer) const
 {
 	if (_rootDirectory == NULL) {
-		return;
+		return false;
 	}
-	_extractAll(destination, _rootDirectory);
+
+	IsoArchiveExtractor extractor(const_cast<IsoArchiveIO *>(&_io));
+	_extractAll(destination, _rootDirectory, extractor);
+
+	return extractor.extract(observer);
 }
 
-void IsoArchive::_extractAll(const QString &destination, IsoDirectory *directories, QString currentInternalDir) const
+void IsoArchive::_extractAll(const QString &destination, IsoDirectory *directories, ArchiveExtractor &extractor) const
 {
-//	QTime t;t.start();
-
 	QDir dir(destination);
 	QString currentPath = dir.absolutePath().append('/');
-//	qDebug() << currentPath;
-	foreach(IsoFileOrDirectory *fileOrDir, directories->filesAndDirectories()) {
-		QCoreApplication::processEvents();
 
+	foreach(IsoFileOrDirectory *fileOrDir, directories->filesAndDirectories()) {
 		if(fileOrDir->isDirectory())// Directory
 		{
 			if(!fileOrDir->isSpecial()) {
 				dir.mkdir(fileOrDir->name());
-				_extractAll(currentPath + fileOrDir->name(), static_cast<IsoDirectory *>(fileOrDir), currentInternalDir.isEmpty() ? fileOrDir->name() : currentInternalDir + '/' + fileOrDir->name());
+				_extractAll(currentPath + fileOrDir->name(), static_cast<IsoDirectory *>(fileOrDir), extractor);
 			}
 		}
 		else
 		{
-//			qDebug() << fileOrDir->name();
-			extract(currentInternalDir.isEmpty() ? fileOrDir->name() : currentInternalDir + '/' + fileOrDir->name(), currentPath + fileOrDir->name());
+			extractor.addEntry(qint64(fileOrDir->location()) * SECTOR_SIZE_DATA,
+			                   fileOrDir->size(), currentPath + fileOrDir->name());
 		}
 	}
-
-//	qDebug() << "time" << t.elapsed();
 }
 
 qint32 IsoArchive::diffCountSectors(const QString &path, quint32 newSize) const
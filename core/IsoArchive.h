@@ -37,6 +37,7 @@
 
 class IsoArchiveIO;
 class IsoFileIO;
+class ArchiveExtractor;
 
 struct IsoTime {
 	char year[4];
@@ -334,8 +335,12 @@ public:
 	QIODevice *modifiedFileDevice(const QString &path) const;
 	bool extract(const QString &path, const QString &destination, quint32 maxSize=0) const;
 	bool extractDir(const QString &path, const QString &destination) const;
-	void extractAll(const QString &destination) const;
+	bool extractAll(const QString &destination, ArchiveObserver *observer = NULL) const;
 	qint32 diffCountSectors(const QString &path, quint32 newSize) const;
+	static bool createPatch(const QString &basePath, const QString &modifiedPath,
+	                        const QString &patchPath, ArchiveObserver *observer = NULL);
+	static bool applyPatch(const QString &basePath, const QString &patchPath,
+	                       const QString &destination, ArchiveObserver *observer = NULL);
 
 	IsoDirectory *rootDirectory() const;
 //	const QList<PathTable> &getPathTables1a() const;
@@ -359,7 +364,7 @@ private:
 	QList<IsoFileOrDirectory *> getIntegrity();
 	bool getIntegritySetPaddingAfter(IsoFileOrDirectory *prevFile, quint32 fileLocation);
 
-	void _extractAll(const QString &destination, IsoDirectory *directories, QString currentInternalDir=QString()) const;
+	void _extractAll(const QString &destination, IsoDirectory *directories, ArchiveExtractor &extractor) const;
 	void _getIntegrity(QMap<quint32, IsoFileOrDirectory *> &files, IsoDirectory *directory) const;
 	QMap<quint32, IsoFile *> getModifiedFiles(IsoDirectory *directory) const;
 	void getModifiedFiles(QMap<quint32, IsoFile *> &files, IsoDirectory *directory) const;
@@ -203,14 +203,26 @@ bool IsoArchiveFF7::isDemo() const
 	return dir && dir->name() == "NARITA";
 }
 
+struct BinRelocation
+{
+	quint32 newSectorStart, newSize;
+	QList<int> occurrences; // Positions of the old (sector, size) pair
+#ifdef ISOARCHIVE_DEBUG
+	QString fileName;
+#endif
+};
+
 bool IsoArchiveFF7::updateBin(IsoFile *isoBin, const QList<IsoFile *> &filesRefByBin, int startOffset)
 {
 	QByteArray data = isoBin->modifiedData(),
 	        ungzip;
 	quint32 oldSectorStart, newSectorStart, oldSize, newSize;
-	QMap<QByteArray, QByteArray> changesFieldBin;
+	QHash<quint64, int> relocationIndexes; // (old sector << 32 | old size) -> index in relocations
+	QList<BinRelocation> relocations;
+	QBitArray sectorFilter(0x10000); // Low 16 bits of old sectors
 #ifdef ISOARCHIVE_DEBUG
-	QMap<QByteArray, QString> filesDebug; // debug
+	QElapsedTimer t;
+	qint64 decompressTime, relocateTime, compressTime;
 #endif
 
 	foreach(IsoFile *file, filesRefByBin) {
@@ -221,10 +233,19 @@ bool IsoArchiveFF7::updateBin(IsoFile *isoBin, const QList<IsoFile *> &filesRefB
 			newSize = file->newSize();
 
 			if(oldSectorStart != newSectorStart || oldSize != newSize) {
-				QByteArray tempBA = QByteArray((char *)&oldSectorStart, 4).append((char *)&oldSize, 4);
-				changesFieldBin.insert(tempBA, QByteArray((char *)&newSectorStart, 4).append((char *)&newSize, 4));
+				quint64 key = (quint64(oldSectorStart) << 32) | oldSize;
+				int index = relocationIndexes.value(key, -1);
+				if(index < 0) {
+					index = relocations.size();
+					relocationIndexes.insert(key, index);
+					relocations.append(BinRelocation());
+					sectorFilter.setBit(oldSectorStart & 0xFFFF);
+				}
+				BinRelocation &relocation = relocations[index];
+				relocation.newSectorStart = newSectorStart;
+				relocation.newSize = newSize;
 #ifdef ISOARCHIVE_DEBUG
-				filesDebug.insert(tempBA, file->name());
+				relocation.fileName = file->name();
 				if(oldSectorStart != newSectorStart) {
 					qDebug() << "IsoArchiveFF7::updateBin File to update in" << isoBin->name() << file->name() << "position changed:" << oldSectorStart << newSectorStart << oldSize << newSize;
 				} else {
@@ -235,62 +256,114 @@ bool IsoArchiveFF7::updateBin(IsoFile *isoBin, const QList<IsoFile *> &filesRefB
 		}
 	}
 
+	if(relocations.isEmpty()) {
+		qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "nothing to update";
+		return true;
+	}
+
 	/*
 	 *	HEADER :
 	 *	 4 : ungzipped size
 	 *	 4 : ungzipped size - 51588
 	 */
 	// Gzip uncompress
+#ifdef ISOARCHIVE_DEBUG
+	t.start();
+#endif
 	ungzip = GZIPPS::decompress(data);
 	if(ungzip.isEmpty()) {
 		qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "unable to decompress";
 		return false;
 	}
+#ifdef ISOARCHIVE_DEBUG
+	decompressTime = t.restart();
+#endif
 
-	// Update
+	// Search every old (sector, size) pair in one pass
+	const char *constData = ungzip.constData();
+	for(int pos = 0 ; pos + 8 <= ungzip.size() ; ++pos) {
+		memcpy(&oldSectorStart, constData + pos, 4);
+		if(!sectorFilter.testBit(oldSectorStart & 0xFFFF)) {
+			continue;
+		}
+		memcpy(&oldSize, constData + pos + 4, 4);
+		int index = relocationIndexes.value((quint64(oldSectorStart) << 32) | oldSize, -1);
+		if(index >= 0) {
+			relocations[index].occurrences.append(pos);
+		}
+	}
 
-	QByteArray copy = ungzip;
-	QMapIterator<QByteArray, QByteArray> i(changesFieldBin);
-	while(i.hasNext()) {
-		i.next();
-		int count = copy.count(i.key());
-		if(count == 0) {
-			qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error not found!" << i.key().toHex();
+	// Choose one position per pair: the only one, or the only one after startOffset
+	QMap<int, int> patches; // position -> index in relocations
+	for(int index = 0 ; index < relocations.size() ; ++index) {
+		const BinRelocation &relocation = relocations.at(index);
+		int position = -1;
+		if(relocation.occurrences.isEmpty()) {
+			qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error not found!" << QString::number(relocationIndexes.key(index), 16);
 #ifdef ISOARCHIVE_DEBUG
-			qWarning() << "IsoArchiveFF7::updateBin" << filesDebug.value(i.key());
+			qWarning() << "IsoArchiveFF7::updateBin" << relocation.fileName;
 #endif
 			return false;
-		} else if(count == 1) {
-			startOffset = copy.indexOf(i.key());
-			ungzip.replace(startOffset, i.key().size(), i.value());
+		} else if(relocation.occurrences.size() == 1) {
+			position = relocation.occurrences.first();
 		} else {
-			qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error multiple occurrences 1" << i.key().toHex();
+			qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error multiple occurrences 1" << QString::number(relocationIndexes.key(index), 16);
 #ifdef ISOARCHIVE_DEBUG
-			qWarning() << "IsoArchiveFF7::updateBin" << filesDebug.value(i.key());
+			qWarning() << "IsoArchiveFF7::updateBin" << relocation.fileName;
 #endif
-			if(copy.mid(startOffset).count(i.key()) == 1) {
-				ungzip.replace(copy.indexOf(i.key(), startOffset), 8, i.value());
-			} else {
-				qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error multiple occurrences 2" << i.key().toHex();
+			foreach(int occurrence, relocation.occurrences) {
+				if(occurrence >= startOffset) {
+					if(position >= 0) {
+						position = -1;
+						break;
+					}
+					position = occurrence;
+				}
+			}
+			if(position < 0) {
+				qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error multiple occurrences 2" << QString::number(relocationIndexes.key(index), 16);
 #ifdef ISOARCHIVE_DEBUG
-				qWarning() << "IsoArchiveFF7::updateBin" << filesDebug.value(i.key());
+				qWarning() << "IsoArchiveFF7::updateBin" << relocation.fileName;
 #endif
 				return false;
 			}
 		}
+		patches.insert(position, index);
 	}
 
-	if (ungzip == copy) {
-		qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "nothing to update";
-		return true;
+	// Apply patches, they must not overlap
+	char *writeData = ungzip.data();
+	int lastEnd = 0;
+	QMapIterator<int, int> it(patches);
+	while(it.hasNext()) {
+		it.next();
+		if(it.key() < lastEnd) {
+			qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "Error overlapping entries at" << it.key();
+			return false;
+		}
+		const BinRelocation &relocation = relocations.at(it.value());
+		memcpy(writeData + it.key(), &relocation.newSectorStart, 4);
+		memcpy(writeData + it.key() + 4, &relocation.newSize, 4);
+		lastEnd = it.key() + 8;
 	}
+#ifdef ISOARCHIVE_DEBUG
+	relocateTime = t.restart();
+#endif
 
-	copy = GZIPPS::compress(ungzip, data.mid(4, 4), 9);
+	QByteArray copy = GZIPPS::compress(ungzip, data.mid(4, 4), 9);
 
 	if(copy.isEmpty()) {
 		qWarning() << "IsoArchiveFF7::updateBin" << isoBin->name() << "unable to compress";
 		return false;
 	}
+#ifdef ISOARCHIVE_DEBUG
+	compressTime = t.elapsed();
+
+	qDebug() << "IsoArchiveFF7::updateBin" << isoBin->name() << relocations.size() << "entries"
+	         << "decompress:" << decompressTime << "ms"
+	         << "relocate:" << relocateTime << "ms"
+	         << "compress:" << compressTime << "ms";
+#endif
 
 	QBuffer *buffer = new QBuffer();
 	buffer->setData(copy);
@@ -25,13 +25,21 @@
 **************************************************************/
 #include "LZS.h"
 
-qint32 LZS::match_length=0;//of longest match. These are set by the InsertNode() procedure.
-qint32 LZS::match_position=0;
-qint32 LZS::lson[4097];//left & right children & parents -- These constitute binary search trees.
-qint32 LZS::rson[4353];
-qint32 LZS::dad[4097];
-unsigned char LZS::text_buf[4113];//ring buffer of size 4096, with extra 17 bytes to facilitate string comparison
-QByteArray LZS::result;
+QThreadStorage<LZS::State *> LZS::states;
+
+/*!
+ * Returns the buffers of the current thread,
+ * so several threads can compress and decompress at the same time.
+ */
+LZS::State &LZS::state()
+{
+	if(!states.hasLocalData()) {
+		State *state = new State;
+		state->match_length = state->match_position = 0;
+		states.setLocalData(state);
+	}
+	return *states.localData();
+}
 
 const QByteArray &LZS::decompress(const QByteArray &data, int max)
 {
@@ -39,6 +47,11 @@ const QByteArray &LZS::decompress(const QByteArray &data, int max)
 }
 
 const QByteArray &LZS::decompress(const char *data, int fileSize, int max)
+{
+	return state().decompress(data, fileSize, max);
+}
+
+const QByteArray &LZS::State::decompress(const char *data, int fileSize, int max)
 {
 	int curResult=0, sizeAlloc=max+10;
 	quint16 curBuff=4078, adresse, premOctet=0, i, length;
@@ -108,6 +121,11 @@ const QByteArray &LZS::decompressAll(const QByteArray &data)
 }
 
 const QByteArray &LZS::decompressAll(const char *data, int fileSize)
+{
+	return state().decompressAll(data, fileSize);
+}
+
+const QByteArray &LZS::State::decompressAll(const char *data, int fileSize)
 {
 	int curResult=0, sizeAlloc=fileSize*5;
 	quint16 curBuff=4078, adresse, premOctet=0, i, length;
@@ -171,6 +189,8 @@ const QByteArray &LZS::decompressAllWithHeader(const QByteArray &data)
 
 const QByteArray &LZS::decompressAllWithHeader(const char *data, int size)
 {
+	QByteArray &result = state().result;
+
 	if (size < 4) {
 		result.clear();
 		return result;
@@ -187,7 +207,7 @@ const QByteArray &LZS::decompressAllWithHeader(const char *data, int size)
 	return LZS::decompressAll(data + 4, lzsSize);
 }
 
-void LZS::InsertNode(qint32 r)
+void LZS::State::InsertNode(qint32 r)
 {
 	/* Inserts string of length 18, text_buf[r..r+18-1], into one of the trees (text_buf[r]'th tree) and returns the longest-match position and length via the global variables match_position and match_length.
 	If match_length = 18, then removes the old node in favor of the new one, because the old one will be deleted sooner.
@@ -262,7 +282,7 @@ void LZS::InsertNode(qint32 r)
 	dad[p] = 4096;//remove p
 }
 
-void LZS::DeleteNode(qint32 p)//deletes node p from tree
+void LZS::State::DeleteNode(qint32 p)//deletes node p from tree
 {
 	qint32 q;
 	if(dad[p] == 4096)	return;//not in tree
@@ -314,6 +334,7 @@ const QByteArray &LZS::compressWithHeader(const QByteArray &fileData)
 
 const QByteArray &LZS::compressWithHeader(const char *data, int sizeData)
 {
+	QByteArray &result = state().result;
 	compress(data, sizeData);
 	quint32 lzsSize = result.size();
 	result.prepend((char *)&lzsSize, 4);
@@ -326,6 +347,11 @@ const QByteArray &LZS::compress(const QByteArray &fileData)
 }
 
 const QByteArray &LZS::compress(const char *data, int sizeData)
+{
+	return state().compress(data, sizeData);
+}
+
+const QByteArray &LZS::State::compress(const char *data, int sizeData)
 {
 	int i, c, len, r, s, code_buf_ptr,
 			curResult = 0, sizeAlloc = sizeData / 2;
@@ -439,5 +465,179 @@ const QByteArray &LZS::compress(const char *data, int sizeData)
 
 void LZS::clear()
 {
-	result.clear();
+	state().result.clear();
+}
+
+LZSDecoder::State::State() :
+	inPos(0), outPos(0), flags(0), ringPos(4078)
+{
+	memset(ring, 0, sizeof(ring));
+}
+
+LZSDecoder::LZSDecoder()
+{
+}
+
+void LZSDecoder::clear()
+{
+	_current = _initial;
+	_checkpointPositions.clear();
+	_checkpoints.clear();
+}
+
+/*!
+ * The next decoding passing through position will save its state,
+ * so decompress() can restart from there instead of the beginning.
+ */
+void LZSDecoder::addCheckpoint(int position)
+{
+	QList<int>::iterator it = qLowerBound(_checkpointPositions.begin(), _checkpointPositions.end(), position);
+	if(it == _checkpointPositions.end() || *it != position) {
+		_checkpointPositions.insert(it, position);
+	}
+}
+
+/*!
+ * Memory used by the decoding states, each one keeps its ring buffer.
+ */
+qint64 LZSDecoder::memorySize() const
+{
+	return qint64(2 + _checkpoints.size()) * sizeof(State)
+	        + _checkpointPositions.size() * sizeof(int);
+}
+
+const LZSDecoder::State &LZSDecoder::nearestState(int position) const
+{
+	if(_current.outPos <= position) {
+		return _current;
+	}
+
+	QMap<int, State>::const_iterator it = _checkpoints.upperBound(position);
+	while(it != _checkpoints.constBegin()) {
+		--it;
+		if(it.value().outPos <= position) {
+			return it.value();
+		}
+	}
+
+	return _initial;
+}
+
+/*!
+ * Decompresses length bytes from position (until the end if length < 0),
+ * data and size are the whole LZS stream, without the size header.
+ */
+QByteArray LZSDecoder::decompress(const char *data, int size, int position, int length)
+{
+	State state = nearestState(position);
+
+	if(length < 0) {
+		// One LZS byte gives at most 144/17 bytes
+		length = state.outPos + (size - state.inPos) * 9 - position;
+		if(length <= 0) {
+			return QByteArray();
+		}
+	}
+
+	QByteArray ret;
+
+	try {
+		ret.resize(length);
+	} catch(std::bad_alloc) {
+		return QByteArray();
+	}
+
+	decode(state, data, size, position, position + length, ret.data());
+
+	if(state.outPos < position + length) {
+		ret.truncate(qMax(0, state.outPos - position)); // End of data
+	}
+
+	if(state.outPos > _current.outPos) {
+		_current = state;
+	}
+
+	return ret;
+}
+
+/*!
+ * Continues decoding from state until stop (or the end of data),
+ * bytes in [start, stop[ are written in out.
+ */
+void LZSDecoder::decode(State &state, const char *data, int size,
+                        int start, int stop, char *out)
+{
+	const quint8 *fileData = (const quint8 *)data + state.inPos,
+	        *endFileData = (const quint8 *)data + size;
+	quint16 premOctet = state.flags, curBuff = state.ringPos;
+	int curResult = state.outPos;
+	quint8 *ring = state.ring;
+	QList<int>::const_iterator nextCheckpoint = qUpperBound(_checkpointPositions.constBegin(), _checkpointPositions.constEnd(), curResult);
+
+	while(curResult < stop) {
+		// Reads the next token without moving
+		quint16 flags = premOctet >> 1;
+		const quint8 *cur = fileData;
+		if((flags & 256) == 0) {
+			if(cur >= endFileData) {
+				break;
+			}
+			flags = *cur++ | 0xff00;
+		}
+		if(cur >= endFileData) {
+			break;
+		}
+
+		int length = 1;
+		if(!(flags & 1)) {
+			if(cur + 1 >= endFileData) {
+				break;
+			}
+			length = (cur[1] & 0xF) + 3;
+		}
+
+		// Saves the state before the token containing a checkpoint
+		while(nextCheckpoint != _checkpointPositions.constEnd() && *nextCheckpoint < curResult + length) {
+			if(!_checkpoints.contains(*nextCheckpoint)) {
+				State &checkpoint = _checkpoints[*nextCheckpoint];
+				checkpoint.inPos = fileData - (const quint8 *)data;
+				checkpoint.outPos = curResult;
+				checkpoint.flags = premOctet;
+				checkpoint.ringPos = curBuff;
+				memcpy(checkpoint.ring, ring, sizeof(checkpoint.ring));
+			}
+			++nextCheckpoint;
+		}
+
+		premOctet = flags;
+		fileData = cur;
+
+		if(premOctet & 1) {
+			const quint8 c = *fileData++;
+			ring[curBuff] = c;
+			curBuff = (curBuff + 1) & 4095;
+			if(curResult >= start) {
+				out[curResult - start] = c;
+			}
+			++curResult;
+		} else {
+			quint16 adresse = fileData[0] | ((fileData[1] & 0xF0) << 4);
+			fileData += 2;
+
+			for(int i=0 ; i<length ; ++i) {
+				const quint8 c = ring[(adresse + i) & 4095];
+				ring[curBuff] = c;
+				curBuff = (curBuff + 1) & 4095;
+				if(curResult >= start && curResult < stop) {
+					out[curResult - start] = c;
+				}
+				++curResult;
+			}
+		}
+	}
+
+	state.inPos = fileData - (const quint8 *)data;
+	state.outPos = curResult;
+	state.flags = premOctet;
+	state.ringPos = curBuff;
 }
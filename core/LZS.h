@@ -43,15 +43,51 @@ public:
 	static const QByteArray &compressWithHeader(const char *data, int sizeData);
 	static void clear();
 private:
-	static void InsertNode(qint32 r);
-	static void DeleteNode(qint32 p);
-	static qint32 match_length;//of longest match. These are set by the InsertNode() procedure.
-	static qint32 match_position;
-	static qint32 lson[4097];//left & right children & parents -- These constitute binary search trees.
-	static qint32 rson[4353];
-	static qint32 dad[4097];
-	static unsigned char text_buf[4113];//ring buffer of size 4096, with extra 17 bytes to facilitate string comparison
-	static QByteArray result;
+	// Buffers of one thread, returned arrays are valid until the next call in the same thread
+	struct State {
+		const QByteArray &decompress(const char *data, int fileSize, int max);
+		const QByteArray &decompressAll(const char *data, int fileSize);
+		const QByteArray &compress(const char *data, int sizeData);
+		void InsertNode(qint32 r);
+		void DeleteNode(qint32 p);
+		qint32 match_length;//of longest match. These are set by the InsertNode() procedure.
+		qint32 match_position;
+		qint32 lson[4097];//left & right children & parents -- These constitute binary search trees.
+		qint32 rson[4353];
+		qint32 dad[4097];
+		unsigned char text_buf[4113];//ring buffer of size 4096, with extra 17 bytes to facilitate string comparison
+		QByteArray result;
+	};
+	static State &state();
+	static QThreadStorage<State *> states;
+};
+
+/*
+ * Resumable LZS decoder: the decoder state is kept between calls,
+ * with a copy (checkpoint) before each registered output position.
+ * The compressed data must be the same for every call.
+ */
+class LZSDecoder
+{
+public:
+	LZSDecoder();
+	void clear();
+	void addCheckpoint(int position);
+	QByteArray decompress(const char *data, int size, int position, int length);
+	qint64 memorySize() const;
+private:
+	struct State {
+		State();
+		int inPos, outPos;
+		quint16 flags, ringPos;
+		quint8 ring[4096];
+	};
+	void decode(State &state, const char *data, int size,
+	            int start, int stop, char *out);
+	const State &nearestState(int position) const;
+	State _initial, _current;
+	QList<int> _checkpointPositions; // Sorted
+	QMap<int, State> _checkpoints;
 };
 
 #endif
@@ -23,6 +23,7 @@
 #include "Lgp.h"
 #include "Lgp_p.h"
 #include "QLockedFile.h"
+#include "ArchiveExtractor.h"
 
 /*!
  * You must use Lgp::iterator() instead.
@@ -279,7 +280,8 @@ bool Lgp::addFile(const QString &filePath, QIODevice *data)
 	LgpHeaderEntry *entry = headerEntry(filePath);// need to open the header
 	if(entry != NULL) return false;
 
-	entry = new LgpHeaderEntry(filePath, archiveIO()->size());
+	entry = new LgpHeaderEntry(QString(), archiveIO()->size());
+	entry->setFilePath(filePath);
 	entry->setModifiedFile(data);
 
 	bool ret = _files->addEntry(entry);
@@ -448,20 +450,20 @@ bool Lgp::openHeader()
 	}
 
 	const char *headerConstData = headerData.constData();
-	QList<LgpHeaderEntry *> tocEntries;
-	QList<quint16> headerConflict;
+	QVector<LgpHeaderEntry *> tocEntries(fileCount);
+	QVector<quint16> headerConflict(fileCount);
 	bool hasConflict = false;
 
-	for(qint32 cur=0; cur<sizeToc; cur += 27) {
+	for(qint32 i=0, cur=0; i<fileCount; ++i, cur += 27) {
 		quint32 filePos;
-		quint16 conflict;
+		quint16 &conflict = headerConflict[i];
 		memcpy(&filePos, headerConstData + cur + 20, 4);
 		memcpy(&conflict, headerConstData + cur + 25, 2);
-		tocEntries.append(new LgpHeaderEntry(
-							  headerData.mid(cur, 20),
-							  filePos));
-		headerConflict.append(conflict);
-		if(conflict != 0 && !hasConflict) {
+		const char *name = headerConstData + cur;
+		tocEntries[i] = new LgpHeaderEntry(
+		                    QString::fromLatin1(name, qstrnlen(name, 20)),
+		                    filePos);
+		if(conflict != 0) {
 			hasConflict = true;
 		}
 	}
@@ -474,6 +476,7 @@ bool Lgp::openHeader()
 
 		// Lookup table ignored
 		if(!archiveIO()->seek(archiveIO()->pos() + LOOKUP_TABLE_ENTRIES * 4)) {
+			qDeleteAll(tocEntries);
 			setError(PositionError);
 			return false;
 		}
@@ -482,15 +485,19 @@ bool Lgp::openHeader()
 		quint16 conflictCount;
 
 		if(archiveIO()->read((char *)&conflictCount, 2) != 2) {
+			qDeleteAll(tocEntries);
 			setError(ReadError);
 			return false;
 		}
 
+		conflicts.reserve(conflictCount);
+
 		for(qint32 i=0; i<conflictCount; ++i) {
 			quint16 conflictEntryCount;
 
 			// Open conflict entries
 			if(archiveIO()->read((char *)&conflictEntryCount, 2) != 2) {
+				qDeleteAll(tocEntries);
 				setError(ReadError);
 				return false;
 			}
@@ -499,20 +506,18 @@ bool Lgp::openHeader()
 			QByteArray conflictData = archiveIO()->read(sizeConflicData);
 
 			if(conflictData.size() != sizeConflicData) {
+				qDeleteAll(tocEntries);
 				setError(ReadError);
 				return false;
 			}
 
-			if(sizeConflicData < 0) {
-				setError(InvalidError);
-				return false;
-			}
-
 			const char *conflictConstData = conflictData.constData();
 			QList<LgpConflictEntry> conflictEntries;
 
 			for(qint32 cur=0; cur<sizeConflicData; cur += 130) {
-				LgpConflictEntry conflictEntry(conflictData.mid(cur, 128));
+				const char *dir = conflictConstData + cur;
+				LgpConflictEntry conflictEntry(
+				            QString::fromLatin1(dir, qstrnlen(dir, 128)));
 
 				memcpy(&conflictEntry.tocIndex, conflictConstData + cur + 128, 2);
 
@@ -526,20 +531,15 @@ bool Lgp::openHeader()
 
 	/* Populate _files */
 
-	int headerEntryID = 0;
-
 	_files->clear(); // This will delete entries
+	_files->reserve(fileCount);
 
-	foreach(LgpHeaderEntry *entry, tocEntries) {
-		if(!_files->addEntry(entry)) {
-			qWarning() << "Invalid toc name" << entry->fileName();
-			delete entry;
-			continue;
-		}
+	for(qint32 headerEntryID=0; headerEntryID<fileCount; ++headerEntryID) {
+		LgpHeaderEntry *entry = tocEntries.at(headerEntryID);
 
-		// Set fileDir
+		// Set fileDir before indexing the entry by its path
 		if(hasConflict) {
-			const quint16 &conflict = headerConflict.at(headerEntryID);
+			const quint16 conflict = headerConflict.at(headerEntryID);
 
 			if(conflict != 0) {
 				const quint16 conflictID = conflict - 1;
@@ -561,13 +561,330 @@ bool Lgp::openHeader()
 					qWarning() << "Unresolved conflict for" << entry->fileName();
 				}
 			}
-			++headerEntryID;
 		}
+
+		if(!_files->addEntry(entry)) {
+			qWarning() << "Invalid toc name" << entry->fileName();
+			delete entry;
+		}
+	}
+
+	return openFileSizes();
+}
+
+/*!
+ * Reads the size of every file in one sweep, sorted by
+ * position to keep the reads sequential.
+ */
+bool Lgp::openFileSizes()
+{
+	foreach(const LgpHeaderEntry *constEntry, _files->filesSortedByPosition()) {
+		LgpHeaderEntry *entry = const_cast<LgpHeaderEntry *>(constEntry);
+		char fileHeader[24];
+		quint32 size;
+
+		if(!archiveIO()->seek(entry->filePosition())
+		        || archiveIO()->read(fileHeader, 24) != 24) {
+			qWarning() << "Lgp::openFileSizes cannot read header"
+			           << entry->filePath();
+			continue; // Error is reported when opening this file
+		}
+
+		const QString name = QString::fromLatin1(fileHeader,
+		                                         qstrnlen(fileHeader, 20));
+
+		if(name.compare(entry->fileName(), Qt::CaseInsensitive) != 0) {
+			qWarning() << "Lgp::openFileSizes different name"
+			           << entry->filePath() << name;
+			continue;
+		}
+
+		memcpy(&size, fileHeader + 20, 4);
+		entry->setFileSize(size);
 	}
 
 	return true;
 }
 
+/*!
+ * Extracts every file into the \a destination directory,
+ * modified files are extracted with their new data.
+ * The archive is read in the order of the data, and
+ * the files are written in parallel.
+ * \a observer is used to notify the progression of the extraction.
+ * It can be NULL.
+ */
+bool Lgp::extractAll(const QString &destination, ArchiveObserver *observer)
+{
+	if(!isOpen()) {
+		setError(OpenError, QObject::tr("The archive is not open"));
+		return false;
+	}
+
+	QDir dir(destination);
+	ArchiveExtractor extractor(archiveIO());
+
+	foreach(const LgpHeaderEntry *constEntry, _files->filesSortedByPosition()) {
+		LgpHeaderEntry *entry = const_cast<LgpHeaderEntry *>(constEntry);
+
+		if(!entry->fileDir().isEmpty() && !dir.mkpath(entry->fileDir())) {
+			setError(PermissionsError, QObject::tr("Cannot create the directory %1").arg(entry->fileDir()));
+			return false;
+		}
+
+		QString path = dir.filePath(entry->filePath());
+
+		if(entry->hasModifiedFile()) {
+			extractor.addEntry(entry->modifiedFile(archiveIO()), path);
+		} else {
+			// Reads the file size if needed
+			if(!entry->hasFileSize() && entry->file(archiveIO()) == NULL) {
+				setError(InvalidError, QObject::tr("Cannot read %1").arg(entry->filePath()));
+				return false;
+			}
+			extractor.addEntry(entry->filePosition() + 24, entry->fileSize(), path);
+		}
+	}
+
+	if(!extractor.extract(observer)) {
+		if(observer && observer->observerWasCanceled()) {
+			setError(AbortError);
+		} else {
+			setError(WriteError, extractor.errorString());
+		}
+		return false;
+	}
+
+	return true;
+}
+
+typedef QHash<const LgpHeaderEntry *, LgpTocEntry> LgpTocEntries;
+
+/*
+ * Numbers the TOC entries, then builds the lookup table and the conflict
+ * table. Files with the same name are grouped in one pass per lookup value.
+ */
+static void buildLgpTables(const LgpToc &toc, LgpTocEntries &tocEntries,
+                           QList<const LgpHeaderEntry *> &tocOrder,
+                           QByteArray &lookupTableData, QByteArray &conflictsData)
+{
+	LgpLookupTableEntry lookupTable[LOOKUP_TABLE_ENTRIES];
+	QList< QList<LgpConflictEntry> > conflicts;
+	int tocIndex = 0;
+
+	for(int i=0; i<LOOKUP_TABLE_ENTRIES; ++i) {
+		// toc index initialization
+		foreach(const LgpHeaderEntry *headerEntry, toc.entries(i)) {
+			tocEntries.insert(headerEntry, LgpTocEntry(tocIndex++));
+			tocOrder.append(headerEntry);
+		}
+	}
+
+	for(int i=0; i<LOOKUP_TABLE_ENTRIES; ++i) {
+		QList<LgpHeaderEntry *> headerEntries = toc.entries(i);
+		QHash<QString, QList<const LgpHeaderEntry *> > sameNames;
+
+		foreach(const LgpHeaderEntry *headerEntry, headerEntries) {
+			sameNames[headerEntry->fileName().toLower()].append(headerEntry);
+		}
+
+		// Build list conflicts
+		foreach(const LgpHeaderEntry *headerEntry, headerEntries) {
+			const QList<const LgpHeaderEntry *> sameName = sameNames.value(headerEntry->fileName().toLower());
+
+			if(sameName.size() < 2 || tocEntries.value(headerEntry).conflict != 0) {
+				continue;
+			}
+
+			QList<LgpConflictEntry> conflictEntries;
+
+			foreach(const LgpHeaderEntry *headerEntry2, sameName) {
+				LgpTocEntry &tocEntry = tocEntries[headerEntry2];
+				tocEntry.conflict = conflicts.size() + 1;
+				conflictEntries.append(LgpConflictEntry(headerEntry2->fileDir(),
+				                                        tocEntry.tocIndex));
+			}
+
+			conflicts.append(conflictEntries);
+		}
+
+		// Build lookup table
+		lookupTable[i].tocOffset = headerEntries.isEmpty()
+				? 0 : tocEntries.value(headerEntries.first()).tocIndex + 1;
+		lookupTable[i].fileCount = headerEntries.size();
+	}
+
+	lookupTableData = QByteArray((char *)lookupTable, sizeof(lookupTable));
+
+	conflictsData.clear();
+	const quint16 conflictCount = conflicts.size();
+	conflictsData.append((char *)&conflictCount, 2);
+
+	foreach(const QList<LgpConflictEntry> &conflict, conflicts) {
+		quint16 conflictEntryCount = conflict.size();
+		conflictsData.append((char *)&conflictEntryCount, 2);
+
+		foreach(const LgpConflictEntry &conflictEntry, conflict) {
+			conflictsData.append(conflictEntry.fileDir.toLatin1().leftJustified(128, '\0', true));
+			conflictsData.append((char *)&conflictEntry.tocIndex, 2);
+		}
+	}
+}
+
+/*
+ * The TOC, in the same order as the tables built by buildLgpTables().
+ */
+static QByteArray lgpTocData(const QList<const LgpHeaderEntry *> &tocOrder,
+                             const LgpTocEntries &tocEntries,
+                             const QHash<const LgpHeaderEntry *, quint32> &filePositions)
+{
+	QByteArray tocData;
+
+	foreach(const LgpHeaderEntry *headerEntry, tocOrder) {
+		tocData.append(headerEntry->fileName().toLower().toLatin1().leftJustified(20, '\0', true));
+		quint32 filePos = filePositions.value(headerEntry);
+		tocData.append((char *)&filePos, 4);
+		tocData.append('\x0e');
+		quint16 conflict = tocEntries.value(headerEntry).conflict;
+		tocData.append((char *)&conflict, 2);
+	}
+
+	return tocData;
+}
+
+#define LGP_STREAMED_FILE_SIZE		4194304 // 4 MB
+#define LGP_MAX_PREFETCHED_SIZE		67108864 // 64 MB
+
+/*
+ * Reads the files to import in worker threads, in advance,
+ * so the archive can be written without waiting for each file.
+ * Big files are not read here, they are streamed by the writer.
+ */
+class LgpFilePrefetcher
+{
+	friend class LgpFilePrefetcherThread;
+public:
+	LgpFilePrefetcher(const QStringList &paths, const QList<qint64> &sizes);
+	~LgpFilePrefetcher();
+	bool take(int index, QByteArray &data);
+	static inline bool isStreamed(qint64 size) {
+		return size > LGP_STREAMED_FILE_SIZE;
+	}
+private:
+	void work();
+
+	QStringList _paths;
+	QList<qint64> _sizes;
+	QVector<QByteArray> _data;
+	QVector<bool> _ready, _failed;
+	int _next, _taken;
+	qint64 _prefetchedSize;
+	bool _stopped;
+	QMutex _mutex;
+	QWaitCondition _readyCondition, _spaceCondition;
+	QList<QThread *> _threads;
+};
+
+class LgpFilePrefetcherThread : public QThread
+{
+public:
+	explicit LgpFilePrefetcherThread(LgpFilePrefetcher *prefetcher) :
+		_prefetcher(prefetcher) {}
+protected:
+	void run() {
+		_prefetcher->work();
+	}
+private:
+	LgpFilePrefetcher *_prefetcher;
+};
+
+LgpFilePrefetcher::LgpFilePrefetcher(const QStringList &paths, const QList<qint64> &sizes) :
+	_paths(paths), _sizes(sizes), _data(paths.size()),
+	_ready(paths.size(), false), _failed(paths.size(), false),
+	_next(0), _taken(0), _prefetchedSize(0), _stopped(false)
+{
+	int threadCount = qBound(1, QThread::idealThreadCount(), qMax(1, paths.size()));
+	for(int i=0 ; i<threadCount ; ++i) {
+		QThread *thread = new LgpFilePrefetcherThread(this);
+		_threads.append(thread);
+		thread->start();
+	}
+}
+
+LgpFilePrefetcher::~LgpFilePrefetcher()
+{
+	_mutex.lock();
+	_stopped = true;
+	_spaceCondition.wakeAll();
+	_mutex.unlock();
+
+	foreach(QThread *thread, _threads) {
+		thread->wait();
+	}
+	qDeleteAll(_threads);
+}
+
+/*!
+ * Waits for the file \a index, files must be taken in order.
+ * \a data is empty for streamed files.
+ * Returns false if the file cannot be read or its size changed.
+ */
+bool LgpFilePrefetcher::take(int index, QByteArray &data)
+{
+	QMutexLocker locker(&_mutex);
+
+	while(!_ready.at(index)) {
+		_readyCondition.wait(&_mutex);
+	}
+
+	data = _data.at(index);
+	_data[index] = QByteArray();
+	_prefetchedSize -= data.size();
+	_taken = index + 1;
+	_spaceCondition.wakeAll();
+
+	return !_failed.at(index);
+}
+
+void LgpFilePrefetcher::work()
+{
+	forever {
+		int index;
+		{
+			QMutexLocker locker(&_mutex);
+			// The file expected by the writer is always read
+			while(!_stopped && _next < _paths.size() && _next > _taken
+			      && _prefetchedSize > LGP_MAX_PREFETCHED_SIZE) {
+				_spaceCondition.wait(&_mutex);
+			}
+			if(_stopped || _next >= _paths.size()) {
+				return;
+			}
+			index = _next++;
+		}
+
+		QByteArray data;
+		bool failed = false;
+
+		if(!isStreamed(_sizes.at(index))) {
+			QFile f(_paths.at(index));
+			if(f.open(QIODevice::ReadOnly)) {
+				data = f.readAll();
+				failed = data.size() != _sizes.at(index);
+			} else {
+				failed = true;
+			}
+		}
+
+		QMutexLocker locker(&_mutex);
+		_data[index] = data;
+		_failed[index] = failed;
+		_ready[index] = true;
+		_prefetchedSize += data.size();
+		_readyCondition.wakeAll();
+	}
+}
+
 /*!
  * Save the lgp into \a destination (or overwrite the
  * current archive if \a destination is empty).
@@ -629,83 +946,19 @@ bool Lgp::pack(const QString &destination, ArchiveObserver *observer)
 	}
 
 	// Lookup Table + conflicts
-	LgpLookupTableEntry lookupTable[LOOKUP_TABLE_ENTRIES];
-	QHash<const LgpHeaderEntry *, LgpTocEntry> tocEntries;
-	int tocIndex = 0;
-
-	for(int i=0; i<LOOKUP_TABLE_ENTRIES; ++i) {
-		// toc index initialization
-		foreach(const LgpHeaderEntry *headerEntry, _files->entries(i)) {
-			tocEntries.insert(headerEntry, LgpTocEntry(tocIndex++));
-		}
-	}
-
-	QList< QList<LgpConflictEntry> > conflicts;
-
-	for(int i=0; i<LOOKUP_TABLE_ENTRIES; ++i) {
-		QList<LgpHeaderEntry *> headerEntries = _files->entries(i);
-
-		// Build list conflicts
-		foreach(const LgpHeaderEntry *headerEntry, headerEntries) {
-			LgpTocEntry &tocEntry = tocEntries[headerEntry];
-
-			if(tocEntry.conflict == 0) {
-				QList<LgpConflictEntry> conflictEntries;
-
-				foreach(const LgpHeaderEntry *headerEntry2, headerEntries) {
-					if(headerEntry != headerEntry2 &&
-							headerEntry->fileName().compare(headerEntry2->fileName(),
-															Qt::CaseInsensitive) == 0) {
-						if(conflictEntries.isEmpty()) {
-							tocEntry.conflict = conflicts.size() + 1;
-
-							conflictEntries.append(LgpConflictEntry(headerEntry->fileDir(),
-																	tocEntry.tocIndex));
-						}
-
-						LgpTocEntry &tocEntry2 = tocEntries[headerEntry2];
-
-						tocEntry2.conflict = conflicts.size() + 1;
-
-						conflictEntries.append(LgpConflictEntry(headerEntry2->fileDir(),
-																tocEntry2.tocIndex));
-					}
-				}
-
-				if(!conflictEntries.isEmpty()) {
-					conflicts.append(conflictEntries);
-				}
-			}
-		}
-
-		// Build lookup table
-		lookupTable[i].tocOffset = headerEntries.isEmpty()
-				? 0 : tocEntries.value(headerEntries.first()).tocIndex + 1;
-		lookupTable[i].fileCount = headerEntries.size();
-	}
+	LgpTocEntries tocEntries;
+	QList<const LgpHeaderEntry *> tocOrder;
+	QByteArray lookupTableData, conflictsData;
+	buildLgpTables(*_files, tocEntries, tocOrder, lookupTableData, conflictsData);
 
 	// Write Lookup Table
-	if(temp.write((char *)lookupTable, sizeof(lookupTable)) != sizeof(lookupTable)) {
+	if(temp.write(lookupTableData) != lookupTableData.size()) {
 		temp.remove();
 		setError(WriteError, temp.errorString());
 		return false;
 	}
 
 	// Write conflicts
-	QByteArray conflictsData;
-	const quint16 conflictCount = conflicts.size();
-	conflictsData.append((char *)&conflictCount, 2);
-
-	foreach(const QList<LgpConflictEntry> &conflict, conflicts) {
-		quint16 conflictEntryCount = conflict.size();
-		conflictsData.append((char *)&conflictEntryCount, 2);
-
-		foreach(const LgpConflictEntry &conflictEntry, conflict) {
-			conflictsData.append(conflictEntry.fileDir.toLatin1().leftJustified(128, '\0', true));
-			conflictsData.append((char *)&conflictEntry.tocIndex, 2);
-		}
-	}
-
 	if(temp.write(conflictsData) != conflictsData.size()) {
 		temp.remove();
 		setError(WriteError, temp.errorString());
@@ -713,6 +966,7 @@ bool Lgp::pack(const QString &destination, ArchiveObserver *observer)
 	}
 
 	LgpToc newToc;
+	QHash<const LgpHeaderEntry *, quint32> filePositions;
 
 	// Write files
 	foreach(const LgpHeaderEntry *lgpEntry, _files->filesSortedByPosition()) {
@@ -735,6 +989,7 @@ bool Lgp::pack(const QString &destination, ArchiveObserver *observer)
 		newEntry->setFile(0);
 		newEntry->setModifiedFile(0);
 		newToc.addEntry(newEntry);
+		filePositions.insert(lgpEntry, newEntry->filePosition());
 
 		// Writes the file
 		QIODevice *io = modifiedFile(path);
@@ -764,6 +1019,7 @@ bool Lgp::pack(const QString &destination, ArchiveObserver *observer)
 			setError(WriteError, temp.errorString());
 			return false;
 		}
+		newEntry->setFileSize(size);
 		// File: writes data
 		if(temp.write(data) != size) {
 			temp.remove();
@@ -789,17 +1045,7 @@ bool Lgp::pack(const QString &destination, ArchiveObserver *observer)
 	}
 
 	// Header: TOC
-	QByteArray tocData;
-	for(int i=0; i<LOOKUP_TABLE_ENTRIES; ++i) {
-		foreach(const LgpHeaderEntry *headerEntry, newToc.entries(i)) {
-			tocData.append(headerEntry->fileName().toLower().toLatin1().leftJustified(20, '\0', true));
-			quint32 filePos = headerEntry->filePosition();
-			tocData.append((char *)&filePos, 4);
-			tocData.append('\x0e');
-			quint16 conflict = tocEntries.value(headerEntry).conflict;
-			tocData.append((char *)&conflict, 2);
-		}
-	}
+	const QByteArray tocData = lgpTocData(tocOrder, tocEntries, filePositions);
 
 	if(temp.write(tocData) != tocData.size()) {
 		temp.remove();
@@ -845,6 +1091,420 @@ bool Lgp::pack(const QString &destination, ArchiveObserver *observer)
 	return true;
 }
 
+/*!
+ * Replaces the content of the lgp by the files of \a sourceDir,
+ * subdirectories included, and saves it into \a destination
+ * (or overwrite the current archive if \a destination is empty).
+ * Every file is listed first, so the header is written
+ * before the data, in one pass. The files are read in advance
+ * by worker threads.
+ * \a observer is used to notify the progression of the save.
+ * It can be NULL.
+ */
+bool Lgp::packDirectory(const QString &sourceDir, const QString &destination, ArchiveObserver *observer)
+{
+	QDir dir(sourceDir);
+	if(!dir.exists()) {
+		setError(FileNotFoundError, QObject::tr("Directory '%1' not found").arg(sourceDir));
+		return false;
+	}
+
+	// Lists the files with their sizes
+	QMap<QString, QFileInfo> infos; // Sorted by relative path
+	QDirIterator it(dir.absolutePath(), QDir::Files, QDirIterator::Subdirectories);
+	while(it.hasNext()) {
+		it.next();
+		infos.insert(dir.relativeFilePath(it.filePath()), it.fileInfo());
+	}
+
+	LgpToc toc;
+	toc.reserve(infos.size());
+	QStringList paths;
+	QList<qint64> sizes;
+	QList<LgpHeaderEntry *> entries;
+
+	QMapIterator<QString, QFileInfo> itInfo(infos);
+	while(itInfo.hasNext()) {
+		itInfo.next();
+		const QString &filePath = itInfo.key();
+		int index = filePath.lastIndexOf('/');
+
+		if(!LgpToc::isNameValid(filePath)
+		        || filePath.size() - index - 1 > 20 || index > 128
+		        || itInfo.value().size() > 0xFFFFFFFFLL) {
+			setError(InvalidError, QObject::tr("Invalid file name or size: %1").arg(filePath));
+			return false;
+		}
+
+		LgpHeaderEntry *entry = new LgpHeaderEntry(QString(), 0);
+		entry->setFilePath(filePath);
+		entry->setFileSize(itInfo.value().size());
+		if(!toc.addEntry(entry)) {
+			delete entry;
+			setError(InvalidError, QObject::tr("Invalid file name: %1").arg(filePath));
+			return false;
+		}
+
+		entries.append(entry);
+		paths.append(itInfo.value().filePath());
+		sizes.append(itInfo.value().size());
+	}
+
+	const int nbFiles = entries.size();
+
+	// Header, lookup table and conflicts sizes are known: sets positions
+	LgpTocEntries tocEntries;
+	QList<const LgpHeaderEntry *> tocOrder;
+	QByteArray lookupTableData, conflictsData;
+	buildLgpTables(toc, tocEntries, tocOrder, lookupTableData, conflictsData);
+
+	QHash<const LgpHeaderEntry *, quint32> filePositions;
+	qint64 pos = 16 + nbFiles * 27 + lookupTableData.size() + conflictsData.size();
+
+	foreach(LgpHeaderEntry *entry, entries) {
+		if(pos + 24 + entry->fileSize() > 0xFFFFFFFFLL) {
+			setError(InvalidError, QObject::tr("The archive is too big"));
+			return false;
+		}
+		entry->setFilePosition(pos);
+		filePositions.insert(entry, pos);
+		pos += 24 + entry->fileSize();
+	}
+
+	QString destPath = destination;
+
+	if(destination.isEmpty()) {
+		QFileInfo fileInfo(*archiveIO());
+		destPath = fileInfo.absoluteFilePath();
+	}
+
+	// A new archive has no names yet
+	QString company = isOpen() || !_companyName.isNull() ? companyName() : QString(),
+	        product = isOpen() || !_productName.isNull() ? productName() : QString();
+	if(company.isEmpty()) {
+		company = LGP_DEFAULT_COMPANY_NAME;
+	}
+	if(product.isEmpty()) {
+		product = LGP_DEFAULT_PRODUCT_NAME;
+	}
+
+	const QByteArray companyNameData = company.toLatin1().rightJustified(LGP_COMPANY_NAME_SIZE, '\0', true),
+	        productNameData = product.toLatin1().leftJustified(LGP_PRODUCT_NAME_SIZE, '\0', true);
+
+	// Temporary file (same dir as destination)
+	QFile temp(destPath + ".temp");
+	if(!temp.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		setError(OpenError, temp.errorString());
+		return false;
+	}
+
+	QByteArray header = companyNameData;
+	header.append((char *)&nbFiles, 4);
+	header.append(lgpTocData(tocOrder, tocEntries, filePositions));
+	header.append(lookupTableData);
+	header.append(conflictsData);
+
+	if(temp.write(header) != header.size()) {
+		temp.remove();
+		setError(WriteError, temp.errorString());
+		return false;
+	}
+
+	if(observer) {
+		observer->setObserverMaximum(nbFiles);
+	}
+
+	LgpFilePrefetcher prefetcher(paths, sizes);
+	QByteArray buffer;
+
+	for(int fileId=0 ; fileId<nbFiles ; ++fileId) {
+		// Cancels if requested
+		if(observer) {
+			if(observer->observerWasCanceled()) {
+				temp.remove();
+				setError(AbortError);
+				return false;
+			}
+			observer->setObserverValue(fileId);
+		}
+
+		const LgpHeaderEntry *entry = entries.at(fileId);
+		const quint32 size = entry->fileSize();
+		QByteArray data;
+
+		if(!prefetcher.take(fileId, data)) {
+			temp.remove();
+			setError(ReadError, QObject::tr("Cannot read '%1' or its size has changed").arg(paths.at(fileId)));
+			return false;
+		}
+
+		// File: writes the name and the size
+		QByteArray fileHeader = entry->fileName().toLatin1().leftJustified(20, '\0', true);
+		fileHeader.append((char *)&size, 4);
+		if(temp.write(fileHeader) != 24) {
+			temp.remove();
+			setError(WriteError, temp.errorString());
+			return false;
+		}
+
+		// File: writes data
+		if(!LgpFilePrefetcher::isStreamed(size)) {
+			if(temp.write(data) != size) {
+				temp.remove();
+				setError(WriteError, temp.errorString());
+				return false;
+			}
+			continue;
+		}
+
+		QFile f(paths.at(fileId));
+		if(!f.open(QIODevice::ReadOnly)) {
+			temp.remove();
+			setError(OpenError, f.errorString());
+			return false;
+		}
+
+		buffer.resize(LGP_STREAMED_FILE_SIZE);
+		qint64 remaining = size, r;
+		while(remaining > 0 && (r = f.read(buffer.data(), qMin(remaining, qint64(buffer.size())))) > 0) {
+			if(temp.write(buffer.constData(), r) != r) {
+				break;
+			}
+			remaining -= r;
+		}
+
+		if(remaining != 0) {
+			temp.remove();
+			setError(WriteError, QObject::tr("Cannot copy '%1' or its size has changed").arg(paths.at(fileId)));
+			return false;
+		}
+	}
+
+	// Writes the product name (FINAL FANTASY7)
+	if(temp.write(productNameData) != LGP_PRODUCT_NAME_SIZE) {
+		temp.remove();
+		setError(WriteError, temp.errorString());
+		return false;
+	}
+
+	if(observer)	observer->setObserverValue(nbFiles);
+
+	archiveIO()->close();
+
+	// Remove destination file
+	if(QFile::exists(destPath)) {
+		QFile destFile(destPath);
+		if(!destFile.remove()) {
+			temp.remove();
+			setError(RemoveError, destFile.errorString());
+			return false;
+		}
+	}
+	// Move temp file to destination
+	if(!temp.rename(destPath)) {
+		temp.remove();
+		setError(RenameError, temp.errorString());
+		return false;
+	}
+
+	// Now the archive is located in "destination"
+	setFileName(destPath);
+
+	*_files = toc;
+	setError(NoError);
+
+	return true;
+}
+
+#define LGP_PATCH_MAGIC			"MRLGPPATCH"
+#define LGP_PATCH_MAGIC_SIZE	10
+#define LGP_PATCH_VERSION		1
+
+enum LgpPatchOperation {
+	LgpPatchWrite = 0,
+	LgpPatchRemove = 1
+};
+
+/*!
+ * Writes in \a patchPath the differences between the archive on disk
+ * and its pending modifications (modified, added, renamed and removed
+ * files), to be applied later with applyPatch().
+ * Operations are sorted by path, so the same changes always give
+ * the same patch.
+ */
+bool Lgp::createPatch(const QString &patchPath)
+{
+	Lgp base(fileName());
+	if(!archiveIO()->exists() || !base.open()) {
+		setError(OpenError, base.errorString());
+		return false;
+	}
+
+	QMap<QString, LgpHeaderEntry *> writes; // By file path key
+	QMap<QString, QString> removes;
+
+	foreach(LgpHeaderEntry *entry, _files->table()) {
+		if(entry->hasModifiedFile() || !base.fileExists(entry->filePath())) {
+			writes.insert(entry->filePathKey(), entry);
+		}
+	}
+
+	foreach(const QString &path, base.fileList()) {
+		if(!fileExists(path)) {
+			removes.insert(LgpToc::filePathKey(path), path);
+		}
+	}
+
+	QFile patch(patchPath);
+	if(!patch.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		setError(OpenError, patch.errorString());
+		return false;
+	}
+
+	QByteArray header(LGP_PATCH_MAGIC, LGP_PATCH_MAGIC_SIZE);
+	const quint16 version = LGP_PATCH_VERSION;
+	const qint64 baseSize = base.archiveIO()->size();
+	const qint32 baseFileCount = base.fileCount();
+	const quint32 operationCount = writes.size() + removes.size();
+	header.append((char *)&version, 2);
+	header.append((char *)&baseSize, 8);
+	header.append((char *)&baseFileCount, 4);
+	header.append((char *)&operationCount, 4);
+
+	if(patch.write(header) != header.size()) {
+		patch.remove();
+		setError(WriteError, patch.errorString());
+		return false;
+	}
+
+	foreach(const QString &path, removes) {
+		QByteArray operation;
+		const QByteArray pathData = path.toLatin1();
+		const quint16 pathSize = pathData.size();
+		operation.append(char(LgpPatchRemove));
+		operation.append((char *)&pathSize, 2);
+		operation.append(pathData);
+
+		if(patch.write(operation) != operation.size()) {
+			patch.remove();
+			setError(WriteError, patch.errorString());
+			return false;
+		}
+	}
+
+	foreach(LgpHeaderEntry *entry, writes) {
+		QIODevice *io = entry->modifiedFile(archiveIO());
+		if(io == NULL || !io->open(QIODevice::ReadOnly)) {
+			patch.remove();
+			setError(ReadError, QObject::tr("Cannot read '%1'").arg(entry->filePath()));
+			return false;
+		}
+		const QByteArray data = io->readAll();
+		io->close();
+
+		QByteArray operation;
+		const QByteArray pathData = entry->filePath().toLatin1(),
+		        compressed = qCompress(data, 9);
+		const quint16 pathSize = pathData.size();
+		const quint32 compressedSize = compressed.size();
+		operation.append(char(LgpPatchWrite));
+		operation.append((char *)&pathSize, 2);
+		operation.append(pathData);
+		operation.append((char *)&compressedSize, 4);
+		operation.append(compressed);
+
+		if(patch.write(operation) != operation.size()) {
+			patch.remove();
+			setError(WriteError, patch.errorString());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Applies the patch \a patchPath, made by createPatch() from this
+ * archive, then saves the result into \a destination (or overwrite the
+ * current archive if \a destination is empty), see pack().
+ * The archive must not have other modifications.
+ */
+bool Lgp::applyPatch(const QString &patchPath, const QString &destination, ArchiveObserver *observer)
+{
+	QFile patch(patchPath);
+	if(!patch.open(QIODevice::ReadOnly)) {
+		setError(OpenError, patch.errorString());
+		return false;
+	}
+
+	quint16 version;
+	qint64 baseSize;
+	qint32 baseFileCount;
+	quint32 operationCount;
+
+	if(patch.read(LGP_PATCH_MAGIC_SIZE) != QByteArray(LGP_PATCH_MAGIC, LGP_PATCH_MAGIC_SIZE)
+	        || patch.read((char *)&version, 2) != 2
+	        || version != LGP_PATCH_VERSION
+	        || patch.read((char *)&baseSize, 8) != 8
+	        || patch.read((char *)&baseFileCount, 4) != 4
+	        || patch.read((char *)&operationCount, 4) != 4) {
+		setError(InvalidError, QObject::tr("Invalid patch"));
+		return false;
+	}
+
+	if(baseSize != archiveIO()->size() || baseFileCount != fileCount()) {
+		setError(InvalidError, QObject::tr("This patch was made for another archive"));
+		return false;
+	}
+
+	for(quint32 i=0 ; i<operationCount ; ++i) {
+		char operation;
+		quint16 pathSize;
+
+		if(!patch.getChar(&operation)
+		        || patch.read((char *)&pathSize, 2) != 2) {
+			setError(InvalidError, QObject::tr("Invalid patch"));
+			return false;
+		}
+
+		const QByteArray pathData = patch.read(pathSize);
+		if(pathData.size() != pathSize) {
+			setError(InvalidError, QObject::tr("Invalid patch"));
+			return false;
+		}
+		const QString path = QString::fromLatin1(pathData);
+		bool ok;
+
+		if(operation == LgpPatchRemove) {
+			ok = removeFile(path);
+		} else if(operation == LgpPatchWrite) {
+			quint32 compressedSize;
+			if(patch.read((char *)&compressedSize, 4) != 4) {
+				setError(InvalidError, QObject::tr("Invalid patch"));
+				return false;
+			}
+			const QByteArray compressed = patch.read(compressedSize);
+			const QByteArray data = qUncompress(compressed);
+			// qCompress() gives 4 bytes for an empty file
+			if(quint32(compressed.size()) != compressedSize
+			        || (data.isEmpty() && compressedSize > 4)) {
+				setError(InvalidError, QObject::tr("Invalid patch"));
+				return false;
+			}
+			ok = fileExists(path) ? setFileData(path, data) : addFileData(path, data);
+		} else {
+			ok = false;
+		}
+
+		if(!ok) {
+			setError(InvalidError, QObject::tr("Cannot apply the patch to '%1'").arg(path));
+			return false;
+		}
+	}
+
+	return pack(destination, observer);
+}
+
 /*!
  * Returns the last error status.
  * \sa unsetError(), errorString()
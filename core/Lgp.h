@@ -93,11 +93,16 @@ public:
 	const QString &productName();
 	void setProductName(const QString &productName);
 	bool pack(const QString &destination=QString(), ArchiveObserver *observer=NULL);
+	bool packDirectory(const QString &sourceDir, const QString &destination=QString(), ArchiveObserver *observer=NULL);
+	bool extractAll(const QString &destination, ArchiveObserver *observer=NULL);
+	bool createPatch(const QString &patchPath);
+	bool applyPatch(const QString &patchPath, const QString &destination=QString(), ArchiveObserver *observer=NULL);
 	LgpError error() const;
 	void unsetError();
 private:
 	Q_DISABLE_COPY(Lgp)
 	bool openHeader();
+	bool openFileSizes();
 	bool openCompanyName();
 	bool openProductName();
 	LgpHeaderEntry *headerEntry(const QString &filePath) const;
@@ -26,6 +26,7 @@ LgpHeaderEntry::LgpHeaderEntry(const QString &fileName, quint32 filePosition) :
 	_fileName(fileName), _filePosition(filePosition),
 	_hasFileSize(false), _io(NULL), _newIO(NULL)
 {
+	updateFilePathKey();
 }
 
 LgpHeaderEntry::~LgpHeaderEntry()
@@ -75,6 +76,7 @@ void LgpHeaderEntry::setFileName(const QString &fileName)
 	} else {
 		_fileName = fileName;
 	}
+	updateFilePathKey();
 }
 
 void LgpHeaderEntry::setFileDir(const QString &fileDir)
@@ -84,6 +86,7 @@ void LgpHeaderEntry::setFileDir(const QString &fileDir)
 	} else {
 		_fileDir = fileDir;
 	}
+	updateFilePathKey();
 }
 
 void LgpHeaderEntry::setFilePath(const QString &filePath)
@@ -98,6 +101,11 @@ void LgpHeaderEntry::setFilePath(const QString &filePath)
 	}
 }
 
+void LgpHeaderEntry::updateFilePathKey()
+{
+	_filePathKey = LgpToc::filePathKey(filePath());
+}
+
 void LgpHeaderEntry::setFilePosition(quint32 filePosition)
 {
 	_filePosition = filePosition;
@@ -141,6 +149,13 @@ void LgpHeaderEntry::setModifiedFile(QIODevice *io)
 
 QIODevice *LgpHeaderEntry::createFile(QIODevice *lgp)
 {
+	// Size already known (see Lgp::openFileSizes)
+	if(_hasFileSize) {
+		QIODevice *io = new LgpIO(lgp, this);
+		setFile(io);
+		return io;
+	}
+
 	if(!lgp->seek(filePosition())) {
 		return NULL;
 	}
@@ -221,6 +236,7 @@ LgpToc::LgpToc()
 
 LgpToc::LgpToc(const LgpToc &other)
 {
+	reserve(other.size());
 	foreach(LgpHeaderEntry *headerEntry, other.table()) {
 		addEntry(new LgpHeaderEntry(*headerEntry));
 	}
@@ -231,6 +247,12 @@ LgpToc::~LgpToc()
 	qDeleteAll(_header);
 }
 
+/*!
+ * Adds \a entry to the toc, the file path of the entry
+ * must be complete (dir + name) before calling this method.
+ * Returns false if the name is invalid or if the file path
+ * already exists.
+ */
 bool LgpToc::addEntry(LgpHeaderEntry *entry)
 {
 	qint32 v = lookupValue(entry->fileName());
@@ -238,23 +260,28 @@ bool LgpToc::addEntry(LgpHeaderEntry *entry)
 		return false;
 	}
 
-	if(contains(entry->fileName())) {
+	if(_paths.contains(entry->filePathKey())) {
 		return false;
 	}
 
 	_header.insert(v, entry);
+	_paths.insert(entry->filePathKey(), entry);
 
 	return true;
 }
 
-LgpHeaderEntry *LgpToc::entry(const QString &filePath) const
+/*!
+ * Preallocates memory for at least \a size entries.
+ */
+void LgpToc::reserve(int size)
 {
-	qint32 v = lookupValue(filePath);
-	if(v < 0) {
-		return NULL; // invalid file name
-	}
+	_header.reserve(size);
+	_paths.reserve(size);
+}
 
-	return entry(filePath, v);
+LgpHeaderEntry *LgpToc::entry(const QString &filePath) const
+{
+	return _paths.value(filePathKey(filePath));
 }
 
 QList<LgpHeaderEntry *> LgpToc::entries(quint16 id) const
@@ -272,17 +299,6 @@ bool LgpToc::hasEntries(quint16 id) const
 	return _header.contains(id);
 }
 
-LgpHeaderEntry *LgpToc::entry(const QString &filePath, quint16 id) const
-{
-	foreach(LgpHeaderEntry *entry, entries(id)) {
-		if(filePath.compare(entry->filePath(), Qt::CaseInsensitive) == 0) {
-			return entry;
-		}
-	}
-
-	return NULL; // file not found
-}
-
 bool LgpToc::removeEntry(const QString &filePath)
 {
 	qint32 v = lookupValue(filePath);
@@ -296,6 +312,7 @@ bool LgpToc::removeEntry(const QString &filePath)
 	}
 
 	bool ok = _header.remove(v, e) > 0;
+	_paths.remove(e->filePathKey());
 
 	delete e;
 
@@ -317,7 +334,7 @@ bool LgpToc::renameEntry(const QString &filePath, const QString &newFilePath)
 		return false; // invalid file name
 	}
 
-	LgpHeaderEntry *e = entry(filePath, v);
+	LgpHeaderEntry *e = entry(filePath);
 	if(e == NULL) {
 		qWarning() << "LgpToc::renameEntry file not found" << filePath;
 		return false; // file not found
@@ -331,7 +348,7 @@ bool LgpToc::renameEntry(const QString &filePath, const QString &newFilePath)
 		return false; // invalid file name
 	}
 
-	if(entry(newFilePath, newV) != NULL) {
+	if(contains(newFilePath)) {
 		qWarning() << "LgpToc::renameEntry new file exists" << newFilePath;
 		return false; // file found
 	}
@@ -342,9 +359,11 @@ bool LgpToc::renameEntry(const QString &filePath, const QString &newFilePath)
 		qWarning() << "LgpToc::renameEntry cannot remove entry";
 		return false;
 	}
+	_paths.remove(e->filePathKey());
 
 	e->setFilePath(newFilePath);
 	_header.insert(newV, e);
+	_paths.insert(e->filePathKey(), e);
 
 	return true;
 }
@@ -359,6 +378,7 @@ void LgpToc::clear()
 	qDeleteAll(_header);
 
 	_header.clear();
+	_paths.clear();
 }
 
 bool LgpToc::isEmpty() const
@@ -371,21 +391,31 @@ int LgpToc::size() const
 	return _header.size();
 }
 
+static bool filePositionLessThan(const LgpHeaderEntry *e1,
+                                 const LgpHeaderEntry *e2)
+{
+	return e1->filePosition() < e2->filePosition();
+}
+
 QList<const LgpHeaderEntry *> LgpToc::filesSortedByPosition() const
 {
-	QMultiMap<quint32, const LgpHeaderEntry *> ret;
+	QList<const LgpHeaderEntry *> ret;
+	ret.reserve(_header.size());
 
 	foreach(const LgpHeaderEntry *entry, _header) {
-		ret.insert(entry->filePosition(), entry);
+		ret.append(entry);
 	}
 
-	return ret.values();
+	qStableSort(ret.begin(), ret.end(), filePositionLessThan);
+
+	return ret;
 }
 
 LgpToc &LgpToc::operator=(const LgpToc &other)
 {
 	if(this != &other) {
 		clear();
+		reserve(other.size());
 		foreach(LgpHeaderEntry *headerEntry, other.table()) {
 			addEntry(new LgpHeaderEntry(*headerEntry));
 		}
@@ -394,6 +424,15 @@ LgpToc &LgpToc::operator=(const LgpToc &other)
 	return *this;
 }
 
+/*!
+ * Returns the key used to index \a filePath,
+ * file paths are case insensitive.
+ */
+QString LgpToc::filePathKey(const QString &filePath)
+{
+	return filePath.toLower();
+}
+
 qint32 LgpToc::lookupValue(const QString &filePath)
 {
 	int index = filePath.lastIndexOf('/');
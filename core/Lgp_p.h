@@ -27,6 +27,8 @@
 
 #define LGP_COMPANY_NAME_SIZE	12
 #define LGP_PRODUCT_NAME_SIZE	14
+#define LGP_DEFAULT_COMPANY_NAME	"SQUARESOFT"
+#define LGP_DEFAULT_PRODUCT_NAME	"FINAL FANTASY7"
 
 #define LOOKUP_VALUE_MAX 30
 #define LOOKUP_TABLE_ENTRIES LOOKUP_VALUE_MAX * LOOKUP_VALUE_MAX
@@ -75,8 +77,17 @@ public:
 	const QString &fileName() const;
 	const QString &fileDir() const;
 	QString filePath() const;
+	inline const QString &filePathKey() const {
+		return _filePathKey;
+	}
 	quint32 filePosition() const;
 	qint64 fileSize() const;
+	inline bool hasFileSize() const {
+		return _hasFileSize;
+	}
+	inline bool hasModifiedFile() const {
+		return _newIO != NULL;
+	}
 	void setFileName(const QString &fileName);
 	void setFileDir(const QString &fileDir);
 	void setFilePath(const QString &filePath);
@@ -88,8 +99,10 @@ public:
 	void setModifiedFile(QIODevice *io);
 private:
 	QIODevice *createFile(QIODevice *lgp);
+	void updateFilePathKey();
 	QString _fileName;
 	QString _fileDir;
+	QString _filePathKey;
 	quint32 _filePosition;
 	quint32 _fileSize;
 	bool _hasFileSize;
@@ -121,6 +134,7 @@ public:
 	LgpToc(const LgpToc &other);
 	virtual ~LgpToc();
 	bool addEntry(LgpHeaderEntry *entry);
+	void reserve(int size);
 	LgpHeaderEntry *entry(const QString &filePath) const;
 	QList<LgpHeaderEntry *> entries(quint16 id) const;
 	const QMultiHash<quint16, LgpHeaderEntry *> &table() const;
@@ -134,11 +148,13 @@ public:
 	int size() const;
 	QList<const LgpHeaderEntry *> filesSortedByPosition() const;
 	LgpToc &operator=(const LgpToc &other);
+	static QString filePathKey(const QString &filePath);
 private:
-	LgpHeaderEntry *entry(const QString &filePath, quint16 id) const;
 	static qint32 lookupValue(const QString &filePath);
 	static quint8 lookupValue(const QChar &qc);
 	QMultiHash<quint16, LgpHeaderEntry *> _header;
+	// Lowercase file path => entry
+	QHash<QString, LgpHeaderEntry *> _paths;
 };
 
 #endif // LGP_P_H
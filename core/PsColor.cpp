@@ -22,7 +22,34 @@ quint16 PsColor::toPsColor(const QRgb &color)
 	return (qRound(qRed(color)/COEFF_COLOR) & 31) | ((qRound(qGreen(color)/COEFF_COLOR) & 31) << 5) | ((qRound(qBlue(color)/COEFF_COLOR) & 31) << 10) | ((qAlpha(color)==255) << 15);
 }
 
-QRgb PsColor::fromPsColor(quint16 color, bool useAlpha)
+/*!
+ * Converts count PS colors, data can be unaligned.
+ */
+void PsColor::fromPsColors(const char *data, int count, QRgb *out, bool useAlpha)
 {
-	return qRgba(qRound((color & 31)*COEFF_COLOR), qRound((color>>5 & 31)*COEFF_COLOR), qRound((color>>10 & 31)*COEFF_COLOR), color == 0 && useAlpha ? 0 : 255);
+	quint16 color;
+
+	for(int i=0 ; i<count ; ++i) {
+		memcpy(&color, data + i*2, 2);
+		out[i] = fromPsColor(color, useAlpha);
+	}
+}
+
+bool PsColor::fillLut()
+{
+	for(int color=0 ; color<0x8000 ; ++color) {
+		lut[color] = qRgb(components[color & 31],
+		                  components[color >> 5 & 31],
+		                  components[color >> 10 & 31]);
+	}
+	return true;
 }
+
+// qRound(i * COEFF_COLOR)
+const quint8 PsColor::components[32] = {
+	0, 8, 16, 25, 33, 41, 49, 58, 66, 74, 82, 90, 99, 107, 115, 123,
+	132, 140, 148, 156, 165, 173, 181, 189, 197, 206, 214, 222, 230, 239, 247, 255
+};
+
+QRgb PsColor::lut[0x8000];
+bool PsColor::lutFilled = PsColor::fillLut();
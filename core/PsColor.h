@@ -26,7 +26,19 @@ class PsColor
 {
 public:
 	static quint16 toPsColor(const QRgb &color);
-	static QRgb fromPsColor(quint16 color, bool useAlpha=false);
+	static inline QRgb fromPsColor(quint16 color, bool useAlpha=false) {
+		return color == 0 && useAlpha ? qRgba(0, 0, 0, 0) : lut[color & 0x7FFF];
+	}
+	static void fromPsColors(const char *data, int count, QRgb *out, bool useAlpha=false);
+	// 5 bits color component to 8 bits
+	static inline quint8 fromComponent(quint8 component) {
+		return components[component & 31];
+	}
+private:
+	static const quint8 components[32];
+	static QRgb lut[0x8000];
+	static bool lutFilled;
+	static bool fillLut();
 };
 
 #endif // DEF_PSCOLOR
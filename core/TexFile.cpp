@@ -85,9 +85,9 @@ bool TexFile::open(const QByteArray &data)
 
 		_image.setColorTable(_colorTables.first());
 
-		for(i=0 ; i<imageSectionSize ; ++i)
+		for(quint32 y=0 ; y<h ; ++y)
 		{
-			_image.setPixel(i % w, i / w, (quint8)data.at(imageStart+i));
+			memcpy(_image.scanLine(y), constData + imageStart + y*w, w);
 		}
 
 		if(header.hasColorKeyArray) {
@@ -100,18 +100,16 @@ bool TexFile::open(const QByteArray &data)
     }
     else
     {
-		quint16 color;
 		_image = QImage(w, h, QImage::Format_ARGB32);
 		QRgb *pixels = (QRgb *)_image.bits();
 
-		for(i=0 ; i<imageSectionSize ; i+=header.bytesPerPixel) {
-			if(header.bytesPerPixel == 2) {
-				memcpy(&color, &constData[headerSize+i], 2);
-				pixels[i/2] = PsColor::fromPsColor(color);
-			} else if(header.bytesPerPixel == 3) {
+		if(header.bytesPerPixel == 2) {
+			PsColor::fromPsColors(&constData[headerSize], w * h, pixels);
+		} else if(header.bytesPerPixel == 3) {
+			for(i=0 ; i<imageSectionSize ; i+=3) {
 				pixels[i/3] = qRgb(constData[headerSize+i], constData[headerSize+i+1], constData[headerSize+i+2]);
 			}
-        }
+		}
 	}
 
     return true;
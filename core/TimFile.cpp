@@ -45,7 +45,7 @@ bool TimFile::open(const QByteArray &data)
 {
 	//	QTime t;t.start();
 
-	quint32 palSize=0, imgSize=0, color=0;
+	quint32 palSize=0, imgSize=0;
 	quint16 w, h;
 	const char *constData = data.constData();
 	bool hasPal;
@@ -93,12 +93,8 @@ bool TimFile::open(const QByteArray &data)
 			int pos=0;
 			for(int i=0 ; i<nbPal ; ++i)
 			{
-				QVector<QRgb> pal;
-
-				for(quint16 j=0 ; j<onePalSize ; ++j) {
-					memcpy(&color, &constData[20+pos*2+j*2], 2);
-					pal.append(PsColor::fromPsColor(color, true));
-				}
+				QVector<QRgb> pal(onePalSize);
+				PsColor::fromPsColors(&constData[20+pos*2], onePalSize, pal.data(), true);
 
 				_colorTables.append(pal);
 
@@ -142,10 +138,8 @@ bool TimFile::open(const QByteArray &data)
 		_image.setColorTable(_colorTables.first());
 	}
 	//_image.fill(QColor(0, 0, 0, 0));
-	QRgb *pixels = (QRgb *)_image.bits();
 
-	int size, i=0;
-	quint32 x=0, y=0;
+	int size;
 
 	if(bpp!=0) {
 		size = qMin((quint32)(12 + w*h*bpp), dataSize - 8 - palSize);
@@ -156,73 +150,39 @@ bool TimFile::open(const QByteArray &data)
 	if(8 + palSize + size > (quint32)dataSize)
 		return false;
 
-	if(bpp==0)//mag176, icon
+	// Convert row by row, the last one can be truncated
+	const uchar *imgData = (const uchar *)constData + 20 + palSize;
+	int available = dataSize - 20 - palSize,
+	        rowSize = bpp==0 ? w/2 : w*bpp;
+
+	for(int y=0 ; y<h && y*rowSize < available ; ++y)
 	{
-		while(i<size && y<h)
-		{
-			_image.setPixel(x, y, (quint8)data.at(20+palSize+i) & 0xF);
-			++x;
-			if(x==w)
-			{
-				x = 0;
-				++y;
-			}
+		const uchar *row = imgData + y*rowSize;
+		int rowBytes = qMin(rowSize, available - y*rowSize);
 
-			_image.setPixel(x, y, (quint8)data.at(20+palSize+i) >> 4);
-			++x;
-			if(x==w)
-			{
-				x = 0;
-				++y;
+		if(bpp==0)//mag176, icon
+		{
+			uchar *pixels = _image.scanLine(y);
+			for(int i=0 ; i<rowBytes ; ++i) {
+				pixels[i*2] = row[i] & 0xF;
+				pixels[i*2 + 1] = row[i] >> 4;
 			}
-			++i;
 		}
-	}
-	else if(bpp==1)
-	{
-		while(i<size && y<h)
+		else if(bpp==1)
 		{
-			_image.setPixel(x, y, (quint8)data.at(20+palSize+i));
-
-			++x;
-			if(x==w)
-			{
-				x = 0;
-				++y;
-			}
-			++i;
+			memcpy(_image.scanLine(y), row, rowBytes);
 		}
-	}
-	else if(bpp==2)
-	{
-		while(i<size && y<h)
+		else if(bpp==2)
 		{
-			memcpy(&color, &constData[20+palSize+i], 2);
-			pixels[x + y*w] = PsColor::fromPsColor(color, true);
-
-			++x;
-			if(x==w)
-			{
-				x = 0;
-				++y;
-			}
-			i+=2;
+			PsColor::fromPsColors((const char *)row, rowBytes / 2,
+			                      (QRgb *)_image.scanLine(y), true);
 		}
-	}
-	else if(bpp==3)
-	{
-		while(i<size && y<h)
+		else if(bpp==3)
 		{
-			memcpy(&color, &constData[20+palSize+i], 3);
-			pixels[x + y*w] = qRgb(color >> 16, (color >> 8) & 0xFF, color & 0xFF);
-
-			++x;
-			if(x==w)
-			{
-				x = 0;
-				++y;
+			QRgb *pixels = (QRgb *)_image.scanLine(y);
+			for(int x=0 ; x<rowBytes/3 ; ++x) {
+				pixels[x] = qRgb(row[x*3 + 2], row[x*3 + 1], row[x*3]);
 			}
-			i+=3;
 		}
 	}
 
@@ -82,6 +82,7 @@ bool Var::save(const QMap<quint16, QString> &varNames)
 	QFile fic(Config::value("varFile").toString());
 	if(fic.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
 		_varNames = varNames;
+		++_revision;
 		QMapIterator<quint16, QString> i(_varNames);
 		while(i.hasNext()) {
 			i.next();
@@ -99,6 +100,7 @@ bool Var::save(const QMap<quint16, QString> &varNames)
 }
 
 QMap<quint16, QString> Var::_varNames;
+quint32 Var::_revision = 0;
 
 QString Var::name(quint8 bank, quint8 address)
 {
@@ -108,11 +110,13 @@ QString Var::name(quint8 bank, quint8 address)
 void Var::set(quint8 bank, quint8 address, const QString &name)
 {
 	_varNames.insert(address | (bank << 8), name);
+	++_revision;
 }
 
 void Var::del(quint8 bank, quint8 address)
 {
 	_varNames.remove(address | (bank << 8));
+	++_revision;
 }
 
 bool Var::exists(quint8 bank, quint8 address)
@@ -32,9 +32,14 @@ public:
 	static void set(quint8 bank, quint8 address, const QString &name);
 	static void del(quint8 bank, quint8 address);
 	static bool exists(quint8 bank, quint8 address);
+	// Changes when a name is modified
+	static inline quint32 revision() {
+		return _revision;
+	}
 
 private:
 	static QMap<quint16, QString> _varNames;
+	static quint32 _revision;
 };
 
 #endif
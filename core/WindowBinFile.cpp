@@ -27,6 +27,9 @@ void WindowBinFile::clear()
 {
 	_charWidth.clear();
 	_font.clear();
+	_font2.clear();
+	_atlas.clear();
+	_atlas2.clear();
 }
 
 bool WindowBinFile::open(const QString &path)
@@ -82,6 +85,8 @@ bool WindowBinFile::open(const QByteArray &data)
 		return false;
 	}
 
+	buildAtlas();
+
 	return true;
 }
 
@@ -147,6 +152,27 @@ bool WindowBinFile::openFontSize(const QByteArray &data)
 	return true;
 }
 
+/*!
+ * Renders the font once per color table,
+ * to draw letters without switching palettes.
+ */
+void WindowBinFile::buildAtlas()
+{
+	_atlas.resize(_font.colorTableCount());
+	for(int i=0 ; i<_atlas.size() ; ++i) {
+		_font.setCurrentColorTable(i);
+		_atlas[i] = _font.image().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+	}
+
+	if(isJp()) {
+		_atlas2.resize(_font2.colorTableCount());
+		for(int i=0 ; i<_atlas2.size() ; ++i) {
+			_font2.setCurrentColorTable(i);
+			_atlas2[i] = _font2.image().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+		}
+	}
+}
+
 const QImage &WindowBinFile::image(FontColor color)
 {
 	_font.setCurrentColorTable(palette(color, 0));//TODO: idk
@@ -163,15 +189,22 @@ QRect WindowBinFile::letterRect(int charId)
 
 QImage WindowBinFile::letter(quint8 table, quint8 id, FontColor color)
 {
-	if(table >= 4) {
-		if(isJp()) {
-			_font2.setCurrentColorTable(palette(color, table));
-			return _font2.image().copy(letterRect(id));
-		}
-		return QImage();
-	}
-	_font.setCurrentColorTable(palette(color, table));
-	return _font.image().copy(letterRect((table % 2) * 231 + id));
+	return letterAtlas(table, color).copy(letterRect(table, id));
+}
+
+/*!
+ * Image containing the letters of the table,
+ * see letterRect() to get the position of a letter.
+ */
+QImage WindowBinFile::letterAtlas(quint8 table, FontColor color) const
+{
+	const QVector<QImage> &atlas = table >= 4 ? _atlas2 : _atlas;
+	return atlas.value(palette(color, table));
+}
+
+QRect WindowBinFile::letterRect(quint8 table, quint8 id) const
+{
+	return letterRect(table >= 4 ? id : (table % 2) * 231 + id);
 }
 
 int WindowBinFile::palette(FontColor color, quint8 table) const
@@ -180,14 +213,9 @@ int WindowBinFile::palette(FontColor color, quint8 table) const
 	return color * 2 + pal;
 }
 
-int WindowBinFile::absoluteId(quint8 table, quint8 id)
-{
-	int absId = id;
-	for(int i=0 ; i<table ; ++i) {
-		absId += tableSize(i);
-	}
-	return absId;
-}
+const int WindowBinFile::tableOffsets[6] = {
+	0, 231, 441, 672, 882, 1092
+};
 
 quint8 WindowBinFile::charWidth(quint8 table, quint8 id) const
 {
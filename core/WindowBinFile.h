@@ -51,18 +51,22 @@ public:
 	static int tableSize(quint8 table);
 	const QImage &image(FontColor color);
 	QImage letter(quint8 table, quint8 id, FontColor color);
+	QImage letterAtlas(quint8 table, FontColor color) const;
+	QRect letterRect(quint8 table, quint8 id) const;
 	quint8 charWidth(quint8 table, quint8 id) const;
 	quint8 charLeftPadding(quint8 table, quint8 id) const;
 	void setCharWidth(quint8 table, quint8 id, quint8 width);
 	void setCharLeftPadding(quint8 table, quint8 id, quint8 padding);
 private:
-	QImage letter(int id, FontColor color);
 	int palette(FontColor color, quint8 table) const;
 	static QRect letterRect(int charId);
 	bool openFont(const QByteArray &data);
 	bool openFont2(const QByteArray &data);
 	bool openFontSize(const QByteArray &data);
-	static int absoluteId(quint8 table, quint8 id);
+	void buildAtlas();
+	static inline int absoluteId(quint8 table, quint8 id) {
+		return tableOffsets[table] + id;
+	}
 	inline quint8 charInfo(quint8 table, quint8 id) const {
 		return _charWidth.value(absoluteId(table, id));
 	}
@@ -72,6 +76,8 @@ private:
 
 	QVector<quint8> _charWidth;
 	TimFile _font, _font2;
+	QVector<QImage> _atlas, _atlas2; // ARGB font images by palette
+	static const int tableOffsets[6];
 	bool modified;
 };
 
@@ -29,11 +29,18 @@ bool AFile::read(FieldModelAnimation &animation, int maxFrames) const
 	}
 
 	AHeader header;
-	PolyVertex rot, trans;
 
 	if (device()->read((char *)&header, 36) != 36
 			|| header.framesCount == 0
-			|| device()->pos() + header.framesCount * (24 + 12 * header.boneCount) > device()->size()) {
+			|| header.boneCount > (0x7FFFFFFF - 24) / 12) {
+		return false;
+	}
+
+	// Computed in 64-bit, a big frame or bone count must not wrap
+	const qint64 frameSize = 24 + 12 * qint64(header.boneCount),
+	        framesSize = qint64(header.framesCount) * frameSize;
+	if (framesSize > 0x7FFFFFFF // QByteArray limit
+			|| device()->pos() + framesSize > device()->size()) {
 		return false;
 	}
 
@@ -41,27 +48,27 @@ bool AFile::read(FieldModelAnimation &animation, int maxFrames) const
 		header.framesCount = qMin(header.framesCount, quint32(maxFrames));
 	}
 
+	// Read all frames at once
+	const qint64 readSize = qint64(header.framesCount) * frameSize;
+	const QByteArray data = device()->read(readSize);
+	if (data.size() != readSize) {
+		return false;
+	}
+	const char *constData = data.constData();
+
+	animation.resize(header.framesCount, header.boneCount, 1);
+
 	for (quint32 i = 0; i < header.framesCount; ++i) {
-		if (!device()->seek(device()->pos() + 12)) {
-			return false;
-		}
-		if (device()->read((char *)&trans, 12) != 12) {
-			return false;
-		}
+		const char *frameData = constData + i * frameSize;
+		PolyVertex *trans = animation.translations(i);
 
-		trans.x = trans.x / MODEL_SCALE_PC;
-		trans.y = trans.y / MODEL_SCALE_PC;
-		trans.z = trans.z / MODEL_SCALE_PC;
+		memcpy(trans, frameData + 12, 12);
 
-		QList<PolyVertex> rotationCoords;
+		trans->x = trans->x / MODEL_SCALE_PC;
+		trans->y = trans->y / MODEL_SCALE_PC;
+		trans->z = trans->z / MODEL_SCALE_PC;
 
-		for (quint32 j = 0; j < header.boneCount; ++j) {
-			if(device()->read((char *)&rot, 12) != 12) {
-				return false;
-			}
-			rotationCoords.append(rot);
-		}
-		animation.insertFrame(i, rotationCoords, QList<PolyVertex>() << trans);
+		memcpy(animation.rotations(i), frameData + 24, 12 * header.boneCount);
 	}
 
 	return true;
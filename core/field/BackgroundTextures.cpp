@@ -218,9 +218,9 @@ quint32 BackgroundTexturesPC::originInData(const Tile &tile) const
 
 QRgb BackgroundTexturesPC::directColor(quint16 color) const
 {
-	return qRgba(qRound(COEFF_COLOR * (color >> 11)),
-				qRound(COEFF_COLOR * (color >> 6 & 31)),
-				qRound(COEFF_COLOR * (color & 31)),
+	return qRgba(PsColor::fromComponent(color >> 11),
+				PsColor::fromComponent(color >> 6 & 31),
+				PsColor::fromComponent(color & 31),
 				 color == 0 ? 0 : 255); // special PC RGB16 color
 }
 
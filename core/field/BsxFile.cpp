@@ -431,19 +431,19 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
-		QList<QRgb> polyColors;
-		QList<TexCoord> polyTexCoords;
+		PolyVertex polyVertices[4];
+		QRgb polyColors[4];
+		TexCoord polyTexCoords[4];
 		notAdd = false;
 
 		for (quint8 j = 0; j < 4; ++j) {
 			quint8 vertexIndex = texturedQuad.vertexIndex[j];
 			quint8 texCoordIndex = texturedQuad.texCoordId[j];
 			if (vertexIndex < vertices.size() && texCoordIndex < texCoords.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
 				const ColorRGBA &color = texturedQuad.color[j];
-				polyColors.append(qRgb(color.red, color.green, color.blue));
-				polyTexCoords.append(texCoords.at(texCoordIndex));
+				polyColors[j] = qRgb(color.red, color.green, color.blue);
+				polyTexCoords[j] = texCoords.at(texCoordIndex);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index col tex quad" << i << j << vertexIndex << vertices.size() << texCoordIndex << texCoords.size();
@@ -452,11 +452,11 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			QuadPoly *poly = new QuadPoly(polyVertices, polyColors, polyTexCoords);
-			if (!addTexturedPolygonToGroup(controlData.at(offsetControl++), poly, groups)) {
-				delete poly;
+			FieldModelGroup *group = texturedGroup(controlData.at(offsetControl++), groups);
+			if (!group) {
 				return false;
 			}
+			group->addQuad(polyVertices, polyColors, polyTexCoords);
 		}
 	}
 
@@ -469,19 +469,19 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
-		QList<QRgb> polyColors;
-		QList<TexCoord> polyTexCoords;
+		PolyVertex polyVertices[3];
+		QRgb polyColors[3];
+		TexCoord polyTexCoords[3];
 		notAdd = false;
 
 		for (quint8 j = 0; j < 3; ++j) {
 			quint8 vertexIndex = texturedTriangle.vertexIndex[j];
 			quint8 texCoordIndex = texturedTriangle.texCoordId[j];
 			if (vertexIndex < vertices.size() && texCoordIndex < texCoords.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
 				const ColorRGBA &color = texturedTriangle.color[j];
-				polyColors.append(qRgb(color.red, color.green, color.blue));
-				polyTexCoords.append(texCoords.at(texCoordIndex));
+				polyColors[j] = qRgb(color.red, color.green, color.blue);
+				polyTexCoords[j] = texCoords.at(texCoordIndex);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index col tex tri" << i << j << vertexIndex << vertices.size() << texCoordIndex << texCoords.size();
@@ -490,11 +490,11 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			TrianglePoly *poly = new TrianglePoly(polyVertices, polyColors, polyTexCoords);
-			if (!addTexturedPolygonToGroup(controlData.at(offsetControl++), poly, groups)) {
-				delete poly;
+			FieldModelGroup *group = texturedGroup(controlData.at(offsetControl++), groups);
+			if (!group) {
 				return false;
 			}
+			group->addTriangle(polyVertices, polyColors, polyTexCoords);
 		}
 	}
 
@@ -507,18 +507,18 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
+		PolyVertex polyVertices[4];
 		const ColorRGBA &color = monochromeTexturedQuad.color;
 		QRgb polyColor = qRgb(color.red, color.green, color.blue);
-		QList<TexCoord> polyTexCoords;
+		TexCoord polyTexCoords[4];
 		notAdd = false;
 
 		for (quint8 j = 0; j < 4; ++j) {
 			quint8 vertexIndex = monochromeTexturedQuad.vertexIndex[j];
 			quint8 texCoordIndex = monochromeTexturedQuad.texCoordId[j];
 			if(vertexIndex < vertices.size() && texCoordIndex < texCoords.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
-				polyTexCoords.append(texCoords.at(texCoordIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
+				polyTexCoords[j] = texCoords.at(texCoordIndex);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index mono tex quad" << i << j << vertexIndex << vertices.size() << texCoordIndex << texCoords.size();
@@ -527,11 +527,11 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			QuadPoly *poly = new QuadPoly(polyVertices, polyColor, polyTexCoords);
-			if (!addTexturedPolygonToGroup(controlData.at(offsetControl++), poly, groups)) {
-				delete poly;
+			FieldModelGroup *group = texturedGroup(controlData.at(offsetControl++), groups);
+			if (!group) {
 				return false;
 			}
+			group->addQuad(polyVertices, polyColor, polyTexCoords);
 		}
 	}
 
@@ -544,18 +544,18 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
+		PolyVertex polyVertices[3];
 		const ColorRGBA &color = monochromeTexturedTriangle.color;
 		QRgb polyColor = qRgb(color.red, color.green, color.blue);
-		QList<TexCoord> polyTexCoords;
+		TexCoord polyTexCoords[3];
 		notAdd = false;
 
 		for (quint8 j = 0; j < 3; ++j) {
 			quint8 vertexIndex = monochromeTexturedTriangle.vertexIndex[j];
 			quint8 texCoordIndex = monochromeTexturedTriangle.texCoordId[j];
 			if (vertexIndex < vertices.size() && texCoordIndex < texCoords.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
-				polyTexCoords.append(texCoords.at(texCoordIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
+				polyTexCoords[j] = texCoords.at(texCoordIndex);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index mono tex tri" << i << j << vertexIndex << vertices.size() << texCoordIndex << texCoords.size();
@@ -564,11 +564,11 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			TrianglePoly *poly = new TrianglePoly(polyVertices, polyColor, polyTexCoords);
-			if (!addTexturedPolygonToGroup(controlData.at(offsetControl++), poly, groups)) {
-				delete poly;
+			FieldModelGroup *group = texturedGroup(controlData.at(offsetControl++), groups);
+			if (!group) {
 				return false;
 			}
+			group->addTriangle(polyVertices, polyColor, polyTexCoords);
 		}
 	}
 
@@ -581,7 +581,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
+		PolyVertex polyVertices[3];
 		const ColorRGBA &color = monochromeTriangle.color;
 		QRgb polyColor = qRgb(color.red, color.green, color.blue);
 		notAdd = false;
@@ -589,7 +589,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		for (quint8 j = 0; j < 3; ++j) {
 			quint8 vertexIndex = monochromeTriangle.vertexIndex[j];
 			if (vertexIndex < vertices.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index mono tri" << i << j << vertexIndex << vertices.size();
@@ -598,7 +598,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			groups.first()->addPolygon(new TrianglePoly(polyVertices, polyColor));
+			groups.first()->addTriangle(polyVertices, polyColor);
 		}
 	}
 
@@ -611,7 +611,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
+		PolyVertex polyVertices[4];
 		const ColorRGBA &color = monochromeQuad.color;
 		QRgb polyColor = qRgb(color.red, color.green, color.blue);
 		notAdd = false;
@@ -619,7 +619,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		for (quint8 j = 0; j < 4; ++j) {
 			quint8 vertexIndex = monochromeQuad.vertexIndex[j];
 			if (vertexIndex < vertices.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index mono quad" << i << j << vertexIndex << vertices.size();
@@ -628,7 +628,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			groups.first()->addPolygon(new QuadPoly(polyVertices, polyColor));
+			groups.first()->addQuad(polyVertices, polyColor);
 		}
 	}
 
@@ -641,16 +641,16 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
-		QList<QRgb> polyColors;
+		PolyVertex polyVertices[3];
+		QRgb polyColors[3];
 		notAdd = false;
 
 		for (quint8 j = 0; j < 3; ++j) {
 			quint8 vertexIndex = colorTriangle.vertexIndex[j];
 			if (vertexIndex < vertices.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
 				const ColorRGBA &color = colorTriangle.color[j];
-				polyColors.append(qRgb(color.red, color.green, color.blue));
+				polyColors[j] = qRgb(color.red, color.green, color.blue);
 			} else {
 				notAdd = true;
 				qWarning() << "BsxFile::readPart error index col tri" << i << j << "index" << vertexIndex << "size" << vertices.size();
@@ -659,7 +659,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			groups.first()->addPolygon(new TrianglePoly(polyVertices, polyColors));
+			groups.first()->addTriangle(polyVertices, polyColors);
 		}
 	}
 
@@ -672,16 +672,16 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 			return false;
 		}
 
-		QList<PolyVertex> polyVertices;
-		QList<QRgb> polyColors;
+		PolyVertex polyVertices[4];
+		QRgb polyColors[4];
 		notAdd = false;
 
 		for (quint8 j = 0; j < 4; ++j) {
 			quint8 vertexIndex = colorQuad.vertexIndex[j];
 			if(vertexIndex < vertices.size()) {
-				polyVertices.append(vertices.at(vertexIndex));
+				polyVertices[j] = vertices.at(vertexIndex);
 				const ColorRGBA &color = colorQuad.color[j];
-				polyColors.append(qRgb(color.red, color.green, color.blue));
+				polyColors[j] = qRgb(color.red, color.green, color.blue);
 			} else {
 				notAdd = true;
 				qWarning() << "error index col quad" << i << j << "index" << vertexIndex << "size" << vertices.size();
@@ -690,7 +690,7 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 		}
 
 		if (!notAdd) {
-			groups.first()->addPolygon(new QuadPoly(polyVertices, polyColors));
+			groups.first()->addQuad(polyVertices, polyColors);
 		}
 	}
 
@@ -699,21 +699,20 @@ bool BsxFile::readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart
 	return true;
 }
 
-bool BsxFile::addTexturedPolygonToGroup(quint8 control, Poly *polygon, QList<FieldModelGroup *> &groups)
+FieldModelGroup *BsxFile::texturedGroup(quint8 control, const QList<FieldModelGroup *> &groups)
 {
 	quint8 blend = (control >> 4) & 0x03,
 			flagID = control & 0x0F;
 
-	if (flagID >= groups.size()) {
-		qWarning() << "BsxFile::addTexturedPolygonToGroup error 2" << flagID << groups.size();
-		return false;
+	if (flagID + 1 >= groups.size()) {
+		qWarning() << "BsxFile::texturedGroup error 2" << flagID << groups.size();
+		return 0;
 	}
 
 	FieldModelGroup *group = groups.at(flagID + 1);
 	group->setBlendMode(blend);
-	group->addPolygon(polygon);
 
-	return true;
+	return group;
 }
 
 bool BsxFile::readAnimations(const QList<FieldModelAnimationPSHeader> &animationHeaders,
@@ -743,8 +742,11 @@ bool BsxFile::readAnimation(const FieldModelAnimationPSHeader &header, FieldMode
 		return false;
 	}
 
+	animation.resize(header.numFrames, header.numBones, header.numBones);
+
 	for (quint32 frame = 0; frame < header.numFrames; ++frame) {
-		QList<PolyVertex> rotationCoords, rotationCoordsTrans;
+		PolyVertex *rotationCoords = animation.rotations(frame),
+		        *rotationCoordsTrans = animation.translations(frame);
 
 		for (quint16 bone = 0; bone < header.numBones; ++bone) {
 			FrameTranslation frameTrans;
@@ -894,11 +896,9 @@ bool BsxFile::readAnimation(const FieldModelAnimationPSHeader &header, FieldMode
 			}
 			trans.z = -translation / MODEL_SCALE_PS;
 
-			rotationCoords.append(rot);
-			rotationCoordsTrans.append(trans);
+			rotationCoords[bone] = rot;
+			rotationCoordsTrans[bone] = trans;
 		}
-
-		animation.insertFrame(frame, rotationCoords, rotationCoordsTrans);
 	}
 
 	return true;
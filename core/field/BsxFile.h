@@ -208,7 +208,7 @@ protected:
 	bool readAnimationsHeaders(quint8 numAnimations, QList<FieldModelAnimationPSHeader> &animationsHeaders) const;
 	bool readMesh(const QList<FieldModelPartPSHeader> &partsHeaders, FieldModelSkeleton &skeleton) const;
 	bool readPart(const FieldModelPartPSHeader &partHeader, FieldModelPart *part) const;
-	static bool addTexturedPolygonToGroup(quint8 control, Poly *polygon, QList<FieldModelGroup *> &groups);
+	static FieldModelGroup *texturedGroup(quint8 control, const QList<FieldModelGroup *> &groups);
 	bool readAnimations(const QList<FieldModelAnimationPSHeader> &animationHeaders, QList<FieldModelAnimation> &animations) const;
 	bool readAnimation(const FieldModelAnimationPSHeader &header, FieldModelAnimation &animation) const;
 	bool readTexturesHeaders(quint8 numTextures, QList<BsxTextureHeader> &headers) const;
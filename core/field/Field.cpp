@@ -46,6 +46,72 @@ bool Field::isModified() const
 	return _isModified;
 }
 
+/*!
+ * Returns true if the field or one of its opened sections is modified.
+ */
+bool Field::hasModifiedParts() const
+{
+	if(_isModified) {
+		return true;
+	}
+
+	foreach(FieldPart *part, _parts) {
+		if(part && part->isModified()) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Estimation of the memory used by the opened sections,
+ * based on the size of their data.
+ */
+qint64 Field::residentSize() const
+{
+	return _residentSize.fetchAndAddOrdered(0);
+}
+
+/*!
+ * Computes residentSize() from the raw section data, the parsed parts
+ * (estimated at the size of their data) and the LZS decoding states.
+ */
+void Field::updateResidentSize()
+{
+	qint64 size = 0;
+
+	QHashIterator<FieldSection, int> it(_sectionSizes);
+	while(it.hasNext()) {
+		it.next();
+		size += it.value();
+		FieldPart *p = part(it.key());
+		if(p && p->isOpen()) {
+			size += it.value();
+		}
+	}
+
+	foreach(const LZSDecoder &decoder, _lzsDecoders) {
+		size += decoder.memorySize();
+	}
+
+	_residentSize.fetchAndStoreOrdered(int(qMin(size, qint64(0x7FFFFFFF))));
+}
+
+/*!
+ * Frees every opened section, the field will be reopened on demand.
+ * Modified data is lost.
+ */
+void Field::close()
+{
+	qDeleteAll(_parts);
+	_parts.clear();
+	_lzsDecoders.clear();
+	_sectionSizes.clear();
+	_residentSize.fetchAndStoreOrdered(0);
+	_isOpen = false;
+}
+
 void Field::setModified(bool modified)
 {
 	if(!_isOpen) {
@@ -63,6 +129,8 @@ bool Field::open(bool dontOptimize)
 {
 	QByteArray fileData;
 
+	_lzsDecoders.clear(); // Section positions may have changed
+
 	if(headerSize() > 0) {
 		QString fileType = sectionFile(Scripts);
 		if(!dontOptimize && !_io->fieldDataIsCached(this, fileType)) {
@@ -77,7 +145,7 @@ bool Field::open(bool dontOptimize)
 			if(!Config::value("lzsNotCheck").toBool() && (quint32)lzsData.size() != lzsSize + 4)
 				return false;
 
-			fileData = LZS::decompress(lzsDataConst + 4, qMin(lzsSize, quint32(lzsData.size() - 4)), headerSize());//partial decompression
+			fileData = _lzsDecoders[fileType].decompress(lzsDataConst + 4, qMin(lzsSize, quint32(lzsData.size() - 4)), 0, headerSize());//partial decompression
 		} else {
 			fileData = _io->fieldData(this, fileType);
 		}
@@ -85,9 +153,18 @@ bool Field::open(bool dontOptimize)
 		if(fileData.size() < headerSize())	return false;
 
 		openHeader(fileData);
+
+		if(_lzsDecoders.contains(fileType)) {
+			// The next partial decompressions will restart from the closest section
+			LZSDecoder &decoder = _lzsDecoders[fileType];
+			for(int i=0 ; i<sectionCount() ; ++i) {
+				decoder.addCheckpoint(sectionPosition(i));
+			}
+		}
 	}
 
 	_isOpen = true;
+	updateResidentSize();
 
 	return true;
 }
@@ -126,6 +203,14 @@ int Field::sectionSize(FieldSection part) const
 }
 
 QByteArray Field::sectionData(FieldSection part, bool dontOptimize)
+{
+	QByteArray data = sectionData2(part, dontOptimize);
+	_sectionSizes.insert(part, data.size());
+	updateResidentSize();
+	return data;
+}
+
+QByteArray Field::sectionData2(FieldSection part, bool dontOptimize)
 {
 	if(!_isOpen) {
 		open();
@@ -160,7 +245,10 @@ QByteArray Field::sectionData(FieldSection part, bool dontOptimize)
 			return QByteArray();
 		}
 
-		data = LZS::decompress(lzsDataConst + 4, qMin(lzsSize, quint32(lzsData.size() - 4)), sectionPosition(idPart+1));
+		// Continues the previous partial decompression
+		LZSDecoder &decoder = _lzsDecoders[fileType];
+		decoder.addCheckpoint(position);
+		return decoder.decompress(lzsDataConst + 4, qMin(lzsSize, quint32(lzsData.size() - 4)), position, size);
 	}
 
 	if(size < 0) {
@@ -207,6 +295,7 @@ FieldPart *Field::part(FieldSection section, bool open)
 
 	if(open && !p->isOpen()) {
 		p->open();
+		updateResidentSize();
 	}
 
 	return p;
@@ -28,6 +28,7 @@
 #include "FieldModelLoader.h"
 #include "FieldModelFile.h"
 #include "BackgroundFile.h"
+#include "../LZS.h"
 
 class FieldArchiveIO;
 
@@ -54,6 +55,9 @@ public:
 	bool isOpen() const;
 	bool isModified() const;
 	void setModified(bool modified);
+	bool hasModifiedParts() const;
+	qint64 residentSize() const;
+	void close();
 
 	virtual bool isPC() const=0;
 	inline bool isPS() const { return !isPC(); }
@@ -105,8 +109,13 @@ protected:
 	virtual bool hasSectionHeader() const=0;
 private:
 	FieldPart *part(FieldSection section, bool open);
+	QByteArray sectionData2(FieldSection part, bool dontOptimize);
+	void updateResidentSize();
 
 	QHash<FieldSection, FieldPart *> _parts;
+	QHash<QString, LZSDecoder> _lzsDecoders; // Partial decompression states by file type
+	QHash<FieldSection, int> _sectionSizes; // Last data size read by section
+	mutable QAtomicInt _residentSize; // See updateResidentSize(), read from other threads
 	FieldArchiveIO *_io;
 	bool _isOpen, _isModified;
 	QString _name;
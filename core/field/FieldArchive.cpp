@@ -18,10 +18,14 @@
 #include "FieldArchive.h"
 #include "FieldPS.h"
 #include "FieldPC.h"
+#include "FieldArchiveJob.h"
+#include "ScriptAnalysis.h"
+#include "../FF7TextLayout.h"
 #include "Data.h"
+#include "../Config.h"
 
-FieldArchiveIterator::FieldArchiveIterator(const FieldArchive &archive) :
-	QListIterator<Field *>(archive.fileList)
+FieldArchiveIterator::FieldArchiveIterator(FieldArchive &archive) :
+	QListIterator<Field *>(archive.fileList), _archive(&archive)
 {
 }
 
@@ -45,21 +49,25 @@ Field *FieldArchiveIterator::previous(bool open, bool dontOptimize)
 	return openField(QListIterator<Field *>::previous(), open, dontOptimize);
 }
 
-Field *FieldArchiveIterator::openField(Field *field, bool open, bool dontOptimize)
+Field *FieldArchiveIterator::openField(Field *field, bool open, bool dontOptimize) const
 {
-	if(field != NULL && open && !field->isOpen()) {
-		field->open(dontOptimize);
+	if(field != NULL && open) {
+		_archive->openField(field, dontOptimize);
 	}
 	return field;
 }
 
 FieldArchive::FieldArchive() :
-	_io(0), _observer(0)
+	_io(0), _observer(0),
+	_memoryBudget(Config::value("fieldMemoryBudget", 128).toLongLong() * 1024 * 1024),
+	_mutex(QMutex::Recursive), _scriptGraphBuilt(false)
 {
 }
 
 FieldArchive::FieldArchive(FieldArchiveIO *io) :
-	_io(io), _observer(0)
+	_io(io), _observer(0),
+	_memoryBudget(Config::value("fieldMemoryBudget", 128).toLongLong() * 1024 * 1024),
+	_mutex(QMutex::Recursive), _scriptGraphBuilt(false)
 {
 	//	fileWatcher.addPath(path);
 	//	connect(&fileWatcher, SIGNAL(fileChanged(QString)), this, SIGNAL(fileChanged(QString)));
@@ -121,9 +129,13 @@ void FieldArchive::clear()
 {
 	qDeleteAll(fileList);
 	fileList.clear();
+	_residentFields.clear();
+	_pinnedFields.clear();
+	_busyFields.clear();
 	fieldsSortByName.clear();
 	fieldsSortByMapId.clear();
 	Data::field_names.clear();
+	invalidateScriptGraph();
 }
 
 FieldArchiveIO *FieldArchive::io() const
@@ -138,12 +150,185 @@ void FieldArchive::setIO(FieldArchiveIO *io)
 
 bool FieldArchive::openField(Field *field, bool dontOptimize)
 {
-	if(!field->isOpen()) {
-		return field->open(dontOptimize);
+	QMutexLocker locker(&_mutex);
+
+	if(!field->isOpen() && !field->open(dontOptimize)) {
+		return false;
 	}
+	touchField(field);
 	return true;
 }
 
+/*!
+ * Marks field as the most recently used.
+ * Fields are never closed here, because the caller
+ * can still use the parts of another field.
+ */
+void FieldArchive::touchField(Field *field)
+{
+	QMutexLocker locker(&_mutex);
+
+	if(_residentFields.isEmpty() || _residentFields.last() != field) {
+		_residentFields.removeOne(field);
+		_residentFields.append(field);
+	}
+}
+
+/*!
+ * Closes unmodified and unpinned fields, least recently used first,
+ * until the resident size fits in the memory budget.
+ * The most recently used field is never closed.
+ * Call it only when no part of an unpinned field is used,
+ * between two field operations.
+ */
+void FieldArchive::evictFields()
+{
+	QMutexLocker locker(&_mutex);
+
+	if(_memoryBudget <= 0) {
+		return;
+	}
+
+	qint64 size = residentSize();
+
+	for(int i=0 ; size > _memoryBudget && i < _residentFields.size() - 1 ; ) {
+		Field *field = _residentFields.at(i);
+		if(_pinnedFields.contains(field) || _busyFields.contains(field)
+		        || field->hasModifiedParts()) {
+			++i;
+			continue;
+		}
+		size -= field->residentSize();
+		field->close();
+		_residentFields.removeAt(i);
+	}
+}
+
+qint64 FieldArchive::residentSize() const
+{
+	QMutexLocker locker(&_mutex);
+	qint64 size = 0;
+
+	foreach(Field *field, _residentFields) {
+		size += field->residentSize();
+	}
+
+	return size;
+}
+
+/*!
+ * Sets the estimated memory size allowed for opened fields,
+ * 0 for unlimited.
+ */
+void FieldArchive::setMemoryBudget(qint64 budget)
+{
+	QMutexLocker locker(&_mutex);
+	_memoryBudget = budget;
+	evictFields();
+}
+
+/*!
+ * A pinned field is never closed to save memory,
+ * like the field shown in a widget.
+ * Pins are counted, every pinField() needs an unpinField().
+ */
+void FieldArchive::pinField(Field *field)
+{
+	QMutexLocker locker(&_mutex);
+	_pinnedFields.insert(field, _pinnedFields.value(field, 0) + 1);
+}
+
+void FieldArchive::unpinField(Field *field)
+{
+	QMutexLocker locker(&_mutex);
+	int count = _pinnedFields.value(field, 0) - 1;
+	if(count > 0) {
+		_pinnedFields.insert(field, count);
+	} else {
+		_pinnedFields.remove(field);
+	}
+}
+
+/*!
+ * Closes the fields whose files were changed by another program,
+ * they will be read again the next time they are used.
+ * Fields with unsaved modifications, pinned fields and fields
+ * used by a worker thread are kept.
+ * Returns the IDs of the closed fields.
+ */
+QList<int> FieldArchive::reloadChangedFields()
+{
+	QMutexLocker locker(&_mutex);
+	QList<int> fieldIDs;
+
+	if(!_io) {
+		return fieldIDs;
+	}
+
+	foreach(const QString &name, _io->changedFields()) {
+		int fieldID = indexOfField(name);
+		Field *field = fileList.value(fieldID, NULL);
+		if(field == NULL) {
+			continue;
+		}
+
+		if(field->hasModifiedParts() || _pinnedFields.contains(field)
+		        || _busyFields.contains(field)) {
+			qWarning() << "FieldArchive::reloadChangedFields" << name << "changed on disk but is modified or in use, not reloaded";
+			continue;
+		}
+
+		_io->clearCachedData(field);
+		field->close();
+		_residentFields.removeOne(field);
+		if(_scriptGraphBuilt) {
+			_staleScriptGraphFields.insert(fieldID);
+		}
+		fieldIDs.append(fieldID);
+	}
+
+	return fieldIDs;
+}
+
+/*!
+ * Gets the field for a worker thread, it will not be closed
+ * to save memory until releaseField() is called.
+ * The field is opened outside the lock, so workers
+ * can parse different fields at the same time.
+ */
+Field *FieldArchive::acquireField(int id, bool open)
+{
+	QMutexLocker locker(&_mutex);
+
+	Field *field = fileList.value(id, NULL);
+	if(field == NULL) {
+		return NULL;
+	}
+	_busyFields.insert(field);
+
+	if(open && !field->isOpen()) {
+		locker.unlock();
+		bool ok = field->open();
+		locker.relock();
+		if(!ok) {
+			_busyFields.remove(field);
+			return NULL;
+		}
+	}
+
+	if(open) {
+		touchField(field);
+	}
+
+	return field;
+}
+
+void FieldArchive::releaseField(Field *field)
+{
+	QMutexLocker locker(&_mutex);
+	_busyFields.remove(field);
+}
+
 int FieldArchive::indexOfField(const QString &name) const
 {
 	return fieldsSortByName.value(name.toLower(), -1);
@@ -156,6 +341,7 @@ const Field *FieldArchive::field(quint32 id) const
 
 Field *FieldArchive::field(quint32 id, bool open, bool dontOptimize)
 {
+	QMutexLocker locker(&_mutex);
 	Field *field = fileList.value(id, NULL);
 	if(field!=NULL && open && !openField(field, dontOptimize)) {
 		return NULL;
@@ -199,6 +385,7 @@ FieldArchiveIO::ErrorCode FieldArchive::addField(Field *field,
 	// FIXME: choose another name? Multiple fields with the same name
 	Data::field_names.append(field->name());
 	updateFieldLists(field, fieldId);
+	invalidateScriptGraph();
 	return FieldArchiveIO::Ok;
 }
 
@@ -209,7 +396,11 @@ void FieldArchive::appendField(Field *field)
 
 void FieldArchive::removeField(quint32 id)
 {
+	Field *field = fileList.value(id, NULL);
+	_residentFields.removeOne(field);
+	_pinnedFields.remove(field);
 	fileList.removeAt(id);
+	invalidateScriptGraph();
 }
 
 bool FieldArchive::isAllOpened() const
@@ -228,26 +419,43 @@ bool FieldArchive::isModified() const
 	return false;
 }
 
-QList<FF7Var> FieldArchive::searchAllVars(QMap<FF7Var, QSet<QString> > &fieldNames)
+class SearchAllVarsJob : public FieldArchiveJob
 {
-	Q_UNUSED(fieldNames)
-	QList<FF7Var> vars;
-	int size = fileList.size();
+public:
+	explicit SearchAllVarsJob(FieldArchive *archive) :
+		FieldArchiveJob(archive) {}
+	QMap<int, QList<FF7Var> > vars; // By field ID
+	QMap<int, QString> authors; // By field ID
+protected:
+	bool processField(Field *field, int fieldID) {
+		QList<FF7Var> fieldVars;
+		field->scriptsAndTexts()->searchAllVars(fieldVars);
+		QString author = field->scriptsAndTexts()->author();
 
-	for(int i=0 ; i<size ; ++i) {
-		QCoreApplication::processEvents();
-		Field *field = this->field(i);
-		if(field != NULL) {
-			QList<FF7Var> fieldVars;
-			field->scriptsAndTexts()->searchAllVars(fieldVars);
-			foreach (const FF7Var &fieldVar, fieldVars) {
-				QSet<QString> names = fieldNames.value(fieldVar);
-				names.insert(field->scriptsAndTexts()->author());
-				fieldNames.insert(fieldVar, names);
-			}
+		QMutexLocker locker(&mutex);
+		vars.insert(fieldID, fieldVars);
+		authors.insert(fieldID, author);
+		return true;
+	}
+private:
+	QMutex mutex;
+};
+
+QList<FF7Var> FieldArchive::searchAllVars(QMap<FF7Var, QSet<QString> > &fieldNames)
+{
+	SearchAllVarsJob job(this);
+	job.exec();
 
-			vars.append(fieldVars);
+	// Merge results in field order
+	QList<FF7Var> vars;
+	QMapIterator<int, QList<FF7Var> > it(job.vars);
+	while(it.hasNext()) {
+		it.next();
+		const QString &author = job.authors.value(it.key());
+		foreach(const FF7Var &fieldVar, it.value()) {
+			fieldNames[fieldVar].insert(author);
 		}
+		vars.append(it.value());
 	}
 
 	return vars;
@@ -258,7 +466,6 @@ QList<FF7Var> FieldArchive::searchAllVars(QMap<FF7Var, QSet<QString> > &fieldNam
 #include "BackgroundFilePC.h"
 #include "BackgroundFilePS.h"
 #include "FieldArchivePC.h"
-#include "widgets/TextPreview.h"
 
 void FieldArchive::validateAsk()
 {
@@ -344,7 +551,7 @@ void FieldArchive::validateAsk()
 
 void FieldArchive::validateOneLineSize()
 {
-	TextPreview tp; // Init textpreview to use autodim algo
+	FF7TextLayout layout;
 
 	foreach(int i, fieldsSortByMapId) {
 		Field *f = field(i, true);
@@ -373,7 +580,7 @@ void FieldArchive::validateOneLineSize()
 							opcodeWindow->getWindow(window);
 							if (opcode->getTextID() < scriptsAndTexts->textCount()) {
 								FF7Text text = scriptsAndTexts->text(opcode->getTextID());
-								QSize optimSize = TextPreview::calcSize(text.data());
+								QSize optimSize = layout.windowSize(text.data());
 								if (!text.data().isEmpty() && !text.contains(QRegExp("\n")) && (window.w != optimSize.width() || window.h != optimSize.height())) {
 									qWarning() << name << grpScriptID << grp->name() << grp->scriptName(scriptID) << opcodeID << "width=" << window.w << "height=" << window.h << "better size=" << optimSize.width() << optimSize.height();
 								}
@@ -1223,16 +1430,20 @@ bool FieldArchive::searchIterators(QMap<QString, int>::const_iterator &i, QMap<Q
 
 bool FieldArchive::find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 						SearchQuery *toSearch, int &fieldID, SearchIn *searchIn,
-						Sorting sorting, SearchScope scope)
+						Sorting sorting, SearchScope scope, const QSet<int> *candidates)
 {
 	QMap<QString, int>::const_iterator i, end;
 	if(!searchIterators(i, end, fieldID, sorting, scope))	return false;
 
 	for( ; i != end ; ++i) {
-		QCoreApplication::processEvents();
-		Field *f = field(fieldID = i.value());
-		if(f!=NULL && (*predicate)(f, toSearch, searchIn))
-			return true;
+		fieldID = i.value();
+		if(!candidates || candidates->contains(fieldID)) {
+			QCoreApplication::processEvents();
+			evictFields(); // The previous field is not used anymore
+			Field *f = field(fieldID);
+			if(f!=NULL && (*predicate)(f, toSearch, searchIn))
+				return true;
+		}
 		searchIn->reset();
 		if(scope >= FieldScope)		break;
 	}
@@ -1241,17 +1452,21 @@ bool FieldArchive::find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 
 bool FieldArchive::findLast(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 						SearchQuery *toSearch, int &fieldID, SearchIn *searchIn,
-						Sorting sorting, SearchScope scope)
+						Sorting sorting, SearchScope scope, const QSet<int> *candidates)
 {
 	QMap<QString, int>::const_iterator i, begin;
 	if(!searchIteratorsP(i, begin, fieldID, sorting, scope))	return false;
 
 	for( ; i != begin-1 ; --i)
 	{
-		QCoreApplication::processEvents();
-		Field *f = field(fieldID = i.value());
-		if(f!=NULL && (*predicate)(f, toSearch, searchIn))
-			return true;
+		fieldID = i.value();
+		if(!candidates || candidates->contains(fieldID)) {
+			QCoreApplication::processEvents();
+			evictFields(); // The previous field is not used anymore
+			Field *f = field(fieldID);
+			if(f!=NULL && (*predicate)(f, toSearch, searchIn))
+				return true;
+		}
 		searchIn->toEnd();
 		if(scope >= FieldScope)		break;
 	}
@@ -1286,24 +1501,38 @@ bool FieldArchive::searchExec(quint8 group, quint8 script, int &fieldID, int &gr
 {
 	SearchExecQuery query(group, script);
 	SearchInScript searchIn(groupID, scriptID, opcodeID);
+	// Skip fields without this opcode
+	QSet<int> candidates;
+	const bool useGraph = useScriptGraph(scope);
+	if(useGraph) {
+		candidates = scriptGraph().fieldsWithExec(group, script);
+	}
 
 	return find([](Field *f, SearchQuery *_query, SearchIn *_searchIn) {
 		SearchExecQuery *query = static_cast<SearchExecQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchExec(query->group, query->script, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, fieldID, &searchIn, sorting, scope);
+	}, &query, fieldID, &searchIn, sorting, scope,
+	          useGraph ? &candidates : 0);
 }
 
 bool FieldArchive::searchMapJump(quint16 _field, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
 {
 	SearchFieldQuery query(_field);
 	SearchInScript searchIn(groupID, scriptID, opcodeID);
+	// Skip fields without this opcode
+	QSet<int> candidates;
+	const bool useGraph = useScriptGraph(scope);
+	if(useGraph) {
+		candidates = scriptGraph().fieldsWithMapJump(_field);
+	}
 
 	return find([](Field *f, SearchQuery *_query, SearchIn *_searchIn) {
 		SearchFieldQuery *query = static_cast<SearchFieldQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchMapJump(query->fieldID, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, fieldID, &searchIn, sorting, scope);
+	}, &query, fieldID, &searchIn, sorting, scope,
+	          useGraph ? &candidates : 0);
 }
 
 bool FieldArchive::searchTextInScripts(const QRegExp &text, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1387,24 +1616,38 @@ bool FieldArchive::searchExecP(quint8 group, quint8 script, int &fieldID, int &g
 {
 	SearchExecQuery query(group, script);
 	SearchInScript searchIn(groupID, scriptID, opcodeID);
+	// Skip fields without this opcode
+	QSet<int> candidates;
+	const bool useGraph = useScriptGraph(scope);
+	if(useGraph) {
+		candidates = scriptGraph().fieldsWithExec(group, script);
+	}
 
 	return findLast([](Field *f, SearchQuery *_query, SearchIn *_searchIn) {
 		SearchExecQuery *query = static_cast<SearchExecQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchExecP(query->group, query->script, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, fieldID, &searchIn, sorting, scope);
+	}, &query, fieldID, &searchIn, sorting, scope,
+	          useGraph ? &candidates : 0);
 }
 
 bool FieldArchive::searchMapJumpP(quint16 _field, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
 {
 	SearchFieldQuery query(_field);
 	SearchInScript searchIn(groupID, scriptID, opcodeID);
+	// Skip fields without this opcode
+	QSet<int> candidates;
+	const bool useGraph = useScriptGraph(scope);
+	if(useGraph) {
+		candidates = scriptGraph().fieldsWithMapJump(_field);
+	}
 
 	return findLast([](Field *f, SearchQuery *_query, SearchIn *_searchIn) {
 		SearchFieldQuery *query = static_cast<SearchFieldQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchMapJumpP(query->fieldID, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, fieldID, &searchIn, sorting, scope);
+	}, &query, fieldID, &searchIn, sorting, scope,
+	          useGraph ? &candidates : 0);
 }
 
 bool FieldArchive::searchTextInScriptsP(const QRegExp &text, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1447,80 +1690,435 @@ bool FieldArchive::replaceText(const QRegExp &search, const QString &after, int
 	return false;
 }
 
+class CompileScriptsJob : public FieldArchiveJob
+{
+public:
+	explicit CompileScriptsJob(FieldArchive *archive) :
+		FieldArchiveJob(archive) {}
+	QMap<int, FieldCompileReport> reports; // By field ID
+protected:
+	bool openFields() const {
+		return false; // Only opened fields can be modified
+	}
+	bool processField(Field *field, int fieldID) {
+		if(!field->isOpen()) {
+			return true;
+		}
+		Section1File *section1 = field->scriptsAndTexts();
+		if(!section1->isOpen()) {
+			return true;
+		}
+
+		FieldCompileReport report;
+		QElapsedTimer timer;
+		timer.start();
+		section1->compileScripts(report.errors);
+		report.elapsed = timer.nsecsElapsed() / 1000;
+		report.fieldID = fieldID;
+
+		QMutexLocker locker(&mutex);
+		reports.insert(fieldID, report);
+		return true;
+	}
+private:
+	QMutex mutex;
+};
+
 bool FieldArchive::compileScripts(int &fieldID, int &groupID, int &scriptID, int &opcodeID, QString &errorStr)
 {
-	int size = fileList.size();
+	QList<FieldCompileReport> reports;
 
-	for(fieldID=0 ; fieldID<size ; ++fieldID) {
-		QCoreApplication::processEvents();
-		Field *field = this->field(fieldID, false);
-		if(field != NULL && field->isOpen()) {
-			Section1File *section1 = field->scriptsAndTexts();
-			if(section1->isOpen() && !section1->compileScripts(groupID, scriptID, opcodeID, errorStr)) {
-				return false;
-			}
+	if(compileScripts(reports)) {
+		return true;
+	}
+
+	foreach(const FieldCompileReport &report, reports) {
+		if(!report.errors.isEmpty()) {
+			const ScriptCompileError &error = report.errors.first();
+			fieldID = report.fieldID;
+			groupID = error.groupID;
+			scriptID = error.scriptID;
+			opcodeID = error.opcodeID;
+			errorStr = error.errorStr;
+			break;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Compiles the scripts of every opened field, in parallel.
+ * Reports are sorted by field ID, with every error and the compile time.
+ * Returns false if there is at least one error.
+ */
+bool FieldArchive::compileScripts(QList<FieldCompileReport> &reports)
+{
+	CompileScriptsJob job(this);
+	job.exec();
+
+	reports = job.reports.values();
+
+	foreach(const FieldCompileReport &report, reports) {
+		if(!report.errors.isEmpty()) {
+			return false;
 		}
 	}
 
 	return true;
 }
 
-void FieldArchive::removeBattles()
+class AnalyzeScriptsJob : public FieldArchiveJob
 {
-	observer()->setObserverMaximum(fileList.size());
+public:
+	explicit AnalyzeScriptsJob(FieldArchive *archive) :
+		FieldArchiveJob(archive) {}
+	QMap<int, QList<ScriptIssue> > issues, exposedUses; // By field ID
+	QSet<int> writtenVars; // bank << 8 | address
+protected:
+	bool processField(Field *field, int fieldID) {
+		Section1File *section1 = field->scriptsAndTexts();
+		if(!section1->isOpen()) {
+			return true;
+		}
 
-	for(int fieldID=0 ; fieldID<fileList.size() ; ++fieldID) {
-		if(observer()->observerWasCanceled()) {
-			return;
+		QList<ScriptIssue> fieldIssues, fieldExposedUses;
+		QSet<int> fieldWrittenVars;
+		int groupID = 0;
+		foreach(GrpScript *group, section1->grpScripts()) {
+			int scriptID = 0;
+			foreach(Script *script, group->scripts()) {
+				const ScriptAnalysis &analysis = script->analysis();
+
+				foreach(const BasicBlock &block, analysis.blocks()) {
+					if(!block.reachable) {
+						fieldIssues.append(ScriptIssue(ScriptIssue::DeadCode, fieldID, groupID, scriptID, block.first));
+					}
+				}
+				foreach(int opcodeID, analysis.badJumps()) {
+					fieldIssues.append(ScriptIssue(ScriptIssue::BadJump, fieldID, groupID, scriptID, opcodeID));
+				}
+				foreach(const VarAccess &def, analysis.definitions()) {
+					fieldWrittenVars.insert((def.var.bank << 8) | def.var.address);
+				}
+				foreach(const VarAccess &use, analysis.exposedUses()) {
+					ScriptIssue issue(ScriptIssue::UninitializedVar, fieldID, groupID, scriptID, use.opcodeID);
+					issue.var = use.var;
+					fieldExposedUses.append(issue);
+				}
+				++scriptID;
+			}
+			++groupID;
 		}
-		Field *field = this->field(fieldID, true);
-		if(field != NULL && field->scriptsAndTexts()->isOpen()) {
-			field->encounter()->setBattleEnabled(EncounterFile::Table1, false);
-			field->encounter()->setBattleEnabled(EncounterFile::Table2, false);
-			if(!field->isModified()) {
-				field->setModified(true);
+
+		QMutexLocker locker(&mutex);
+		issues.insert(fieldID, fieldIssues);
+		exposedUses.insert(fieldID, fieldExposedUses);
+		writtenVars.unite(fieldWrittenVars);
+		return true;
+	}
+private:
+	QMutex mutex;
+};
+
+/*!
+ * Reports dead code and invalid jumps in every script,
+ * and reads of vars that no script of the archive writes.
+ * Issues are sorted by field ID.
+ */
+void FieldArchive::analyzeScripts(QList<ScriptIssue> &issues)
+{
+	AnalyzeScriptsJob job(this);
+	job.exec(observer());
+
+	QMapIterator<int, QList<ScriptIssue> > it(job.issues);
+	while(it.hasNext()) {
+		it.next();
+		issues.append(it.value());
+		foreach(const ScriptIssue &issue, job.exposedUses.value(it.key())) {
+			if(!job.writtenVars.contains((issue.var.bank << 8) | issue.var.address)) {
+				issues.append(issue);
 			}
 		}
-		observer()->setObserverValue(fieldID);
 	}
 }
 
-void FieldArchive::removeTexts()
+class ValidateWalkmeshesJob : public FieldArchiveJob
 {
-	observer()->setObserverMaximum(fileList.size());
+public:
+	explicit ValidateWalkmeshesJob(FieldArchive *archive) :
+		FieldArchiveJob(archive) {}
+	QMap<int, QList<WalkmeshError> > errors; // By field ID
+protected:
+	bool processField(Field *field, int fieldID) {
+		IdFile *walkmesh = field->walkmesh();
+		if(!walkmesh->isOpen()) {
+			return true;
+		}
 
-	for(int fieldID=0 ; fieldID<fileList.size() ; ++fieldID) {
-		if(observer()->observerWasCanceled()) {
-			return;
+		QList<WalkmeshError> fieldErrors;
+		if(!walkmesh->validate(&fieldErrors)) {
+			QMutexLocker locker(&mutex);
+			errors.insert(fieldID, fieldErrors);
+		}
+		return true;
+	}
+private:
+	QMutex mutex;
+};
+
+/*!
+ * Reports degenerated triangles, broken accesses and
+ * non-manifold edges in every walkmesh.
+ * Issues are sorted by field ID.
+ */
+void FieldArchive::validateWalkmeshes(QList<WalkmeshIssue> &issues)
+{
+	ValidateWalkmeshesJob job(this);
+	job.exec(observer());
+
+	QMapIterator<int, QList<WalkmeshError> > it(job.errors);
+	while(it.hasNext()) {
+		it.next();
+		foreach(const WalkmeshError &error, it.value()) {
+			issues.append(WalkmeshIssue(it.key(), error));
+		}
+	}
+}
+
+class ScriptGraphJob : public FieldArchiveJob
+{
+public:
+	explicit ScriptGraphJob(FieldArchive *archive) :
+		FieldArchiveJob(archive) {}
+	QMap<int, QList<ExecEdge> > execs; // By field ID
+	QMap<int, QList<MapJumpEdge> > jumps; // By field ID
+protected:
+	bool processField(Field *field, int fieldID) {
+		Section1File *section1 = field->scriptsAndTexts();
+		if(!section1->isOpen()) {
+			return true;
 		}
-		Field *field = this->field(fieldID, true);
-		if(field != NULL && field->scriptsAndTexts()->isOpen()) {
-			field->scriptsAndTexts()->removeTexts();
-			if(field->scriptsAndTexts()->isModified() && !field->isModified()) {
-				field->setModified(true);
+
+		QList<ExecEdge> fieldExecs;
+		QList<MapJumpEdge> fieldJumps;
+		ScriptGraph::collectEdges(fieldID, section1, fieldExecs, fieldJumps);
+
+		QMutexLocker locker(&mutex);
+		execs.insert(fieldID, fieldExecs);
+		jumps.insert(fieldID, fieldJumps);
+		return true;
+	}
+private:
+	QMutex mutex;
+};
+
+/*!
+ * Returns the exec and map jump graph of the archive.
+ * The first call scans every field, then only fields
+ * marked by setScriptsModified() are scanned again.
+ */
+const ScriptGraph &FieldArchive::scriptGraph()
+{
+	if(!_scriptGraphBuilt) {
+		ScriptGraphJob job(this);
+		job.exec(observer());
+
+		_scriptGraph.clear();
+		QMapIterator<int, QList<ExecEdge> > it(job.execs);
+		while(it.hasNext()) {
+			it.next();
+			QList<MapJumpEdge> jumps = job.jumps.value(it.key());
+			resolveMapJumps(jumps);
+			_scriptGraph.setFieldEdges(it.key(), it.value(), jumps);
+		}
+		_scriptGraphBuilt = !job.wasCanceled();
+		return _scriptGraph;
+	}
+
+	_mutex.lock();
+	QSet<int> staleFields = _staleScriptGraphFields;
+	_staleScriptGraphFields.clear();
+	_mutex.unlock();
+
+	foreach(int fieldID, staleFields) {
+		Field *field = this->field(fieldID);
+		if(field) {
+			Section1File *section1 = field->scriptsAndTexts();
+			if(section1->isOpen()) {
+				updateScriptGraph(fieldID, section1);
+			} else {
+				_scriptGraph.removeFieldEdges(fieldID);
 			}
 		}
-		observer()->setObserverValue(fieldID);
 	}
+
+	return _scriptGraph;
 }
 
-void FieldArchive::cleanTexts()
+/*!
+ * Called by Section1File::setModified(), the field will be
+ * scanned again by the next scriptGraph() call.
+ */
+void FieldArchive::setScriptsModified(Field *field)
 {
-	observer()->setObserverMaximum(fileList.size());
+	QMutexLocker locker(&_mutex);
 
-	for(int fieldID=0 ; fieldID<fileList.size() ; ++fieldID) {
-		if(observer()->observerWasCanceled()) {
-			return;
+	if(_scriptGraphBuilt) {
+		int fieldID = fileList.indexOf(field);
+		if(fieldID >= 0) {
+			_staleScriptGraphFields.insert(fieldID);
 		}
-		Field *field = this->field(fieldID, true);
-		if(field != NULL && field->scriptsAndTexts()->isOpen()) {
-			field->scriptsAndTexts()->cleanTexts();
-			if(field->scriptsAndTexts()->isModified() && !field->isModified()) {
-				field->setModified(true);
+	}
+}
+
+/*!
+ * The first search across the archive builds the script graph,
+ * then the searches for an exec or a map jump only open
+ * the fields listed by the graph.
+ */
+bool FieldArchive::useScriptGraph(SearchScope scope)
+{
+	if(scope == GlobalScope || _scriptGraphBuilt) {
+		scriptGraph();
+	}
+	return _scriptGraphBuilt;
+}
+
+void FieldArchive::updateScriptGraph(int fieldID, const Section1File *scripts)
+{
+	QList<ExecEdge> execs;
+	QList<MapJumpEdge> jumps;
+	ScriptGraph::collectEdges(fieldID, scripts, execs, jumps);
+	resolveMapJumps(jumps);
+	_scriptGraph.setFieldEdges(fieldID, execs, jumps);
+}
+
+void FieldArchive::resolveMapJumps(QList<MapJumpEdge> &jumps) const
+{
+	for(int i=0 ; i<jumps.size() ; ++i) {
+		MapJumpEdge &edge = jumps[i];
+		if(edge.mapID < Data::field_names.size()) {
+			edge.targetFieldID = indexOfField(Data::field_names.at(edge.mapID));
+		}
+	}
+}
+
+void FieldArchive::invalidateScriptGraph()
+{
+	_scriptGraph.clear();
+	_staleScriptGraphFields.clear();
+	_scriptGraphBuilt = false;
+}
+
+class TextLayoutJob : public FieldArchiveJob
+{
+public:
+	explicit TextLayoutJob(FieldArchive *archive) :
+		FieldArchiveJob(archive) {}
+	QMap<int, QList<TextWindowLayout> > layouts; // By field ID
+protected:
+	bool processField(Field *field, int fieldID) {
+		Section1File *section1 = field->scriptsAndTexts();
+		if(!section1->isOpen()) {
+			return true;
+		}
+
+		QMultiMap<quint64, FF7Window> windows;
+		QMultiMap<quint8, quint64> text2win;
+		QList<TextWindowLayout> fieldLayouts;
+		section1->listWindows(windows, text2win);
+
+		QMapIterator<quint8, quint64> it(text2win);
+		while(it.hasNext()) {
+			it.next();
+			if(it.key() >= section1->textCount()) {
+				continue;
+			}
+			QSize size = layout.requiredSize(section1->text(it.key()).data());
+			foreach(const FF7Window &window, windows.values(it.value())) {
+				TextWindowLayout textLayout;
+				textLayout.fieldID = fieldID;
+				textLayout.textID = it.key();
+				textLayout.window = window;
+				textLayout.requiredSize = size;
+				fieldLayouts.append(textLayout);
 			}
 		}
-		observer()->setObserverValue(fieldID);
+
+		QMutexLocker locker(&mutex);
+		layouts.insert(fieldID, fieldLayouts);
+		return true;
 	}
+private:
+	FF7TextLayout layout;
+	QMutex mutex;
+};
+
+/*!
+ * Computes the size required by every text shown in a window.
+ * Layouts are sorted by field ID.
+ */
+void FieldArchive::layoutTexts(QList<TextWindowLayout> &layouts)
+{
+	FF7TextLayout::updateNames(); // Before using them from other threads
+	TextLayoutJob job(this);
+	job.exec(observer());
+
+	foreach(const QList<TextWindowLayout> &fieldLayouts, job.layouts) {
+		layouts.append(fieldLayouts);
+	}
+}
+
+class FieldFunctionJob : public FieldArchiveJob
+{
+public:
+	FieldFunctionJob(FieldArchive *archive, void (*function)(Field *)) :
+		FieldArchiveJob(archive), function(function) {}
+protected:
+	bool processField(Field *field, int fieldID) {
+		Q_UNUSED(fieldID)
+		if(field->scriptsAndTexts()->isOpen()) {
+			function(field);
+		}
+		return true;
+	}
+private:
+	void (*function)(Field *);
+};
+
+void FieldArchive::removeBattles()
+{
+	FieldFunctionJob job(this, [](Field *field) {
+		field->encounter()->setBattleEnabled(EncounterFile::Table1, false);
+		field->encounter()->setBattleEnabled(EncounterFile::Table2, false);
+		if(!field->isModified()) {
+			field->setModified(true);
+		}
+	});
+	job.exec(observer());
+}
+
+void FieldArchive::removeTexts()
+{
+	FieldFunctionJob job(this, [](Field *field) {
+		field->scriptsAndTexts()->removeTexts();
+		if(field->scriptsAndTexts()->isModified() && !field->isModified()) {
+			field->setModified(true);
+		}
+	});
+	job.exec(observer());
+}
+
+void FieldArchive::cleanTexts()
+{
+	FieldFunctionJob job(this, [](Field *field) {
+		field->scriptsAndTexts()->cleanTexts();
+		if(field->scriptsAndTexts()->isModified() && !field->isModified()) {
+			field->setModified(true);
+		}
+	});
+	job.exec(observer());
 }
 
 bool FieldArchive::exportation(const QList<int> &selectedFields, const QString &directory,
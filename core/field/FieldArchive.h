@@ -23,6 +23,7 @@
 #include <QtCore>
 #include "FieldArchiveIO.h"
 #include "Field.h"
+#include "ScriptGraph.h"
 
 struct SearchQuery
 {
@@ -99,7 +100,7 @@ struct SearchInText : public SearchIn
 
 	void reset() {
 		textID = 0;
-		from = -1;
+		from = 0;
 	}
 
 	void toEnd() {
@@ -108,24 +109,67 @@ struct SearchInText : public SearchIn
 	}
 };
 
+struct FieldCompileReport
+{
+	int fieldID;
+	qint64 elapsed; // In microseconds
+	QList<ScriptCompileError> errors;
+};
+
+struct ScriptIssue
+{
+	enum Type {
+		DeadCode, BadJump, UninitializedVar
+	};
+	ScriptIssue(Type type, int fieldID, int groupID, int scriptID, int opcodeID) :
+		type(type), fieldID(fieldID), groupID(groupID),
+		scriptID(scriptID), opcodeID(opcodeID), var(0, 0) {}
+	Type type;
+	int fieldID, groupID, scriptID, opcodeID;
+	FF7Var var; // UninitializedVar only
+};
+
+struct WalkmeshIssue
+{
+	WalkmeshIssue(int fieldID, const WalkmeshError &error) :
+		fieldID(fieldID), type(error.type),
+		triangleID(error.triangleID), edge(error.edge) {}
+	int fieldID;
+	WalkmeshError::Type type;
+	int triangleID, edge;
+};
+
+struct TextWindowLayout
+{
+	int fieldID, textID;
+	FF7Window window; // With the group, script and opcode of the window
+	QSize requiredSize; // Not limited to the screen size
+	inline bool isOverflowing() const {
+		return requiredSize.width() > window.w
+		        || requiredSize.height() > window.h;
+	}
+};
+
 class FieldArchive;
 
 class FieldArchiveIterator : public QListIterator<Field *>
 {
 	friend class FieldArchive;
 public:
-	explicit FieldArchiveIterator(const FieldArchive &archive);
+	explicit FieldArchiveIterator(FieldArchive &archive);
 	Field *next(bool open=true, bool dontOptimize=false);
 	Field *peekNext(bool open=true, bool dontOptimize=false) const;
 	Field *peekPrevious(bool open=true, bool dontOptimize=false) const;
 	Field *previous(bool open=true, bool dontOptimize=false);
 private:
-	static Field *openField(Field *field, bool open=true, bool dontOptimize=false);
+	Field *openField(Field *field, bool open=true, bool dontOptimize=false) const;
+	FieldArchive *_archive;
 };
 
 class FieldArchive
 {
 	friend class FieldArchiveIterator;
+	friend class FieldArchiveJob;
 public:
 	enum Sorting {
 		SortByName, SortByMapId
@@ -165,6 +209,16 @@ public:
 
 	bool isAllOpened() const;
 	bool isModified() const;
+
+	inline qint64 memoryBudget() const {
+		return _memoryBudget;
+	}
+	void setMemoryBudget(qint64 budget);
+	void pinField(Field *field);
+	void unpinField(Field *field);
+	void evictFields();
+	qint64 residentSize() const;
+	QList<int> reloadChangedFields();
 	QList<FF7Var> searchAllVars(QMap<FF7Var, QSet<QString> > &fieldNames);
 #ifdef DEBUG_FUNCTIONS
 	void validateAsk();
@@ -182,10 +236,10 @@ public:
 #endif
 	bool find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 			  SearchQuery *toSearch, int &fieldID, SearchIn *searchIn,
-			  Sorting sorting, SearchScope scope);
+			  Sorting sorting, SearchScope scope, const QSet<int> *candidates=0);
 	bool findLast(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 				  SearchQuery *toSearch, int &fieldID, SearchIn *searchIn,
-				  Sorting sorting, SearchScope scope);
+				  Sorting sorting, SearchScope scope, const QSet<int> *candidates=0);
 	bool searchOpcode(int opcode, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope);
 	bool searchVar(quint8 bank, quint16 address, Opcode::Operation op, int value, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope);
 	bool searchExec(quint8 group, quint8 script, int &fieldID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope);
@@ -201,6 +255,12 @@ public:
 	bool replaceText(const QRegExp &search, const QString &after, int fieldID, int textID, int from);
 
 	bool compileScripts(int &fieldID, int &groupID, int &scriptID, int &opcodeID, QString &errorStr);
+	bool compileScripts(QList<FieldCompileReport> &reports);
+	void analyzeScripts(QList<ScriptIssue> &issues);
+	void validateWalkmeshes(QList<WalkmeshIssue> &issues);
+	const ScriptGraph &scriptGraph();
+	void layoutTexts(QList<TextWindowLayout> &layouts);
+	void setScriptsModified(Field *field);
 	void removeBattles();
 	void removeTexts();
 	void cleanTexts();
@@ -225,7 +285,14 @@ private:
 	void updateFieldLists(Field *field, int fieldID);
 	bool searchIterators(QMap<QString, int>::const_iterator &i, QMap<QString, int>::const_iterator &end, int fieldID, Sorting sorting, SearchScope scope) const;
 	bool searchIteratorsP(QMap<QString, int>::const_iterator &i, QMap<QString, int>::const_iterator &end, int fieldID, Sorting sorting, SearchScope scope) const;
-	static bool openField(Field *field, bool dontOptimize=false);
+	bool openField(Field *field, bool dontOptimize=false);
+	void touchField(Field *field);
+	Field *acquireField(int id, bool open);
+	void releaseField(Field *field);
+	bool useScriptGraph(SearchScope scope);
+	void updateScriptGraph(int fieldID, const Section1File *scripts);
+	void resolveMapJumps(QList<MapJumpEdge> &jumps) const;
+	void invalidateScriptGraph();
 
 	QList<Field *> fileList;
 	QMultiMap<QString, int> fieldsSortByName;
@@ -233,6 +300,14 @@ private:
 
 	FieldArchiveIO *_io;
 	ArchiveObserver *_observer;
+	qint64 _memoryBudget; // 0 = unlimited
+	QList<Field *> _residentFields; // Least recently used first
+	QHash<Field *, int> _pinnedFields; // Pin count
+	QSet<Field *> _busyFields; // Used by a worker thread
+	mutable QMutex _mutex;
+	ScriptGraph _scriptGraph;
+	QSet<int> _staleScriptGraphFields;
+	bool _scriptGraphBuilt;
 	// QFileSystemWatcher fileWatcher;
 };
 
@@ -19,11 +19,22 @@
 #include "../LZS.h"
 #include "../Config.h"
 #include "FieldArchive.h"
+#include "FieldArchiveJob.h"
 #include "Field.h"
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#endif
 
 QByteArray FieldArchiveIO::fieldDataCache;
 Field *FieldArchiveIO::fieldCache=0;
 QString FieldArchiveIO::fieldExtensionCache;
+QMutex FieldArchiveIO::cacheMutex(QMutex::Recursive);
 
 FieldArchiveIO::FieldArchiveIO(FieldArchive *fieldArchive) :
 	_fieldArchive(fieldArchive)
@@ -68,6 +79,8 @@ QString FieldArchiveIO::directory() const
 
 QByteArray FieldArchiveIO::fieldData(Field *field, const QString &extension, bool unlzs)
 {
+	QMutexLocker locker(&cacheMutex);
+
 	// use data from the cache
 	if(unlzs && fieldDataIsCached(field, extension)) {
 //		qDebug() << "FieldArchive use field data from cache" << field->name();
@@ -76,7 +89,9 @@ QByteArray FieldArchiveIO::fieldData(Field *field, const QString &extension, boo
 		qDebug() << "FieldArchive don't use field data from cache" << field->name() << unlzs;
 	}*/
 
+	locker.unlock();
 	QByteArray data = fieldData2(field, extension, unlzs);
+	locker.relock();
 
 	// put decompressed data in the cache
 	if(unlzs && !data.isEmpty()) {
@@ -89,7 +104,10 @@ QByteArray FieldArchiveIO::fieldData(Field *field, const QString &extension, boo
 
 QByteArray FieldArchiveIO::fileData(const QString &fileName, bool unlzs, bool isLzsFile)
 {
+	QMutexLocker locker(&cacheMutex);
 	QByteArray data = fileData2(fileName);
+	// Decompressed outside the lock, LZS buffers are per thread
+	locker.unlock();
 	bool checkLzsHeader = !Config::value("lzsNotCheck").toBool();
 
 	if(isLzsFile && (unlzs || checkLzsHeader)) {
@@ -131,16 +149,40 @@ int FieldArchiveIO::exportFieldData(Field *field, const QString &extension, cons
 
 bool FieldArchiveIO::fieldDataIsCached(Field *field, const QString &fileType)
 {
+	QMutexLocker locker(&cacheMutex);
 	return fieldCache && fieldCache == field && fieldExtensionCache == fileType;
 }
 
 void FieldArchiveIO::clearCachedData()
 {
 //	qDebug() << "FieldArchive::clearCachedData()";
+	QMutexLocker locker(&cacheMutex);
 	fieldCache = 0;
 	fieldDataCache.clear();
 }
 
+/*!
+ * Clears the cache only if it contains data of this field.
+ */
+void FieldArchiveIO::clearCachedData(Field *field)
+{
+	QMutexLocker locker(&cacheMutex);
+	if(fieldCache == field) {
+		fieldCache = 0;
+		fieldDataCache.clear();
+	}
+}
+
+/*!
+ * Names of the fields whose files were changed by another program
+ * since the opening or the previous call.
+ * Only directories are checked.
+ */
+QStringList FieldArchiveIO::changedFields()
+{
+	return QStringList();
+}
+
 void FieldArchiveIO::close()
 {
 	clearCachedData();
@@ -162,6 +204,225 @@ FieldArchiveIO::ErrorCode FieldArchiveIO::save(const QString &path, ArchiveObser
 	return error;
 }
 
+/*!
+ * Name of the field file in a directory archive.
+ */
+QString FieldArchiveIO::fieldFileName(Field *field) const
+{
+	return field->name();
+}
+
+/*
+ * Writes modified fields and shares the unmodified ones
+ * between the source and the destination directories.
+ */
+class FieldDirSaveJob : public FieldArchiveJob
+{
+public:
+	FieldDirSaveJob(FieldArchiveIO *io, const QDir &source, const QDir &destination) :
+		FieldArchiveJob(io->fieldArchive()), error(FieldArchiveIO::Ok),
+		_io(io), _source(source), _destination(destination),
+		_saveAs(QDir::cleanPath(source.path()) != QDir::cleanPath(destination.path())),
+		_hardLink(Config::value("saveAsHardLinks", false).toBool()) {}
+	FieldArchiveIO::ErrorCode error;
+	QStringList writtenFiles;
+protected:
+	bool openFields() const {
+		return false;
+	}
+	bool processField(Field *field, int fieldID) {
+		Q_UNUSED(fieldID)
+		QString fileName = _io->fieldFileName(field);
+
+		if(field->isOpen() && field->isModified()) {
+			QByteArray data;
+			if(!field->save(data, true)) {
+				return setError(FieldArchiveIO::Invalid);
+			}
+			if(!FieldArchiveIO::writeFile(_destination.filePath(fileName), data)) {
+				return setError(FieldArchiveIO::ErrorOpening);
+			}
+			QMutexLocker locker(&mutex);
+			writtenFiles.append(fileName);
+		} else if(_saveAs
+		          && !FieldArchiveIO::shareOrCopyFile(_source.filePath(fileName),
+		                                              _destination.filePath(fileName),
+		                                              _hardLink)) {
+			return setError(FieldArchiveIO::ErrorCopying);
+		}
+
+		return true;
+	}
+private:
+	bool setError(FieldArchiveIO::ErrorCode err) {
+		QMutexLocker locker(&mutex);
+		if(error == FieldArchiveIO::Ok) {
+			error = err;
+		}
+		return false;
+	}
+
+	FieldArchiveIO *_io;
+	QDir _source, _destination;
+	bool _saveAs, _hardLink;
+	QMutex mutex;
+};
+
+/*!
+ * Saves a directory archive in destination, which can be the source.
+ * Modified fields are saved in parallel, in a save as the other files
+ * are shared with the source directory, so only modified fields are
+ * written. writtenFiles receives the names of the written field files.
+ */
+FieldArchiveIO::ErrorCode FieldArchiveIO::saveToDir(const QDir &source, const QDir &destination,
+                                                     QStringList &writtenFiles, ArchiveObserver *observer)
+{
+	FieldDirSaveJob job(this, source, destination);
+	if(!job.exec(observer)) {
+		return Aborted;
+	}
+	if(job.error != Ok) {
+		return job.error;
+	}
+	writtenFiles = job.writtenFiles;
+
+	if(QDir::cleanPath(source.path()) == QDir::cleanPath(destination.path())) {
+		return Ok;
+	}
+
+	// Other files: maplist, tutorials, textures, world map...
+	QSet<QString> fieldFiles;
+	for(int fieldID=0 ; fieldID<fieldArchive()->size() ; ++fieldID) {
+		Field *field = fieldArchive()->field(fieldID, false);
+		if(field) {
+			fieldFiles.insert(fieldFileName(field));
+		}
+	}
+
+	const bool hardLink = Config::value("saveAsHardLinks", false).toBool();
+	foreach(const QString &fileName, source.entryList(QDir::Files | QDir::NoSymLinks)) {
+		if(!fieldFiles.contains(fileName)
+		        && !shareOrCopyFile(source.filePath(fileName),
+		                            destination.filePath(fileName), hardLink)) {
+			return ErrorCopying;
+		}
+	}
+
+	return Ok;
+}
+
+/*!
+ * Replaces the file instead of writing into it,
+ * because it can be a hard link shared with another directory.
+ * The previous file is kept aside until the new one is in place,
+ * and restored if the replacement fails.
+ */
+bool FieldArchiveIO::writeFile(const QString &path, const QByteArray &data)
+{
+	QString tempPath = path + ".tmp", oldPath = path + ".old";
+	QFile f(tempPath);
+	if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	if(f.write(data) != data.size()) {
+		f.remove();
+		return false;
+	}
+	f.close();
+
+	const bool exists = QFile::exists(path);
+	if(exists) {
+		if(QFile::exists(oldPath)) {
+			QFile::remove(oldPath);
+		}
+		if(!QFile::rename(path, oldPath)) {
+			QFile::remove(tempPath);
+			return false;
+		}
+	}
+
+	if(!QFile::rename(tempPath, path)) {
+		QFile::remove(tempPath);
+		if(exists) {
+			QFile::rename(oldPath, path);
+		}
+		return false;
+	}
+
+	if(exists) {
+		QFile::remove(oldPath);
+	}
+
+	return true;
+}
+
+/*!
+ * Copies a file without duplicating its data when the file system allows it:
+ * reflink (copy-on-write clone), then plain copy.
+ * With hardLink (the "saveAsHardLinks" option, off by default), a hard
+ * link is tried before copying: both directories then share the file,
+ * another program writing into one of them changes the other.
+ * Makou Reactor always replaces these files, see writeFile().
+ */
+bool FieldArchiveIO::shareOrCopyFile(const QString &source, const QString &destination,
+                                     bool hardLink)
+{
+	if(QFile::exists(destination) && !QFile::remove(destination)) {
+		return false;
+	}
+
+	QFile src(source), dst(destination);
+
+#ifdef FICLONE
+	if(src.open(QIODevice::ReadOnly) && dst.open(QIODevice::WriteOnly)) {
+		if(::ioctl(dst.handle(), FICLONE, src.handle()) == 0) {
+			return true;
+		}
+	}
+	src.close();
+	if(dst.isOpen()) {
+		dst.remove();
+	}
+#endif
+
+	if(hardLink) {
+#ifdef Q_OS_WIN
+		if(CreateHardLinkW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(destination).utf16()),
+		                   reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16()),
+		                   NULL)) {
+			return true;
+		}
+#else
+		if(::link(QFile::encodeName(source).constData(),
+		          QFile::encodeName(destination).constData()) == 0) {
+			return true;
+		}
+#endif
+	}
+
+	// Different devices or file system without links
+	if(!src.open(QIODevice::ReadOnly)
+	        || !dst.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	QByteArray buffer;
+	buffer.resize(4 * 1024 * 1024);
+	qint64 size;
+	while((size = src.read(buffer.data(), buffer.size())) > 0) {
+		if(dst.write(buffer.constData(), size) != size) {
+			break;
+		}
+	}
+
+	if(size != 0) {
+		dst.remove();
+		return false;
+	}
+
+	return true;
+}
+
 FieldArchiveIO::ErrorCode FieldArchiveIO::addField(const QString &fileName,
                                                    const QString &name)
 {
@@ -169,3 +430,102 @@ FieldArchiveIO::ErrorCode FieldArchiveIO::addField(const QString &fileName,
 	Q_UNUSED(name);
 	return NotImplemented;
 }
+
+FileStamps::FileStamps(Qt::CaseSensitivity cs) :
+	_cs(cs), _mutex(QMutex::Recursive)
+{
+}
+
+void FileStamps::clear()
+{
+	QMutexLocker locker(&_mutex);
+	_stamps.clear();
+}
+
+void FileStamps::insert(const QFileInfo &info)
+{
+	QMutexLocker locker(&_mutex);
+	FileStamp stamp;
+	stamp.size = info.size();
+	stamp.lastModified = info.lastModified();
+	_stamps.insert(key(info.fileName()), stamp);
+}
+
+/*!
+ * Remembers the hash of the data read from the file.
+ */
+void FileStamps::setHash(const QString &fileName, const QByteArray &data)
+{
+	QByteArray dataHash = hash(data);
+	QMutexLocker locker(&_mutex);
+	QHash<QString, FileStamp>::iterator it = _stamps.find(key(fileName));
+	if(it != _stamps.end()) {
+		it->hash = dataHash;
+	}
+}
+
+/*!
+ * Returns the changed files in infos and updates the stamps.
+ * When the hash of a file is known, a file with the same content
+ * is not considered as changed.
+ */
+QStringList FileStamps::update(const QFileInfoList &infos, QStringList &added, QStringList &removed)
+{
+	QMutexLocker locker(&_mutex);
+	QStringList changed;
+	QSet<QString> names;
+
+	foreach(const QFileInfo &info, infos) {
+		QString fileName = info.fileName();
+		names.insert(key(fileName));
+
+		QHash<QString, FileStamp>::iterator it = _stamps.find(key(fileName));
+		if(it == _stamps.end()) {
+			added.append(fileName);
+			insert(info);
+			continue;
+		}
+
+		FileStamp &stamp = it.value();
+		if(stamp.size == info.size() && stamp.lastModified == info.lastModified()) {
+			continue;
+		}
+
+		bool sameContent = false;
+		if(!stamp.hash.isEmpty() && stamp.size == info.size()) {
+			QFile f(info.filePath());
+			if(f.open(QIODevice::ReadOnly)) {
+				sameContent = hash(f.readAll()) == stamp.hash;
+				f.close();
+			}
+		}
+
+		stamp.size = info.size();
+		stamp.lastModified = info.lastModified();
+		if(!sameContent) {
+			stamp.hash.clear();
+			changed.append(fileName);
+		}
+	}
+
+	QMutableHashIterator<QString, FileStamp> it(_stamps);
+	while(it.hasNext()) {
+		it.next();
+		if(!names.contains(it.key())) {
+			removed.append(it.key());
+			it.remove();
+		}
+	}
+
+	return changed;
+}
+
+QByteArray FileStamps::hash(const QByteArray &data)
+{
+	return QCryptographicHash::hash(data, QCryptographicHash::Md5);
+}
+
+QString FileStamps::key(const QString &fileName) const
+{
+	return _cs == Qt::CaseInsensitive ? fileName.toUpper() : fileName;
+}
@@ -24,8 +24,37 @@
 class FieldArchive;
 class Field;
 
+struct FileStamp
+{
+	qint64 size;
+	QDateTime lastModified;
+	QByteArray hash; // Empty until the file is read
+};
+
+/*
+ * Size, date and hash of the files of a directory,
+ * to find the files changed by other programs.
+ * Hashes can be set from worker threads.
+ */
+class FileStamps
+{
+public:
+	explicit FileStamps(Qt::CaseSensitivity cs = Qt::CaseSensitive);
+	void clear();
+	void insert(const QFileInfo &info);
+	void setHash(const QString &fileName, const QByteArray &data);
+	QStringList update(const QFileInfoList &infos, QStringList &added, QStringList &removed);
+private:
+	static QByteArray hash(const QByteArray &data);
+	QString key(const QString &fileName) const;
+	QHash<QString, FileStamp> _stamps;
+	Qt::CaseSensitivity _cs;
+	QMutex _mutex;
+};
+
 class FieldArchiveIO
 {
+	friend class FieldDirSaveJob;
 public:
 	enum ErrorCode {
 		Ok, FieldNotFound, ErrorOpening,
@@ -49,6 +78,8 @@ public:
 
 	static bool fieldDataIsCached(Field *field, const QString &fileType);
 	virtual void clearCachedData();
+	virtual void clearCachedData(Field *field);
+	virtual QStringList changedFields();
 
 	virtual void close();
 	ErrorCode open(ArchiveObserver *observer=0);
@@ -71,6 +102,14 @@ protected:
 	virtual ErrorCode open2(ArchiveObserver *observer)=0;
 	virtual ErrorCode save2(const QString &path, ArchiveObserver *observer)=0;
 	FieldArchive *fieldArchive();
+
+	virtual QString fieldFileName(Field *field) const;
+	ErrorCode saveToDir(const QDir &source, const QDir &destination,
+	                    QStringList &writtenFiles, ArchiveObserver *observer);
+	static bool writeFile(const QString &path, const QByteArray &data);
+	static bool shareOrCopyFile(const QString &source, const QString &destination,
+	                            bool hardLink = false);
+	static QMutex cacheMutex; // Serializes device reads and the caches
 private:
 	FieldArchive *_fieldArchive;
 	static QByteArray fieldDataCache, mimDataCache, modelDataCache;
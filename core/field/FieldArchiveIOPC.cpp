@@ -307,21 +307,26 @@ QByteArray FieldArchiveIOPCDir::fileData2(const QString &fileName)
 	data = f.readAll();
 	f.close();
 
+	stamps.setHash(fileName, data);
+
 	return data;
 }
 
 FieldArchiveIO::ErrorCode FieldArchiveIOPCDir::open2(ArchiveObserver *observer)
 {
-	QStringList list;
-	list.append("*");
-	list = dir.entryList(list, QDir::Files | QDir::NoSymLinks);
+	QFileInfoList list = dir.entryInfoList(QStringList("*"), QDir::Files | QDir::NoSymLinks);
 
 	if(observer)	observer->setObserverMaximum(list.size());
 
 	// QTime t;t.start();
 
+	stamps.clear();
+
 	int i=0;
-	foreach(const QString &name, list) {
+	foreach(const QFileInfo &info, list) {
+		const QString name = info.fileName();
+		stamps.insert(info);
+
 		if(observer) {
 			if(observer->observerWasCanceled()) {
 				return Aborted;
@@ -345,40 +350,35 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCDir::open2(ArchiveObserver *observer)
 	return Ok;
 }
 
-FieldArchiveIO::ErrorCode FieldArchiveIOPCDir::save2(const QString &path, ArchiveObserver *observer)
+QStringList FieldArchiveIOPCDir::changedFields()
 {
-	bool saveAs;
+	QStringList added, removed, fieldNames;
+	QStringList changed = stamps.update(dir.entryInfoList(QStringList("*"), QDir::Files | QDir::NoSymLinks), added, removed);
 
-	if(!path.isEmpty()) {
-		saveAs = QDir::cleanPath(path) != QDir::cleanPath(dir.path());
-	} else {
-		saveAs = false;
+	foreach(const QString &name, changed) {
+		if(!name.contains(".")) {
+			fieldNames.append(name);
+		}
 	}
 
-	quint32 nbFiles = fieldArchive()->size();
-	if(observer)	observer->setObserverMaximum(nbFiles);
-
-	for(quint32 fieldID=0 ; fieldID<nbFiles ; ++fieldID) {
-		if(observer && observer->observerWasCanceled()) {
-			return Aborted;
-		}
-		Field *field = fieldArchive()->field(fieldID, false);
-		if(field) {
-			QString fileName = field->name(),
-			        filePath = dir.filePath(fileName);
-			if(field->isOpen() && field->isModified()) {
-				qint8 err = field->save(filePath, true);
-				if(err == 2)	return ErrorOpening;
-				if(err == 1)	return Invalid;
-				if(err != 0)	return NotImplemented;
-			} else if(saveAs) {
-				QString dstPath = path + "/" + fileName;
-				if(!QFile::copy(filePath, dstPath)) {
-					return ErrorCopying;
-				}
-			}
+	foreach(const QString &name, added + removed) {
+		if(!name.contains(".")) {
+			qWarning() << "FieldArchiveIOPCDir::changedFields" << name << "added or removed, reopen the directory to update the field list";
 		}
-		if(observer)	observer->setObserverValue(fieldID);
+	}
+
+	return fieldNames;
+}
+
+FieldArchiveIO::ErrorCode FieldArchiveIOPCDir::save2(const QString &path, ArchiveObserver *observer)
+{
+	QDir destination = path.isEmpty() ? dir : QDir(path);
+	bool saveAs = QDir::cleanPath(destination.path()) != QDir::cleanPath(dir.path());
+	QStringList writtenFiles;
+
+	ErrorCode error = saveToDir(dir, destination, writtenFiles, observer);
+	if(error != Ok) {
+		return error;
 	}
 
 	QMapIterator<QString, TutFilePC *> itTut(fieldArchive()->tuts());
@@ -388,13 +388,17 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCDir::save2(const QString &path, Archiv
 		TutFile *tut = itTut.value();
 
 		if(tut != NULL && tut->isModified()) {
-			QFile tutFile(dir.filePath(itTut.key() + ".tut"));
-			if(tutFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-				tutFile.write(tut->save());
-				tutFile.close();
-			} else {
+			QString fileName = itTut.key() + ".tut";
+			if(!writeFile(destination.filePath(fileName), tut->save())) {
 				return ErrorOpening;
 			}
+			writtenFiles.append(fileName);
+		}
+	}
+
+	if(!saveAs) {
+		foreach(const QString &fileName, writtenFiles) {
+			stamps.insert(QFileInfo(dir.filePath(fileName)));
 		}
 	}
 
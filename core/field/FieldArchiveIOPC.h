@@ -102,6 +102,7 @@ public:
 	inline bool hasName() const { return false; }
 
 	Archive *device();
+	QStringList changedFields();
 private:
 	QByteArray fieldData2(Field *field, const QString &extension, bool unlzs);
 	QByteArray fileData2(const QString &fileName);
@@ -110,6 +111,7 @@ private:
 	ErrorCode save2(const QString &path, ArchiveObserver *observer);
 
 	QDir dir;
+	FileStamps stamps;
 };
 
 #endif // FIELDARCHIVEIOPC_H
@@ -34,12 +34,16 @@ FieldArchiveIOPS::FieldArchiveIOPS(FieldArchivePS *fieldArchive) :
 
 QByteArray FieldArchiveIOPS::mimData(Field *field, bool unlzs)
 {
+	QMutexLocker locker(&cacheMutex);
+
 	// use data from the cache
 	if(unlzs && mimDataIsCached(field)) {
 		return mimDataCache;
 	}
 
+	locker.unlock();
 	QByteArray data = mimData2(field, unlzs);
+	locker.relock();
 
 	// put decompressed data in the cache
 	if(unlzs && !data.isEmpty()) {
@@ -51,12 +55,16 @@ QByteArray FieldArchiveIOPS::mimData(Field *field, bool unlzs)
 
 QByteArray FieldArchiveIOPS::modelData(Field *field, bool unlzs)
 {
+	QMutexLocker locker(&cacheMutex);
+
 	// use data from the cache
 	if(unlzs && modelDataIsCached(field)) {
 		return modelDataCache;
 	}
 
+	locker.unlock();
 	QByteArray data = modelData2(field, unlzs);
+	locker.relock();
 
 	// put decompressed data in the cache
 	if(unlzs && !data.isEmpty()) {
@@ -78,6 +86,7 @@ bool FieldArchiveIOPS::modelDataIsCached(Field *field)
 
 void FieldArchiveIOPS::clearCachedData()
 {
+	QMutexLocker locker(&cacheMutex);
 	mimCache = 0;
 	modelCache = 0;
 	mimDataCache.clear();
@@ -85,6 +94,20 @@ void FieldArchiveIOPS::clearCachedData()
 	FieldArchiveIO::clearCachedData();
 }
 
+void FieldArchiveIOPS::clearCachedData(Field *field)
+{
+	QMutexLocker locker(&cacheMutex);
+	if(mimCache == field) {
+		mimCache = 0;
+		mimDataCache.clear();
+	}
+	if(modelCache == field) {
+		modelCache = 0;
+		modelDataCache.clear();
+	}
+	FieldArchiveIO::clearCachedData(field);
+}
+
 FieldArchivePS *FieldArchiveIOPS::fieldArchive()
 {
 	return static_cast<FieldArchivePS *>(FieldArchiveIO::fieldArchive());
@@ -350,7 +373,7 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPSIso::save2(const QString &path0, Archi
 }
 
 FieldArchiveIOPSDir::FieldArchiveIOPSDir(const QString &path, FieldArchivePS *fieldArchive) :
-	FieldArchiveIOPS(fieldArchive), dir(path)
+	FieldArchiveIOPS(fieldArchive), dir(path), stamps(Qt::CaseInsensitive)
 {
 }
 
@@ -391,21 +414,31 @@ QByteArray FieldArchiveIOPSDir::fileData2(const QString &fileName)
 	data = f.readAll();
 	f.close();
 
+	stamps.setHash(fileName, data);
+
 	return data;
 }
 
+static QStringList fieldFileFilters()
+{
+	return QStringList() << "*.DAT" << "*.MIM" << "*.BSX";
+}
+
 FieldArchiveIO::ErrorCode FieldArchiveIOPSDir::open2(ArchiveObserver *observer)
 {
-	QStringList list;
-	list.append("*.DAT");
-	list = dir.entryList(list, QDir::Files | QDir::NoSymLinks);
+	QFileInfoList list = dir.entryInfoList(fieldFileFilters(), QDir::Files | QDir::NoSymLinks);
 
 	if(observer)	observer->setObserverMaximum(list.size());
 
 	// QTime t;t.start();
 
+	stamps.clear();
+
 	int i=0;
-	foreach(const QString &name, list) {
+	foreach(const QFileInfo &info, list) {
+		const QString name = info.fileName();
+		stamps.insert(info);
+
 		if(observer) {
 			if(observer->observerWasCanceled()) {
 				return Aborted;
@@ -413,7 +446,8 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPSDir::open2(ArchiveObserver *observer)
 			observer->setObserverValue(i++);
 		}
 
-		if(!name.startsWith("WM", Qt::CaseInsensitive)) {
+		if(!name.startsWith("WM", Qt::CaseInsensitive)
+				&& name.endsWith(".DAT", Qt::CaseInsensitive)) {
 			fieldArchive()->appendField(new FieldPS(name.left(name.lastIndexOf('.')), this));
 		}
 	}
@@ -423,41 +457,50 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPSDir::open2(ArchiveObserver *observer)
 	return Ok;
 }
 
-FieldArchiveIO::ErrorCode FieldArchiveIOPSDir::save2(const QString &path, ArchiveObserver *observer)
+QStringList FieldArchiveIOPSDir::changedFields()
 {
-	bool saveAs;
+	QStringList added, removed, fieldNames;
+	QStringList changed = stamps.update(dir.entryInfoList(fieldFileFilters(), QDir::Files | QDir::NoSymLinks), added, removed);
 
-	if(!path.isEmpty()) {
-		saveAs = QDir::cleanPath(path) != QDir::cleanPath(dir.path());
-	} else {
-		saveAs = false;
+	foreach(const QString &name, changed) {
+		if(!name.startsWith("WM", Qt::CaseInsensitive)) {
+			QString fieldName = name.left(name.lastIndexOf('.'));
+			if(!fieldNames.contains(fieldName)) {
+				fieldNames.append(fieldName);
+			}
+		}
 	}
 
-	quint32 nbFiles = fieldArchive()->size();
-	if(observer)	observer->setObserverMaximum(nbFiles);
-
-	for(quint32 fieldID=0 ; fieldID<nbFiles ; ++fieldID) {
-		if(observer && observer->observerWasCanceled()) {
-			return Aborted;
+	foreach(const QString &name, added + removed) {
+		if(!name.startsWith("WM", Qt::CaseInsensitive)
+				&& name.endsWith(".DAT", Qt::CaseInsensitive)) {
+			qWarning() << "FieldArchiveIOPSDir::changedFields" << name << "added or removed, reopen the directory to update the field list";
 		}
-		Field *field = fieldArchive()->field(fieldID, false);
-		QString datName = field->name().toUpper() + ".DAT",
-		        datPath = dir.filePath(datName);
-		if(field) {
-			if(field->isOpen() && field->isModified()) {
-				qint8 err = field->save(datPath, true);
-				if(err == 2)	return ErrorOpening;
-				if(err == 1)	return Invalid;
-				if(err != 0)	return NotImplemented;
-			} else if(saveAs) {
-				QString dstPath = path + "/" + datName;
-				if(!QFile::copy(datPath, dstPath)) {
-					return ErrorCopying;
-				}
-			}
+	}
+
+	return fieldNames;
+}
+
+FieldArchiveIO::ErrorCode FieldArchiveIOPSDir::save2(const QString &path, ArchiveObserver *observer)
+{
+	QDir destination = path.isEmpty() ? dir : QDir(path);
+	QStringList writtenFiles;
+
+	ErrorCode error = saveToDir(dir, destination, writtenFiles, observer);
+	if(error != Ok) {
+		return error;
+	}
+
+	if(QDir::cleanPath(destination.path()) == QDir::cleanPath(dir.path())) {
+		foreach(const QString &fileName, writtenFiles) {
+			stamps.insert(QFileInfo(dir.filePath(fileName)));
 		}
-		if(observer)	observer->setObserverValue(fieldID);
 	}
 
 	return Ok;
 }
+
+QString FieldArchiveIOPSDir::fieldFileName(Field *field) const
+{
+	return field->name().toUpper() + ".DAT";
+}
@@ -36,6 +36,7 @@ public:
 	static bool mimDataIsCached(Field *field);
 	static bool modelDataIsCached(Field *field);
 	void clearCachedData();
+	void clearCachedData(Field *field);
 protected:
 	virtual QByteArray mimData2(Field *field, bool unlzs)=0;
 	virtual QByteArray modelData2(Field *field, bool unlzs)=0;
@@ -102,6 +103,7 @@ public:
 	inline bool hasName() const { return false; }
 
 	Archive *device();
+	QStringList changedFields();
 private:
 	QByteArray fieldData2(Field *field, const QString &extension, bool unlzs);
 	QByteArray mimData2(Field *field, bool unlzs);
@@ -110,8 +112,10 @@ private:
 
 	ErrorCode open2(ArchiveObserver *observer);
 	ErrorCode save2(const QString &path, ArchiveObserver *observer);
+	QString fieldFileName(Field *field) const;
 
 	QDir dir;
+	FileStamps stamps;
 };
 
 #endif // FIELDARCHIVEIOPS_H
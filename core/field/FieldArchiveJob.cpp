@@ -0,0 +1,196 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "FieldArchiveJob.h"
+#include "FieldArchive.h"
+#include "../Archive.h"
+
+class FieldArchiveJobThread : public QThread
+{
+public:
+	explicit FieldArchiveJobThread(FieldArchiveJob *job) :
+		QThread(job), _job(job) {}
+protected:
+	void run() {
+		_job->work();
+	}
+private:
+	FieldArchiveJob *_job;
+};
+
+FieldArchiveJob::FieldArchiveJob(FieldArchive *archive, QObject *parent) :
+	QObject(parent), _archive(archive), _observer(0), _fieldCount(0)
+{
+}
+
+FieldArchiveJob::~FieldArchiveJob()
+{
+	cancel();
+	wait();
+}
+
+/*!
+ * Starts the job in worker threads and returns immediately.
+ * finished() is emitted when every field is processed,
+ * or when the job is stopped.
+ */
+void FieldArchiveJob::start()
+{
+	if(isRunning()) {
+		return;
+	}
+
+	wait();
+	qDeleteAll(_threads);
+	_threads.clear();
+
+	_fieldCount = _archive->size();
+	_nextField.fetchAndStoreOrdered(0);
+	_processed.fetchAndStoreOrdered(0);
+	_stopped.fetchAndStoreOrdered(0);
+	_canceled.fetchAndStoreOrdered(0);
+
+	if(_fieldCount <= 0) {
+		emit finished();
+		return;
+	}
+
+	int threadCount = qBound(1, QThread::idealThreadCount(), _fieldCount);
+	_runningThreads.fetchAndStoreOrdered(threadCount);
+
+	for(int i=0 ; i<threadCount ; ++i) {
+		_threads.append(new FieldArchiveJobThread(this));
+	}
+	foreach(QThread *thread, _threads) {
+		thread->start();
+	}
+}
+
+/*!
+ * Runs the job and waits for its end, the event loop is still running
+ * but user input is not processed, so the archive is not used
+ * by the GUI during the job.
+ * The observer is updated from the calling thread and can cancel the job.
+ * Returns false if the job was canceled.
+ */
+bool FieldArchiveJob::exec(ArchiveObserver *observer)
+{
+	_observer = observer;
+	if(_observer) {
+		_observer->setObserverMaximum(_archive->size());
+	}
+
+	QEventLoop loop;
+	QTimer timer;
+	connect(this, SIGNAL(finished()), &loop, SLOT(quit()));
+	connect(&timer, SIGNAL(timeout()), SLOT(updateObserver()));
+
+	start();
+	if(isRunning()) {
+		timer.start(100);
+		loop.exec(QEventLoop::ExcludeUserInputEvents);
+		timer.stop();
+	}
+	wait();
+
+	updateObserver();
+	_observer = 0;
+
+	return !wasCanceled();
+}
+
+void FieldArchiveJob::wait()
+{
+	foreach(QThread *thread, _threads) {
+		thread->wait();
+	}
+}
+
+bool FieldArchiveJob::isRunning() const
+{
+	return _runningThreads.fetchAndAddOrdered(0) > 0;
+}
+
+bool FieldArchiveJob::wasCanceled() const
+{
+	return _canceled.fetchAndAddOrdered(0) != 0;
+}
+
+int FieldArchiveJob::processedCount() const
+{
+	return _processed.fetchAndAddOrdered(0);
+}
+
+int FieldArchiveJob::fieldCount() const
+{
+	return _fieldCount;
+}
+
+/*!
+ * Asks the workers to stop after their current field.
+ */
+void FieldArchiveJob::cancel()
+{
+	_canceled.fetchAndStoreOrdered(1);
+	stop();
+}
+
+void FieldArchiveJob::stop()
+{
+	_stopped.fetchAndStoreOrdered(1);
+}
+
+bool FieldArchiveJob::openFields() const
+{
+	return true;
+}
+
+void FieldArchiveJob::updateObserver()
+{
+	if(!_observer) {
+		return;
+	}
+	if(_observer->observerWasCanceled()) {
+		cancel();
+	}
+	_observer->setObserverValue(processedCount());
+}
+
+void FieldArchiveJob::work()
+{
+	int fieldID;
+
+	while(!_stopped.fetchAndAddOrdered(0)
+	      && (fieldID = _nextField.fetchAndAddOrdered(1)) < _fieldCount) {
+		Field *field = _archive->acquireField(fieldID, openFields());
+		if(field != NULL) {
+			if(!processField(field, fieldID)) {
+				stop();
+			}
+			_archive->releaseField(field);
+			// Fields used by other workers are busy
+			_archive->evictFields();
+		}
+		_processed.fetchAndAddOrdered(1);
+		emit fieldProcessed(fieldID);
+	}
+
+	// The last thread notifies the end of the job
+	if(!_runningThreads.deref()) {
+		emit finished();
+	}
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef FIELDARCHIVEJOB_H
+#define FIELDARCHIVEJOB_H
+
+#include <QtCore>
+
+class ArchiveObserver;
+class FieldArchive;
+class Field;
+
+/*
+ * Runs an operation on every field of an archive,
+ * fields are shared between worker threads.
+ */
+class FieldArchiveJob : public QObject
+{
+	Q_OBJECT
+	friend class FieldArchiveJobThread;
+public:
+	explicit FieldArchiveJob(FieldArchive *archive, QObject *parent = 0);
+	virtual ~FieldArchiveJob();
+	void start();
+	bool exec(ArchiveObserver *observer = 0);
+	void wait();
+	bool isRunning() const;
+	bool wasCanceled() const;
+	int processedCount() const;
+	int fieldCount() const;
+public slots:
+	void cancel();
+signals:
+	void fieldProcessed(int fieldID);
+	void finished();
+protected:
+	// Called from a worker thread, returns false to stop the job
+	virtual bool processField(Field *field, int fieldID)=0;
+	// Open fields before processing them
+	virtual bool openFields() const;
+	void stop();
+	inline FieldArchive *archive() const {
+		return _archive;
+	}
+private slots:
+	void updateObserver();
+private:
+	void work();
+
+	FieldArchive *_archive;
+	ArchiveObserver *_observer;
+	QList<QThread *> _threads;
+	int _fieldCount;
+	mutable QAtomicInt _nextField, _processed, _stopped, _canceled, _runningThreads;
+};
+
+#endif // FIELDARCHIVEJOB_H
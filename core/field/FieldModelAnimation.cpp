@@ -17,8 +17,21 @@
  ****************************************************************************/
 #include "FieldModelAnimation.h"
 
-FieldModelAnimation::FieldModelAnimation()
+FieldModelAnimation::FieldModelAnimation() :
+	_frameCount(0), _boneCount(0), _translationCount(0)
 {
-	
 }
 
+/*!
+ * Allocates \a frameCount frames of \a boneCount rotations
+ * and \a translationCount translations, previous frames are lost.
+ */
+void FieldModelAnimation::resize(int frameCount, int boneCount,
+                                 int translationCount)
+{
+	_frameCount = frameCount;
+	_boneCount = boneCount;
+	_translationCount = translationCount;
+	_rotations.fill(PolyVertex(), frameCount * boneCount);
+	_translations.fill(PolyVertex(), frameCount * translationCount);
+}
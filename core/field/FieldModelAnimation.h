@@ -21,37 +21,46 @@
 #include <QtCore>
 #include "FieldModelPart.h"
 
+/*
+ * Frames are stored densely: frameCount() * boneCount() rotations,
+ * then frameCount() * translationCount() translations.
+ */
 class FieldModelAnimation
 {
 public:
 	FieldModelAnimation();
 
-	inline QList<PolyVertex> rotations(int frame) const {
-		return _framesRot.value(frame);
+	void resize(int frameCount, int boneCount, int translationCount);
+	inline const PolyVertex *rotations(int frame) const {
+		return _rotations.constData() + frame * _boneCount;
 	}
-	inline QList<PolyVertex> translations(int frame) const {
-		return _framesTrans.value(frame);
+	inline PolyVertex *rotations(int frame) {
+		return _rotations.data() + frame * _boneCount;
 	}
-	inline void insertFrame(int frame, const QList<PolyVertex> &rotations,
-							const QList<PolyVertex> &translations) {
-		_framesRot.insert(frame, rotations);
-		_framesTrans.insert(frame, translations);
+	inline const PolyVertex *translations(int frame) const {
+		return _translations.constData() + frame * _translationCount;
+	}
+	inline PolyVertex *translations(int frame) {
+		return _translations.data() + frame * _translationCount;
 	}
 	inline void clear() {
-		_framesRot.clear();
-		_framesTrans.clear();
+		resize(0, 0, 0);
 	}
 	inline int frameCount() const {
-		return _framesRot.size();
+		return _frameCount;
 	}
 	inline int boneCount() const {
-		return isEmpty() ? 0 : rotations(0).size();
+		return _boneCount;
+	}
+	inline int translationCount() const {
+		return _translationCount;
 	}
 	inline bool isEmpty() const {
-		return _framesRot.isEmpty();
+		return _frameCount == 0;
 	}
 private:
-	QHash<int, QList<PolyVertex> > _framesRot, _framesTrans;
+	int _frameCount, _boneCount, _translationCount;
+	QVector<PolyVertex> _rotations, _translations;
 };
 
 #endif // FIELDMODELANIMATION_H
@@ -35,9 +35,102 @@ void FieldModelFile::clear()
 	}
 	_skeleton.clear();
 	_animations.clear();
+	_mesh.clear();
+	_poses.clear();
 }
 
 bool FieldModelFile::isValid() const
 {
 	return !_animations.isEmpty() && !_skeleton.isEmpty();
 }
+
+/*!
+ * Returns the skeleton polygons baked into vertex arrays,
+ * the mesh is built on the first call after a change.
+ */
+const FieldModelMesh &FieldModelFile::mesh()
+{
+	if(_mesh.serial() == 0) {
+		_mesh.bake(this);
+	}
+	return _mesh;
+}
+
+/*!
+ * Returns the model-space matrix of every bone for the \a frame
+ * of the animation \a animationID, or NULL if out of range.
+ * Matrices are computed on the first call and cached.
+ */
+const QMatrix4x4 *FieldModelFile::boneMatrices(int animationID, int frame)
+{
+	if(animationID < 0 || animationID >= _animations.size()) {
+		return NULL;
+	}
+
+	const FieldModelAnimation &animation = _animations.at(animationID);
+
+	if(frame < 0 || frame >= animation.frameCount()) {
+		return NULL;
+	}
+
+	// _animations can be modified directly by subclasses
+	if(_poses.size() != _animations.size()) {
+		_poses.clear();
+		_poses.resize(_animations.size());
+	}
+
+	const int boneCount = _skeleton.boneCount();
+	PoseCache &cache = _poses[animationID];
+
+	if(cache.computedFrames.isEmpty()) {
+		cache.matrices.resize(animation.frameCount() * boneCount);
+		cache.computedFrames.resize(animation.frameCount());
+	}
+
+	QMatrix4x4 *matrices = cache.matrices.data() + frame * boneCount;
+
+	if(!cache.computedFrames.testBit(frame)) {
+		computePose(animation, frame, matrices);
+		cache.computedFrames.setBit(frame);
+	}
+
+	return matrices;
+}
+
+void FieldModelFile::computePose(const FieldModelAnimation &animation,
+                                 int frame, QMatrix4x4 *matrices) const
+{
+	const int boneCount = _skeleton.boneCount();
+	const PolyVertex *rotations = animation.rotations(frame);
+	// Matrix given to the children of each bone
+	QVector<QMatrix4x4> childMatrices(boneCount);
+
+	for(int i = 0 ; i < boneCount ; ++i) {
+		const FieldModelBone &bone = _skeleton.bone(i);
+		QMatrix4x4 &matrix = matrices[i];
+
+		if(bone.parent() >= 0 && bone.parent() < i) {
+			matrix = childMatrices.at(bone.parent());
+		} else {
+			matrix.setToIdentity();
+		}
+
+		if(!translateAfter()) {
+			matrix.translate(0.0f, 0.0f, bone.size());
+		}
+
+		if(i < animation.boneCount()) {
+			const PolyVertex &rotation = rotations[i];
+			matrix.rotate(rotation.y, 0.0f, 1.0f, 0.0f);
+			matrix.rotate(rotation.x, 1.0f, 0.0f, 0.0f);
+			matrix.rotate(rotation.z, 0.0f, 0.0f, 1.0f);
+		}
+
+		QMatrix4x4 &childMatrix = childMatrices[i];
+		childMatrix = matrix;
+
+		if(translateAfter()) {
+			childMatrix.translate(0.0f, 0.0f, bone.size());
+		}
+	}
+}
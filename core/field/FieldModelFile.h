@@ -19,9 +19,11 @@
 #define FIELDMODELFILE_H
 
 #include <QtGui>
+#include <QMatrix4x4>
 #include "FieldModelSkeleton.h"
 #include "FieldModelPart.h"
 #include "FieldModelAnimation.h"
+#include "FieldModelMesh.h"
 
 class FieldModelFile
 {
@@ -38,6 +40,8 @@ public:
 	}
 	inline void setSkeleton(const FieldModelSkeleton &skeleton) {
 		_skeleton = skeleton;
+		_mesh.clear();
+		_poses.clear();
 	}
 	inline const FieldModelBone &bone(int boneID) const {
 		return _skeleton.bone(boneID);
@@ -50,6 +54,7 @@ public:
 	}
 	inline void setAnimations(const QList<FieldModelAnimation> &animations) {
 		_animations = animations;
+		_poses.clear();
 	}
 	inline int animationCount() const {
 		return _animations.size();
@@ -58,8 +63,18 @@ public:
 		return _animations.at(animationID);
 	}
 	virtual QImage loadedTexture(FieldModelGroup *group)=0;
+	const FieldModelMesh &mesh();
+	const QMatrix4x4 *boneMatrices(int animationID, int frame);
 private:
 	Q_DISABLE_COPY(FieldModelFile)
+	struct PoseCache {
+		QVector<QMatrix4x4> matrices; // frameCount * boneCount
+		QBitArray computedFrames;
+	};
+	void computePose(const FieldModelAnimation &animation, int frame,
+	                 QMatrix4x4 *matrices) const;
+	FieldModelMesh _mesh;
+	QVector<PoseCache> _poses;
 protected:
 	FieldModelSkeleton _skeleton;
 	QList<FieldModelAnimation> _animations;
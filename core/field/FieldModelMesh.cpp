@@ -0,0 +1,163 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "FieldModelMesh.h"
+#include "FieldModelFile.h"
+
+static QAtomicInt lastSerial(0);
+
+FieldModelMesh::FieldModelMesh() :
+	_serial(0)
+{
+}
+
+void FieldModelMesh::clear()
+{
+	_vertices.clear();
+	_indices.clear();
+	_groups.clear();
+	_bones.clear();
+	_textures.clear();
+	_textureIndexes.clear();
+	_serial = 0;
+}
+
+int FieldModelMesh::textureIndex(const QImage &texture)
+{
+	if(texture.isNull()) {
+		return -1;
+	}
+
+	// Images shared by several groups have the same cache key
+	QHash<qint64, int>::const_iterator it = _textureIndexes.constFind(texture.cacheKey());
+	if(it != _textureIndexes.constEnd()) {
+		return it.value();
+	}
+
+	int index = _textures.size();
+	_textures.append(texture);
+	_textureIndexes.insert(texture.cacheKey(), index);
+
+	return index;
+}
+
+/*!
+ * Converts the polygons of \a data into indexed triangles,
+ * grouped by bone then by texture.
+ * Quads are split in two triangles.
+ * Returns false if the model is empty.
+ */
+bool FieldModelMesh::bake(FieldModelFile *data)
+{
+	clear();
+
+	if(!data || data->boneCount() == 0) {
+		// Baked anyway, to not retry on every frame
+		_serial = lastSerial.fetchAndAddOrdered(1) + 1;
+		return false;
+	}
+
+	// Count first to allocate once
+	int vertexCount = 0, indexCount = 0, groupCount = 0;
+
+	foreach(const FieldModelBone &bone, data->skeleton().bones()) {
+		foreach(FieldModelPart *part, bone.parts()) {
+			groupCount += part->groups().size();
+			foreach(FieldModelGroup *g, part->groups()) {
+				vertexCount += g->vertexCount();
+				for(int polyID=0 ; polyID<g->polygonCount() ; ++polyID) {
+					indexCount += g->polygon(polyID).count() == 4 ? 6 : 3;
+				}
+			}
+		}
+	}
+
+	_vertices.reserve(vertexCount);
+	_indices.reserve(indexCount);
+	_groups.reserve(groupCount);
+	_bones.reserve(data->boneCount());
+
+	foreach(const FieldModelBone &bone, data->skeleton().bones()) {
+		FieldModelMeshBone meshBone;
+		meshBone.firstGroup = _groups.size();
+
+		foreach(FieldModelPart *part, bone.parts()) {
+			foreach(FieldModelGroup *g, part->groups()) {
+				FieldModelMeshGroup meshGroup;
+				// Must be called before reading tex coords,
+				// because it can normalize them
+				meshGroup.texture = g->hasTexture()
+				        ? textureIndex(data->loadedTexture(g))
+				        : -1;
+				meshGroup.firstIndex = _indices.size();
+
+				for(int polyID=0 ; polyID<g->polygonCount() ; ++polyID) {
+					const Poly p = g->polygon(polyID);
+					const quint32 first = _vertices.size();
+					const bool hasTexCoords = meshGroup.texture >= 0
+					        && p.hasTexture();
+
+					for(quint8 j=0 ; j<(quint8)p.count() ; ++j) {
+						const PolyVertex &vertex = p.vertex(j);
+						const QRgb color = p.color(j);
+						FieldModelMeshVertex v;
+
+						v.x = vertex.x;
+						v.y = vertex.y;
+						v.z = vertex.z;
+						if(hasTexCoords) {
+							const TexCoord &coord = p.texCoord(j);
+							v.u = coord.x;
+							v.v = coord.y;
+						} else {
+							v.u = v.v = 0.0f;
+						}
+						v.r = qRed(color);
+						v.g = qGreen(color);
+						v.b = qBlue(color);
+						v.a = 0xFF;
+
+						_vertices.append(v);
+					}
+
+					// Quad vertices are in GL_QUADS order
+					_indices.append(first);
+					_indices.append(first + 1);
+					_indices.append(first + 2);
+					if(p.count() == 4) {
+						_indices.append(first);
+						_indices.append(first + 2);
+						_indices.append(first + 3);
+					}
+				}
+
+				meshGroup.indexCount = _indices.size() - meshGroup.firstIndex;
+
+				if(meshGroup.indexCount > 0) {
+					_groups.append(meshGroup);
+				}
+			}
+		}
+
+		meshBone.groupCount = _groups.size() - meshBone.firstGroup;
+		_bones.append(meshBone);
+	}
+
+	_serial = lastSerial.fetchAndAddOrdered(1) + 1;
+
+	return true;
+}
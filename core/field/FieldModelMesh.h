@@ -0,0 +1,96 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef FIELDMODELMESH_H
+#define FIELDMODELMESH_H
+
+#include <QtGui>
+
+class FieldModelFile;
+
+/*
+ * Interleaved vertex, ready to be sent to the GPU.
+ * Stride: 24 bytes (position: 0, texCoord: 12, color: 20).
+ */
+struct FieldModelMeshVertex {
+	float x, y, z;
+	float u, v;
+	quint8 r, g, b, a;
+};
+
+/*
+ * A range of indices sharing the same texture.
+ * texture is an index in FieldModelMesh::textures(), or -1.
+ */
+struct FieldModelMeshGroup {
+	int texture;
+	quint32 firstIndex;
+	quint32 indexCount;
+};
+
+/*
+ * A range of groups drawn with the same bone matrix.
+ */
+struct FieldModelMeshBone {
+	int firstGroup;
+	int groupCount;
+};
+
+class FieldModelMesh
+{
+public:
+	FieldModelMesh();
+	bool bake(FieldModelFile *data);
+	void clear();
+	inline bool isEmpty() const {
+		return _indices.isEmpty();
+	}
+	inline const QVector<FieldModelMeshVertex> &vertices() const {
+		return _vertices;
+	}
+	inline const QVector<quint32> &indices() const {
+		return _indices;
+	}
+	inline const QVector<FieldModelMeshGroup> &groups() const {
+		return _groups;
+	}
+	inline int boneCount() const {
+		return _bones.size();
+	}
+	inline const FieldModelMeshBone &bone(int boneID) const {
+		return _bones.at(boneID);
+	}
+	inline const QList<QImage> &textures() const {
+		return _textures;
+	}
+	// Unique identifier of the last bake, never reused
+	inline quint32 serial() const {
+		return _serial;
+	}
+private:
+	int textureIndex(const QImage &texture);
+
+	QVector<FieldModelMeshVertex> _vertices;
+	QVector<quint32> _indices;
+	QVector<FieldModelMeshGroup> _groups;
+	QVector<FieldModelMeshBone> _bones;
+	QList<QImage> _textures;
+	QHash<qint64, int> _textureIndexes;
+	quint32 _serial;
+};
+
+#endif // FIELDMODELMESH_H
@@ -17,145 +17,110 @@
  ****************************************************************************/
 #include "FieldModelPart.h"
 
-Poly::Poly(int count, const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords) :
-	_count(count)
-{
-	setVertices(vertices, colors, texCoords);
-}
-
-Poly::Poly(int count, const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords) :
-	_count(count)
-{
-	setVertices(vertices, color, texCoords);
-}
-
-Poly::~Poly()
-{
-}
-
-void Poly::setVertices(const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords)
-{
-	_vertices = vertices;
-	_colors = colors;
-	_texCoords = texCoords;
-}
-
-void Poly::setVertices(const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords)
-{
-	_vertices = vertices;
-	_colors.clear();
-	_colors.append(color);
-	_texCoords = texCoords;
-}
-
-const PolyVertex &Poly::vertex(quint8 id) const
-{
-	return _vertices.at(id);
-}
-
-const QRgb &Poly::color() const
-{
-	return _colors.first();
-}
-
-QRgb Poly::color(quint8 id) const
-{
-	return _colors.value(id, _colors.first());
-}
-
-const TexCoord &Poly::texCoord(quint8 id) const
+FieldModelGroup::FieldModelGroup() :
+	_textureRef(0), _blendMode(0)
 {
-	return _texCoords.at(id);
 }
 
-void Poly::setTexCoord(quint8 id, const TexCoord &texCoord)
+FieldModelGroup::FieldModelGroup(FieldModelTextureRef *texRef) :
+	_textureRef(texRef), _blendMode(0)
 {
-	_texCoords.replace(id, texCoord);
 }
 
-bool Poly::isMonochrome() const
+FieldModelGroup::~FieldModelGroup()
 {
-	return _colors.size() == 1;
+	if (_textureRef) {
+		delete _textureRef;
+	}
 }
 
-bool Poly::hasTexture() const
+void FieldModelGroup::setTextureRef(FieldModelTextureRef *texRef)
 {
-	return !_texCoords.isEmpty();
+	if (_textureRef) {
+		delete _textureRef;
+	}
+	_textureRef = texRef;
 }
 
-QuadPoly::QuadPoly(const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords) :
-	Poly(4, vertices, colors, texCoords)
+void FieldModelGroup::reserve(int polygonCount, int vertexCount)
 {
-	// swapping the two last vertices for right OpenGL quad order
-
-	_vertices.swap(2, 3);
-
-	if(colors.size() == 4) {
-		_colors.swap(2, 3);
-	}
-
-	if(!texCoords.isEmpty()) {
-		_texCoords.swap(2, 3);
-	}
+	_polys.reserve(polygonCount);
+	_vertices.reserve(vertexCount);
+	_colors.reserve(vertexCount);
+	_texCoords.reserve(vertexCount);
 }
 
-QuadPoly::QuadPoly(const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords) :
-	Poly(4, vertices, color, texCoords)
+/*!
+ * Adds a polygon of \a count vertices.
+ * If \a colors is NULL, the polygon is monochrome and uses \a color.
+ * If \a texCoords is NULL, the polygon is not textured.
+ * Quads are stored with the two last vertices swapped,
+ * for the right OpenGL quad order.
+ */
+void FieldModelGroup::addPolygon(quint8 count, const PolyVertex *vertices,
+                                 const QRgb *colors, QRgb color,
+                                 const TexCoord *texCoords, bool isQuad)
 {
-	// swapping the two last vertices for right OpenGL quad order
+	PolyInfo info;
+	info.firstVertex = _vertices.size();
+	info.count = count;
+	info.flags = (colors ? 0 : Monochrome) | (texCoords ? Textured : 0);
+	_polys.append(info);
 
-	_vertices.swap(2, 3);
+	for (quint8 i = 0; i < count; ++i) {
+		quint8 j = i;
+		if (isQuad && i >= 2) {
+			j = 5 - i; // 2 <=> 3
+		}
 
-	if(!texCoords.isEmpty()) {
-		_texCoords.swap(2, 3);
+		_vertices.append(vertices[j]);
+		_colors.append(colors ? colors[j] : color);
+		if (texCoords) {
+			_texCoords.append(texCoords[j]);
+		} else {
+			TexCoord texCoord;
+			texCoord.x = texCoord.y = 0.0f;
+			_texCoords.append(texCoord);
+		}
 	}
 }
 
-TrianglePoly::TrianglePoly(const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords) :
-	Poly(3, vertices, colors, texCoords)
+void FieldModelGroup::addTriangle(const PolyVertex *vertices,
+                                  const QRgb *colors,
+                                  const TexCoord *texCoords)
 {
+	addPolygon(3, vertices, colors, 0, texCoords, false);
 }
 
-TrianglePoly::TrianglePoly(const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords) :
-	Poly(3, vertices, color, texCoords)
+void FieldModelGroup::addTriangle(const PolyVertex *vertices, QRgb color,
+                                  const TexCoord *texCoords)
 {
+	addPolygon(3, vertices, 0, color, texCoords, false);
 }
 
-FieldModelGroup::FieldModelGroup() :
-	_textureRef(0), _blendMode(0)
+void FieldModelGroup::addQuad(const PolyVertex *vertices, const QRgb *colors,
+                              const TexCoord *texCoords)
 {
+	addPolygon(4, vertices, colors, 0, texCoords, true);
 }
 
-FieldModelGroup::FieldModelGroup(FieldModelTextureRef *texRef) :
-	_textureRef(texRef), _blendMode(0)
+void FieldModelGroup::addQuad(const PolyVertex *vertices, QRgb color,
+                              const TexCoord *texCoords)
 {
+	addPolygon(4, vertices, 0, color, texCoords, true);
 }
 
-FieldModelGroup::~FieldModelGroup()
-{
-	qDeleteAll(_polys);
-	if (_textureRef) {
-		delete _textureRef;
-	}
-}
-
-void FieldModelGroup::setTextureRef(FieldModelTextureRef *texRef)
-{
-	if (_textureRef) {
-		delete _textureRef;
-	}
-	_textureRef = texRef;
-}
-
-void FieldModelGroup::removeSpriting(float texWidth, float texHeight) const
+void FieldModelGroup::removeSpriting(float texWidth, float texHeight)
 {
 	float minX = -1,
 			minY = -1;
 
-	foreach (Poly *poly, polygons()) {
-		if (poly->hasTexture() && poly->count() > 0) {
-			for (quint16 i = 0 ; i < (quint8)poly->count(); ++i) {
-				const TexCoord &texCoord = poly->texCoord(i);
+	for (int polyID = 0; polyID < _polys.size(); ++polyID) {
+		const PolyInfo &info = _polys.at(polyID);
+
+		if (info.flags & Textured) {
+			for (quint32 i = info.firstVertex; i < info.firstVertex + info.count; ++i) {
+				const TexCoord &texCoord = _texCoords.at(i);
 				if (minX < 0) {
 					minX = texCoord.x;
 				}
@@ -182,10 +147,10 @@ void FieldModelGroup::removeSpriting(float texWidth, float texHeight) const
 		minY = 0;
 	}
 
-	foreach (Poly *poly, polygons()) {
-		if (poly->hasTexture()) {
-			for (quint16 i = 0; i < (quint8)poly->count(); ++i) {
-				TexCoord texCoord = poly->texCoord(i);
+	foreach (const PolyInfo &info, _polys) {
+		if (info.flags & Textured) {
+			for (quint32 i = info.firstVertex; i < info.firstVertex + info.count; ++i) {
+				TexCoord &texCoord = _texCoords[i];
 
 				texCoord.x -= minX;
 				texCoord.y -= minY;
@@ -195,19 +160,17 @@ void FieldModelGroup::removeSpriting(float texWidth, float texHeight) const
 				if (texHeight != 0) {
 					texCoord.y /= texHeight;
 				}
-
-				poly->setTexCoord(i, texCoord);
 			}
 		}
 	}
 }
 
-void FieldModelGroup::setFloatCoords(float texWidth, float texHeight) const
+void FieldModelGroup::setFloatCoords(float texWidth, float texHeight)
 {
-	foreach (Poly *poly, polygons()) {
-		if (poly->hasTexture()) {
-			for (quint16 i = 0; i < (quint8)poly->count(); ++i) {
-				TexCoord texCoord = poly->texCoord(i);
+	foreach (const PolyInfo &info, _polys) {
+		if (info.flags & Textured) {
+			for (quint32 i = info.firstVertex; i < info.firstVertex + info.count; ++i) {
+				TexCoord &texCoord = _texCoords[i];
 
 				if (texWidth != 0) {
 					texCoord.x /= texWidth;
@@ -215,8 +178,6 @@ void FieldModelGroup::setFloatCoords(float texWidth, float texHeight) const
 				if (texHeight != 0) {
 					texCoord.y /= texHeight;
 				}
-
-				poly->setTexCoord(i, texCoord);
 			}
 		}
 	}
@@ -241,28 +202,26 @@ QString FieldModelPart::toString() const
 		           .arg(groupID)
 		           .arg(group->textureRef()->textureIdentifier()));
 
-		int ID = 0;
-		foreach(Poly *poly, group->polygons()) {
+		for(int ID=0 ; ID<group->polygonCount() ; ++ID) {
+			const Poly poly = group->polygon(ID);
 			ret.append(QString("==== poly %1 ====\n").arg(ID));
 
-			for(int i=0 ; i<poly->count() ; ++i) {
+			for(int i=0 ; i<poly.count() ; ++i) {
 				ret.append(QString("%1: vertex(%2, %3, %4) color(%5, %6, %7)")
 						   .arg(i)
-						   .arg(poly->vertex(i).x)
-				           .arg(poly->vertex(i).y)
-				           .arg(poly->vertex(i).z)
-						   .arg(qRed(poly->color(i)))
-				           .arg(qGreen(poly->color(i)))
-				           .arg(qBlue(poly->color(i))));
-				if(poly->hasTexture()) {
+						   .arg(poly.vertex(i).x)
+				           .arg(poly.vertex(i).y)
+				           .arg(poly.vertex(i).z)
+						   .arg(qRed(poly.color(i)))
+				           .arg(qGreen(poly.color(i)))
+				           .arg(qBlue(poly.color(i))));
+				if(poly.hasTexture()) {
 					ret.append(QString(" texCoord(%1, %2)")
-							   .arg(poly->texCoord(i).x)
-					           .arg(poly->texCoord(i).y));
+							   .arg(poly.texCoord(i).x)
+					           .arg(poly.texCoord(i).y));
 				}
 				ret.append("\n");
 			}
-
-			++ID;
 		}
 
 		++groupID;
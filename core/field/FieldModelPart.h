@@ -30,59 +30,60 @@ struct TexCoord {
 	float x, y;
 };
 
+class FieldModelGroup;
+
+/*
+ * Lightweight view over a polygon stored in a FieldModelGroup,
+ * it is invalidated when the group is modified.
+ */
 class Poly
 {
 public:
-	Poly(int count, const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords=QList<TexCoord>());
-	Poly(int count, const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords=QList<TexCoord>());
-	virtual ~Poly();
-	void setVertices(const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords=QList<TexCoord>());
-	void setVertices(const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords=QList<TexCoord>());
-	inline int count() const {
-		return _count;
-	}
+	Poly(const FieldModelGroup *group, int index);
+	int count() const;
 	const PolyVertex &vertex(quint8 id) const;
 	const QRgb &color() const;
 	QRgb color(quint8 id) const;
 	const TexCoord &texCoord(quint8 id) const;
-	void setTexCoord(quint8 id, const TexCoord &texCoord);
 	bool isMonochrome() const;
 	bool hasTexture() const;
-protected:
-	int _count;
-	QList<PolyVertex> _vertices;
-	QList<QRgb> _colors;
-	QList<TexCoord> _texCoords;
-};
-
-class QuadPoly : public Poly
-{
-public:
-	QuadPoly(const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords=QList<TexCoord>());
-	QuadPoly(const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords=QList<TexCoord>());
-};
-
-class TrianglePoly : public Poly
-{
-public:
-	TrianglePoly(const QList<PolyVertex> &vertices, const QList<QRgb> &colors, const QList<TexCoord> &texCoords=QList<TexCoord>());
-	TrianglePoly(const QList<PolyVertex> &vertices, const QRgb &color, const QList<TexCoord> &texCoords=QList<TexCoord>());
+private:
+	const FieldModelGroup *_group;
+	int _index;
 };
 
 class FieldModelFile;
 
+/*
+ * Polygons are packed in parallel arrays: one entry per vertex
+ * in _vertices, _colors and _texCoords, and one entry per polygon
+ * in _polys pointing to its first vertex.
+ */
 class FieldModelGroup
 {
+	friend class Poly;
 public:
 	FieldModelGroup();
 	explicit FieldModelGroup(FieldModelTextureRef *texRef);
 	virtual ~FieldModelGroup();
-	inline const QList<Poly *> &polygons() const {
-		return _polys;
+	inline int polygonCount() const {
+		return _polys.size();
 	}
-	inline void addPolygon(Poly *polygon) {
-		_polys.append(polygon);
+	inline Poly polygon(int index) const {
+		return Poly(this, index);
 	}
+	inline int vertexCount() const {
+		return _vertices.size();
+	}
+	void reserve(int polygonCount, int vertexCount);
+	void addTriangle(const PolyVertex *vertices, const QRgb *colors,
+	                 const TexCoord *texCoords = 0);
+	void addTriangle(const PolyVertex *vertices, QRgb color,
+	                 const TexCoord *texCoords = 0);
+	void addQuad(const PolyVertex *vertices, const QRgb *colors,
+	             const TexCoord *texCoords = 0);
+	void addQuad(const PolyVertex *vertices, QRgb color,
+	             const TexCoord *texCoords = 0);
 	inline bool hasTexture() const {
 		return _textureRef;
 	}
@@ -93,14 +94,71 @@ public:
 	inline void setBlendMode(quint8 blend) {
 		_blendMode = blend;
 	}
-	void removeSpriting(float texWidth, float texHeight) const;
-	void setFloatCoords(float texWidth, float texHeight) const;
+	void removeSpriting(float texWidth, float texHeight);
+	void setFloatCoords(float texWidth, float texHeight);
 private:
+	Q_DISABLE_COPY(FieldModelGroup)
+	enum PolyFlag {
+		Monochrome = 0x01,
+		Textured = 0x02
+	};
+	struct PolyInfo {
+		quint32 firstVertex;
+		quint8 count;
+		quint8 flags;
+	};
+	void addPolygon(quint8 count, const PolyVertex *vertices,
+	                const QRgb *colors, QRgb color,
+	                const TexCoord *texCoords, bool isQuad);
+
 	FieldModelTextureRef *_textureRef;
-	QList<Poly *> _polys;
+	QVector<PolyVertex> _vertices;
+	QVector<QRgb> _colors;
+	QVector<TexCoord> _texCoords;
+	QVector<PolyInfo> _polys;
 	quint8 _blendMode;
 };
 
+inline Poly::Poly(const FieldModelGroup *group, int index) :
+	_group(group), _index(index)
+{
+}
+
+inline int Poly::count() const
+{
+	return _group->_polys.at(_index).count;
+}
+
+inline const PolyVertex &Poly::vertex(quint8 id) const
+{
+	return _group->_vertices.at(_group->_polys.at(_index).firstVertex + id);
+}
+
+inline const QRgb &Poly::color() const
+{
+	return _group->_colors.at(_group->_polys.at(_index).firstVertex);
+}
+
+inline QRgb Poly::color(quint8 id) const
+{
+	return _group->_colors.at(_group->_polys.at(_index).firstVertex + id);
+}
+
+inline const TexCoord &Poly::texCoord(quint8 id) const
+{
+	return _group->_texCoords.at(_group->_polys.at(_index).firstVertex + id);
+}
+
+inline bool Poly::isMonochrome() const
+{
+	return _group->_polys.at(_index).flags & FieldModelGroup::Monochrome;
+}
+
+inline bool Poly::hasTexture() const
+{
+	return _group->_polys.at(_index).flags & FieldModelGroup::Textured;
+}
+
 class FieldModelPart
 {
 public:
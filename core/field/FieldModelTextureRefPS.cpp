@@ -96,36 +96,31 @@ QImage FieldModelTexturesPS::toImage(int imgId, int palId, Bpp bpp) const
 	QImage image(width, imgRect.height(), QImage::Format_ARGB32);
 	QRgb *px = (QRgb *)image.bits();
 	int i = 0;
+	QVector<QRgb> palette(palData.size() / 2);
+	PsColor::fromPsColors(palConstData, palette.size(), palette.data(), true);
 
 	for (int y = 0; y < imgRect.height(); ++y) {
 		for (int x = 0; x < imgRect.width() * 2; ++x) {
 			quint8 index = imgConstData[i];
-			quint16 color;
 
 			if (bpp == Bpp8) {
-				if (index * 2 + 2 > palData.size()) {
+				if (index >= palette.size()) {
 					qWarning() << "FieldModelTexturePS::openTexture Offset palette too large";
 					continue;
 				}
-				memcpy(&color, palConstData + index * 2, 2);
-
-				px[i] = PsColor::fromPsColor(color, true);
+				px[i] = palette.at(index);
 			} else/* if (bpp == Bpp4)*/ {
-				if ((index & 0xF) * 2 + 2 > palData.size()) {
+				if ((index & 0xF) >= palette.size()) {
 					qWarning() << "FieldModelTexturePS::openTexture Offset palette too large";
 					continue;
 				}
-				memcpy(&color, palConstData + (index & 0xF) * 2, 2);
-
-				px[i * 2] = PsColor::fromPsColor(color, true);
+				px[i * 2] = palette.at(index & 0xF);
 
-				if ((index >> 4) * 2 + 2 > palData.size()) {
+				if ((index >> 4) >= palette.size()) {
 					qWarning() << "FieldModelTexturePS::openTexture Offset palette too large";
 					continue;
 				}
-				memcpy(&color, palConstData + (index >> 4) * 2, 2);
-
-				px[i * 2 + 1] = PsColor::fromPsColor(color, true);
+				px[i * 2 + 1] = palette.at(index >> 4);
 			}
 			++i;
 		}
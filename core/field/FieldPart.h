@@ -38,7 +38,7 @@ public:
 	bool isOpen() const;
 	void setOpen(bool open);
 	virtual bool isModified() const;
-	void setModified(bool modified);
+	virtual void setModified(bool modified);
 protected:
 	Field *field() const;
 private:
@@ -80,30 +80,35 @@ Opcode *ScriptsIterator::previousOpcode()
 }
 
 GrpScript::GrpScript() :
-	_character(-1), animation(false), location(false), director(false)
+	_byteSize(0), _dirty(true), _character(-1), animation(false), location(false), director(false)
 {
 	addScript(QByteArray(2, char(Opcode::RET)));
 	for(int i=1 ; i<32 ; i++)	addScript();
 }
 
 GrpScript::GrpScript(const QString &name) :
-	_name(name), _character(-1), animation(false), location(false), director(false)
+	_name(name), _byteSize(0), _dirty(true), _character(-1), animation(false), location(false), director(false)
 {
 	for(int i=0 ; i<32 ; i++)	addScript();
 }
 
 GrpScript::GrpScript(const QString &name, QList<Script *> scripts) :
-    _name(name), _scripts(scripts),
+    _name(name), _scripts(scripts), _byteSize(0), _dirty(true),
     _character(-1), animation(false), location(false), director(false)
 {
+	foreach(Script *script, _scripts) {
+		script->setGroup(this);
+	}
 	for(int i=_scripts.size() ; i<32 ; i++)	addScript();
 }
 
 GrpScript::GrpScript(const GrpScript &other) :
-	_name(other.realName()), _character(-1), animation(false), location(false), director(false)
+	_name(other.realName()), _byteSize(0), _dirty(true), _character(-1), animation(false), location(false), director(false)
 {
 	foreach(Script *script, other.scripts()) {
-		_scripts.append(new Script(*script));
+		Script *s = new Script(*script);
+		s->setGroup(this);
+		_scripts.append(s);
 	}
 }
 
@@ -128,8 +133,15 @@ GrpScript *GrpScript::createGroupModel(quint8 modelID, int charID)
 
 void GrpScript::addScript()
 {
-	if(_scripts.isEmpty())	_scripts.append(new Script());
-	_scripts.append(new Script());
+	if(_scripts.isEmpty())	addScript(new Script());
+	addScript(new Script());
+}
+
+void GrpScript::addScript(Script *script)
+{
+	script->setGroup(this);
+	_scripts.append(script);
+	_dirty = true;
 }
 
 bool GrpScript::addScript(const QByteArray &script, bool explodeInit)
@@ -143,8 +155,9 @@ bool GrpScript::addScript(const QByteArray &script, bool explodeInit)
 			delete s;
 			return false;
 		}
-		_scripts.append(s); // S0 - Init
-		_scripts.append(s->splitScriptAtReturn()); // S0 - Main
+		Script *mainScript = s->splitScriptAtReturn();
+		addScript(s); // S0 - Init
+		addScript(mainScript); // S0 - Main
 	}
 	else {
 		s = new Script(script);
@@ -152,7 +165,7 @@ bool GrpScript::addScript(const QByteArray &script, bool explodeInit)
 			delete s;
 			return false;
 		}
-		_scripts.append(s);
+		addScript(s);
 	}
 
 	return true;
@@ -169,6 +182,13 @@ bool GrpScript::setScript(int row, const QByteArray &script, int pos, int size)
 	return true;
 }
 
+void GrpScript::setScript(int row, Script *script)
+{
+	script->setGroup(this);
+	_scripts.replace(row, script);
+	_dirty = true;
+}
+
 void GrpScript::setType()
 {
 	if(_scripts.isEmpty())	return;
@@ -236,6 +256,53 @@ QByteArray GrpScript::toByteArray(quint8 scriptID) const
 	return QByteArray();
 }
 
+void GrpScript::toByteArray(quint8 scriptID, QByteArray &out) const
+{
+	if(scriptID == 0)
+	{
+		if(!_scripts.isEmpty() && !_scripts.first()->isEmpty()) {
+			_scripts.first()->toByteArray(out);
+			_scripts.at(1)->toByteArray(out);
+		}
+	}
+	else if(scriptID+1 < _scripts.size())
+		_scripts.at(scriptID+1)->toByteArray(out);
+}
+
+quint32 GrpScript::byteSize(quint8 scriptID) const
+{
+	if(scriptID == 0)
+	{
+		if(!_scripts.isEmpty() && !_scripts.first()->isEmpty())
+			return _scripts.first()->byteSize() + _scripts.at(1)->byteSize();
+		return 0;
+	}
+	if(scriptID+1 < _scripts.size())
+		return _scripts.at(scriptID+1)->byteSize();
+	return 0;
+}
+
+/*!
+ * Size of the 32 serialized scripts, computed again only
+ * after a script of the group was modified.
+ */
+quint32 GrpScript::byteSize() const
+{
+	if(_dirty) {
+		_byteSize = 0;
+		for(quint8 j=0 ; j<32 ; ++j) {
+			_byteSize += byteSize(j);
+		}
+		_dirty = false;
+	}
+	return _byteSize;
+}
+
+void GrpScript::setDirty()
+{
+	_dirty = true;
+}
+
 GrpScript::Type GrpScript::typeID()
 {
 	setType();
@@ -513,6 +580,30 @@ bool GrpScript::compile(int &scriptID, int &opcodeID, QString &errorStr)
 	return true;
 }
 
+bool GrpScript::compile(QList<ScriptCompileError> &errors, quint32 *byteSize)
+{
+	const int errorCount = errors.size();
+	quint32 size = 0;
+	int scriptID=0;
+
+	foreach(Script *script, _scripts) {
+		int firstError = errors.size();
+		quint32 scriptSize;
+		script->compile(errors, &scriptSize);
+		for(int i=firstError ; i<errors.size() ; ++i) {
+			errors[i].scriptID = scriptID;
+		}
+		size += scriptSize;
+		++scriptID;
+	}
+
+	if(byteSize) {
+		*byteSize = size;
+	}
+
+	return errors.size() == errorCount;
+}
+
 bool GrpScript::removeTexts()
 {
 	bool modified = false;
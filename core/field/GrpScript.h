@@ -61,9 +61,7 @@ public:
 		return setScript(row, script, 0, script.size());
 	}
 	bool setScript(int row, const QByteArray &script, int pos, int size);
-	inline void setScript(int row, Script *script) {
-		_scripts.replace(row, script);
-	}
+	void setScript(int row, Script *script);
 
 	QString name() const;
 	inline const QString &realName() const {
@@ -82,6 +80,10 @@ public:
 		return _scripts;
 	}
 	QByteArray toByteArray(quint8 scriptID) const;
+	void toByteArray(quint8 scriptID, QByteArray &out) const;
+	quint32 byteSize(quint8 scriptID) const;
+	quint32 byteSize() const;
+	void setDirty();
 	void backgroundParams(QHash<quint8, quint8> &paramActifs) const;
 	void backgroundMove(qint16 z[2], qint16 *x=0, qint16 *y=0) const;
 	Type typeID();
@@ -115,17 +117,21 @@ public:
 	void listModelPositions(QList<FF7Position> &positions) const;
 	bool linePosition(FF7Position position[2]) const;
 	bool compile(int &scriptID, int &opcodeID, QString &errorStr);
+	bool compile(QList<ScriptCompileError> &errors, quint32 *byteSize=0);
 	bool removeTexts();
 
 	QString toString(Field *field) const;
 private:
 	void addScript();
+	void addScript(Script *script);
 	bool addScript(const QByteArray &script, bool explodeInit = true);
 	void setType();
 	bool search(int &scriptID, int &opcodeID) const;
 
 	QString _name;
 	QList<Script *> _scripts;
+	mutable quint32 _byteSize; // Size of all scripts, valid when not dirty
+	mutable bool _dirty;
 
 	qint16 _character;
 	bool animation;
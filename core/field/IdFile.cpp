@@ -57,8 +57,9 @@ bool IdFile::open(const QByteArray &data)
 
 	Triangle triangle;
 	Access acc;
-	_triangles.clear();
-	_access.clear();
+	clear();
+	_triangles.reserve(nbSector);
+	_access.reserve(nbSector);
 	for(i=0 ; i<nbSector ; ++i) {
 		memcpy(&triangle, constData + 4 + i*24, 24);
 		_triangles.append(triangle);
@@ -96,6 +97,7 @@ void IdFile::clear()
 {
 	_triangles.clear();
 	_access.clear();
+	_grid.clear();
 }
 
 bool IdFile::hasTriangle() const
@@ -118,23 +120,91 @@ const Triangle &IdFile::triangle(int triangleID) const
 	return _triangles.at(triangleID);
 }
 
+/*!
+ * Replaces the vertices of triangleID. An access on an edge no longer shared
+ * is removed on both sides, and a free edge is connected to the triangle
+ * sharing it, if any, so the access stays symmetric.
+ */
 void IdFile::setTriangle(int triangleID, const Triangle &triangle)
 {
+	unlinkNeighbors(triangleID);
 	_triangles[triangleID] = triangle;
+
+	for(int edge=0 ; edge<3 ; ++edge) {
+		const Vertex_sr &v1 = triangle.vertices[edge],
+		        &v2 = triangle.vertices[(edge + 1) % 3];
+		qint16 &neighborID = _access[triangleID].a[edge];
+		if(neighborID >= 0 && neighborID < _triangles.size()
+		        && sharedEdge(neighborID, v1, v2) < 0) {
+			neighborID = -1;
+		}
+		if(neighborID >= 0) {
+			continue;
+		}
+		for(int i=0 ; i<_triangles.size() ; ++i) {
+			if(i == triangleID) {
+				continue;
+			}
+			const int neighborEdge = sharedEdge(i, v1, v2);
+			if(neighborEdge >= 0 && _access.at(i).a[neighborEdge] < 0) {
+				neighborID = i;
+				break;
+			}
+		}
+	}
+
+	linkNeighbors(triangleID);
+
+	_grid.clear();
 	setModified(true);
 }
 
+/*!
+ * Inserts triangle at triangleID, access is expressed with the triangle IDs
+ * before insertion. Every access pointing after triangleID is shifted,
+ * and the neighbors sharing an edge get an access back to the new triangle.
+ */
 void IdFile::insertTriangle(int triangleID, const Triangle &triangle, const Access &access)
 {
 	_triangles.insert(triangleID, triangle);
 	_access.insert(triangleID, access);
+
+	for(int i=0 ; i<_access.size() ; ++i) {
+		Access &acc = _access[i];
+		for(int edge=0 ; edge<3 ; ++edge) {
+			if(acc.a[edge] >= triangleID) {
+				acc.a[edge] += 1;
+			}
+		}
+	}
+
+	linkNeighbors(triangleID);
+
+	_grid.clear();
 	setModified(true);
 }
 
+/*!
+ * Removes triangle at triangleID, its neighbors lose their access
+ * to it and every access pointing after triangleID is shifted.
+ */
 void IdFile::removeTriangle(int triangleID)
 {
 	_triangles.removeAt(triangleID);
 	_access.removeAt(triangleID);
+
+	for(int i=0 ; i<_access.size() ; ++i) {
+		Access &acc = _access[i];
+		for(int edge=0 ; edge<3 ; ++edge) {
+			if(acc.a[edge] == triangleID) {
+				acc.a[edge] = -1;
+			} else if(acc.a[edge] > triangleID) {
+				acc.a[edge] -= 1;
+			}
+		}
+	}
+
+	_grid.clear();
 	setModified(true);
 }
 
@@ -143,12 +213,234 @@ const Access &IdFile::access(int triangleID) const
 	return _access.at(triangleID);
 }
 
+/*!
+ * Replaces the access of triangleID, the former neighbors lose their access
+ * to it and the new ones sharing an edge get an access back to it.
+ */
 void IdFile::setAccess(int triangleID, const Access &access)
 {
+	unlinkNeighbors(triangleID);
 	_access[triangleID] = access;
+	linkNeighbors(triangleID);
 	setModified(true);
 }
 
+/*!
+ * Removes the accesses of the neighbors of triangleID pointing back to it.
+ */
+void IdFile::unlinkNeighbors(int triangleID)
+{
+	for(int edge=0 ; edge<3 ; ++edge) {
+		const int neighborID = _access.at(triangleID).a[edge];
+		if(neighborID < 0 || neighborID >= _access.size()
+		        || neighborID == triangleID) {
+			continue;
+		}
+		Access &neighborAccess = _access[neighborID];
+		for(int neighborEdge=0 ; neighborEdge<3 ; ++neighborEdge) {
+			if(neighborAccess.a[neighborEdge] == triangleID) {
+				neighborAccess.a[neighborEdge] = -1;
+			}
+		}
+	}
+}
+
+/*!
+ * The neighbors of triangleID sharing an edge get an access back to it,
+ * the triangle they were previously pointing to on this edge loses
+ * its access to them.
+ */
+void IdFile::linkNeighbors(int triangleID)
+{
+	const Triangle &triangle = _triangles.at(triangleID);
+
+	for(int edge=0 ; edge<3 ; ++edge) {
+		const int neighborID = _access.at(triangleID).a[edge];
+		if(neighborID < 0 || neighborID >= _triangles.size()
+		        || neighborID == triangleID) {
+			continue;
+		}
+		const int neighborEdge = sharedEdge(neighborID, triangle.vertices[edge],
+		                                    triangle.vertices[(edge + 1) % 3]);
+		if(neighborEdge < 0) {
+			continue;
+		}
+		const int previousID = _access.at(neighborID).a[neighborEdge];
+		if(previousID >= 0 && previousID < _access.size()
+		        && previousID != triangleID) {
+			Access &previousAccess = _access[previousID];
+			for(int previousEdge=0 ; previousEdge<3 ; ++previousEdge) {
+				if(previousAccess.a[previousEdge] == neighborID) {
+					previousAccess.a[previousEdge] = -1;
+				}
+			}
+		}
+		_access[neighborID].a[neighborEdge] = triangleID;
+	}
+}
+
+const WalkmeshGrid &IdFile::grid() const
+{
+	// Built lazily, edits invalidate it
+	if(_grid.isEmpty() && !_triangles.isEmpty()) {
+		_grid.build(_triangles);
+	}
+	return _grid;
+}
+
+/*!
+ * Returns the first triangle containing the point (x, y), or -1.
+ */
+int IdFile::findTriangle(int x, int y) const
+{
+	return grid().findTriangle(_triangles, x, y);
+}
+
+/*!
+ * Returns the nearest triangle hit by the ray, or -1.
+ * distance is expressed in direction length unit.
+ */
+int IdFile::pickTriangle(const QVector3D &origin, const QVector3D &direction,
+                         float *distance) const
+{
+	return grid().pickTriangle(_triangles, origin, direction, distance);
+}
+
+static inline bool sameVertex(const Vertex_sr &v1, const Vertex_sr &v2)
+{
+	return v1.x == v2.x && v1.y == v2.y && v1.z == v2.z;
+}
+
+int IdFile::sharedEdge(int triangleID, const Vertex_sr &v1, const Vertex_sr &v2) const
+{
+	const Triangle &triangle = _triangles.at(triangleID);
+
+	for(int edge=0 ; edge<3 ; ++edge) {
+		const Vertex_sr &e1 = triangle.vertices[edge],
+		        &e2 = triangle.vertices[(edge + 1) % 3];
+		if((sameVertex(e1, v1) && sameVertex(e2, v2))
+		        || (sameVertex(e1, v2) && sameVertex(e2, v1))) {
+			return edge;
+		}
+	}
+
+	return -1;
+}
+
+struct WalkmeshEdge {
+	WalkmeshEdge() {}
+	WalkmeshEdge(const Vertex_sr &v1, const Vertex_sr &v2, int triangleID, int edge) :
+	    triangleID(triangleID), edge(edge) {
+		const quint64 k1 = key(v1), k2 = key(v2);
+		lo = qMin(k1, k2);
+		hi = qMax(k1, k2);
+	}
+	static inline quint64 key(const Vertex_sr &v) {
+		return (quint64(quint16(v.x)) << 32) | (quint64(quint16(v.y)) << 16) | quint16(v.z);
+	}
+	inline bool sameEdge(const WalkmeshEdge &other) const {
+		return lo == other.lo && hi == other.hi;
+	}
+	inline bool operator<(const WalkmeshEdge &other) const {
+		if(lo != other.lo) {
+			return lo < other.lo;
+		}
+		if(hi != other.hi) {
+			return hi < other.hi;
+		}
+		return triangleID < other.triangleID;
+	}
+	quint64 lo, hi;
+	int triangleID, edge;
+};
+
+static inline void addError(QList<WalkmeshError> *errors, WalkmeshError::Type type,
+                            int triangleID, int edge)
+{
+	if(errors) {
+		WalkmeshError error;
+		error.type = type;
+		error.triangleID = triangleID;
+		error.edge = edge;
+		errors->append(error);
+	}
+}
+
+/*!
+ * Checks the walkmesh consistency without modifying it.
+ * Returns true if there is no error, errors are appended to errors.
+ */
+bool IdFile::validate(QList<WalkmeshError> *errors) const
+{
+	const int count = _triangles.size();
+	QVector<WalkmeshEdge> edges;
+	bool ok = true;
+
+	edges.reserve(count * 3);
+
+	for(int i=0 ; i<count ; ++i) {
+		const Triangle &triangle = _triangles.at(i);
+		const Access &access = _access.at(i);
+		const Vertex_sr &a = triangle.vertices[0],
+		        &b = triangle.vertices[1],
+		        &c = triangle.vertices[2];
+		const qint64 ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z,
+		        vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+
+		if(uy * vz - uz * vy == 0 && uz * vx - ux * vz == 0 && ux * vy - uy * vx == 0) {
+			addError(errors, WalkmeshError::DegeneratedTriangle, i, -1);
+			ok = false;
+		}
+
+		for(int edge=0 ; edge<3 ; ++edge) {
+			const Vertex_sr &v1 = triangle.vertices[edge],
+			        &v2 = triangle.vertices[(edge + 1) % 3];
+			const int neighbor = access.a[edge];
+
+			edges.append(WalkmeshEdge(v1, v2, i, edge));
+
+			if(neighbor < 0) {
+				continue;
+			}
+
+			if(neighbor >= count) {
+				addError(errors, WalkmeshError::InvalidAccess, i, edge);
+				ok = false;
+				continue;
+			}
+
+			const int backEdge = sharedEdge(neighbor, v1, v2);
+
+			if(backEdge < 0) {
+				addError(errors, WalkmeshError::UnsharedAccess, i, edge);
+				ok = false;
+			} else if(_access.at(neighbor).a[backEdge] != i) {
+				addError(errors, WalkmeshError::AsymmetricAccess, i, edge);
+				ok = false;
+			}
+		}
+	}
+
+	qSort(edges);
+
+	for(int i=0 ; i<edges.size() ; ) {
+		int j = i + 1;
+		while(j < edges.size() && edges.at(j).sameEdge(edges.at(i))) {
+			++j;
+		}
+		if(j - i > 2) {
+			for(int k=i ; k<j ; ++k) {
+				addError(errors, WalkmeshError::NonManifoldEdge,
+				         edges.at(k).triangleID, edges.at(k).edge);
+			}
+			ok = false;
+		}
+		i = j;
+	}
+
+	return ok;
+}
+
 Vertex_sr IdFile::fromVertex_s(const Vertex_s &vertex_s)
 {
 	Vertex_sr vertex_sr;
@@ -21,6 +21,7 @@
 #include <QtCore>
 #include "FieldPart.h"
 #include "CaFile.h"
+#include "WalkmeshGrid.h"
 
 struct Vertex_sr {
 	qint16 x, y, z, res;// res = Triangle[0].z (padding)
@@ -34,6 +35,19 @@ struct Access {
 	qint16 a[3];
 };
 
+// Edge n goes from vertices[n] to vertices[(n + 1) % 3], like Access::a[n]
+struct WalkmeshError {
+	enum Type {
+		DegeneratedTriangle,
+		InvalidAccess, // Points to a missing triangle
+		UnsharedAccess, // The neighbor does not share this edge
+		AsymmetricAccess, // The neighbor does not point back
+		NonManifoldEdge // Shared by more than two triangles
+	};
+	Type type;
+	int triangleID, edge;
+};
+
 class IdFile : public FieldPart
 {
 public:
@@ -51,11 +65,20 @@ public:
 	void removeTriangle(int triangleID);
 	const Access &access(int triangleID) const;
 	void setAccess(int triangleID, const Access &access);
+	int findTriangle(int x, int y) const;
+	int pickTriangle(const QVector3D &origin, const QVector3D &direction,
+	                 float *distance = 0) const;
+	bool validate(QList<WalkmeshError> *errors = 0) const;
 	static Vertex_sr fromVertex_s(const Vertex_s &vertex_s);
 	static Vertex_s toVertex_s(const Vertex_sr &vertex_sr);
 private:
+	const WalkmeshGrid &grid() const;
+	int sharedEdge(int triangleID, const Vertex_sr &v1, const Vertex_sr &v2) const;
+	void unlinkNeighbors(int triangleID);
+	void linkNeighbors(int triangleID);
 	QList<Triangle> _triangles;
 	QList<Access> _access;
+	mutable WalkmeshGrid _grid;
 };
 
 #endif // IDFILE_H
@@ -29,19 +29,13 @@ bool PFile::read(FieldModelPart *part, const QList<int> &texIds) const
 		return false;
 	}
 
-	QList<PolyVertex> vertices/*, normals*/;
-	QList<TexCoord> texCs;
-	QList<ColorBGRA> vertexColors;
-	QList<PolygonP> polys;
-	QList<Group> groups;
+	QVector<PolyVertex> vertices/*, normals*/;
+	QVector<TexCoord> texCs;
+	QVector<ColorBGRA> vertexColors;
+	QVector<PolygonP> polys;
+	QVector<Group> groups;
 	QList<FieldModelGroup *> _groups;
 	PHeader header;
-	PolyVertex vertex;
-	TexCoord texC;
-	ColorBGRA vertexColor;
-	PolygonP poly;
-	Group group;
-	quint32 i;
 
 	if(device()->read((char *)&header, 128) != 128
 	        || header.version != 1 || header.off04 != 1
@@ -49,14 +43,15 @@ bool PFile::read(FieldModelPart *part, const QList<int> &texIds) const
 		return false;
 	}
 
-	for(i = 0 ; i < header.numVertices ; ++i) {
-		if(device()->read((char *)&vertex, 12) != 12) {
-			return false;
-		}
+	if(!readArray(vertices, header.numVertices, 12)) {
+		return false;
+	}
+
+	for(int i = 0 ; i < vertices.size() ; ++i) {
+		PolyVertex &vertex = vertices[i];
 		vertex.x = vertex.x / MODEL_SCALE_PC;
 		vertex.y = vertex.y / MODEL_SCALE_PC;
 		vertex.z = vertex.z / MODEL_SCALE_PC;
-		vertices.append(vertex);
 	}
 
 //	for(i = 0 ; i < header.numNormals ; ++i) {
@@ -70,44 +65,28 @@ bool PFile::read(FieldModelPart *part, const QList<int> &texIds) const
 		return false;
 	}
 
-	for(i = 0 ; i < header.numTexCs ; ++i) {
-		if(device()->read((char *)&texC, 8) != 8) {
-			return false;
-		}
-		texCs.append(texC);
-	}
-
-	for(i = 0 ; i < header.numVertexColors ; ++i) {
-		if(device()->read((char *)&vertexColor, 4) != 4) {
-			return false;
-		}
-		vertexColors.append(vertexColor);
+	if(!readArray(texCs, header.numTexCs, 8)
+	        || !readArray(vertexColors, header.numVertexColors, 4)) {
+		return false;
 	}
 
 	if(!device()->seek(device()->pos() + (header.numPolys + header.numEdges) * 4)) {
 		return false;
 	}
 
-	for(i = 0 ; i < header.numPolys ; ++i) {
-		if(device()->read((char *)&poly, 24) != 24) {
-			return false;
-		}
-		polys.append(poly);
+	if(!readArray(polys, header.numPolys, 24)) {
+		return false;
 	}
 
 	if(!device()->seek(device()->pos() + header.numHundreds * 100)) {
 		return false;
 	}
 
-	for(i = 0 ; i < header.numGroups ; ++i) {
-		if(device()->read((char *)&group, 56) != 56) {
-			return false;
-		}
-		groups.append(group);
+	if(!readArray(groups, header.numGroups, 56)) {
+		return false;
 	}
 
-	PolyVertex polyVertex;
-	QRgb color;
+	_groups.reserve(groups.size());
 
 	foreach(const Group &g, groups) {
 		FieldModelGroup *grp = new FieldModelGroup();
@@ -119,11 +98,17 @@ bool PFile::read(FieldModelPart *part, const QList<int> &texIds) const
 			}
 		}
 
-		for(quint32 polyID = 0 ; polyID < g.numPolygons && g.polygonStartIndex + polyID < (quint32)polys.size() ; ++polyID) {
+		const quint32 polyCount = g.polygonStartIndex < (quint32)polys.size()
+		        ? qMin(g.numPolygons, polys.size() - g.polygonStartIndex)
+		        : 0;
+		grp->reserve(polyCount, polyCount * 3);
+
+		for(quint32 polyID = 0 ; polyID < polyCount ; ++polyID) {
 			const PolygonP &poly = polys.at(g.polygonStartIndex + polyID);
-			QList<PolyVertex> polyVertices;
-			QList<QRgb> polyColors;
-			QList<TexCoord> polyTexCoords;
+			PolyVertex polyVertices[3];
+			QRgb polyColors[3];
+			TexCoord polyTexCoords[3];
+			bool hasTexCoords = g.areTexturesUsed, isValid = true;
 
 			for(quint8 j = 0 ; j < 3 ; ++j) {
 				int vertexIndex = g.verticesStartIndex + poly.VertexIndex[j];
@@ -131,27 +116,31 @@ bool PFile::read(FieldModelPart *part, const QList<int> &texIds) const
 				if(vertexIndex < vertices.size() &&
 						vertexIndex < vertexColors.size()) {
 					// vertex
-					vertex = vertices.at(vertexIndex);
-					polyVertex.x = vertex.x;
-					polyVertex.y = vertex.y;
-					polyVertex.z = vertex.z;
-					polyVertices.append(polyVertex);
+					polyVertices[j] = vertices.at(vertexIndex);
 					// color
-					vertexColor = vertexColors.at(vertexIndex);
-					color = qRgb(vertexColor.red, vertexColor.green, vertexColor.blue);
-					polyColors.append(color);
+					const ColorBGRA &vertexColor = vertexColors.at(vertexIndex);
+					polyColors[j] = qRgb(vertexColor.red, vertexColor.green, vertexColor.blue);
 
-					if(g.areTexturesUsed) {
+					if(hasTexCoords) {
 						int texCoordIndex = g.texCoordStartIndex + poly.VertexIndex[j];
 
 						if(texCoordIndex < texCs.size()) {
 							// tex coord
-							polyTexCoords.append(texCs.at(texCoordIndex));
+							polyTexCoords[j] = texCs.at(texCoordIndex);
+						} else {
+							hasTexCoords = false;
 						}
 					}
+				} else {
+					isValid = false;
+					break;
 				}
 			}
-			grp->addPolygon(new TrianglePoly(polyVertices, polyColors, polyTexCoords));
+
+			if(isValid) {
+				grp->addTriangle(polyVertices, polyColors,
+				                 hasTexCoords ? polyTexCoords : 0);
+			}
 		}
 
 		_groups.append(grp);
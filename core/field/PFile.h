@@ -80,6 +80,17 @@ public:
 
 	bool read(FieldModelPart *part, const QList<int> &texIds) const;
 	bool write(const FieldModelPart *part, const QList<int> &texIds) const;
+private:
+	template<typename T>
+	bool readArray(QVector<T> &array, quint32 count, int elementSize) const {
+		const qint64 size = qint64(count) * elementSize;
+		if(sizeof(T) != size_t(elementSize)
+		        || size > device()->size() - device()->pos()) {
+			return false;
+		}
+		array.resize(count);
+		return device()->read((char *)array.data(), size) == size;
+	}
 };
 
 #endif // PFILE_H
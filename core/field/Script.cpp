@@ -16,29 +16,34 @@
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "Script.h"
+#include "ScriptAnalysis.h"
+#include "GrpScript.h"
 
 Script::Script() :
-	valid(true)
+	_dirty(true), _analysis(0), _grpScript(0), valid(true)
 {
 }
 
 Script::Script(const QList<Opcode *> &opcodes) :
-	_opcodes(opcodes), valid(true)
+	_opcodes(opcodes), _dirty(true), _analysis(0), _grpScript(0), valid(true)
 {
 }
 
-Script::Script(const QByteArray &script)
+Script::Script(const QByteArray &script) :
+	_dirty(true), _analysis(0), _grpScript(0)
 {
 	valid = openScript(script, 0, script.size());
 }
 
-Script::Script(const QByteArray &script, int pos, int size)
+Script::Script(const QByteArray &script, int pos, int size) :
+	_dirty(true), _analysis(0), _grpScript(0)
 {
 	valid = openScript(script, pos, size);
 }
 
 Script::Script(const Script &other) :
-	lastError(other.lastError), valid(other.valid)
+	lastError(other.lastError), _byteArray(other._byteArray),
+	_dirty(other._dirty), _analysis(0), _grpScript(0), valid(other.valid)
 {
 	foreach(Opcode *opcode, other.opcodes()) {
 		_opcodes.append(Script::copyOpcode(opcode));
@@ -48,6 +53,7 @@ Script::Script(const Script &other) :
 Script::~Script()
 {
 	qDeleteAll(_opcodes);
+	delete _analysis;
 }
 
 bool Script::openScript(const QByteArray &script, const int initPos, const int size)
@@ -55,6 +61,7 @@ bool Script::openScript(const QByteArray &script, const int initPos, const int s
 	int pos = 0, scriptSize = qMin(script.size() - initPos, size), opcodeID=1;
 	QList<int> positions;
 	QMultiMap<int, OpcodeJump *> indents;
+	bool hasBadJump = false;
 
 	while(pos < scriptSize) {
 		Opcode *op = createOpcode(script, initPos + pos);
@@ -85,6 +92,7 @@ bool Script::openScript(const QByteArray &script, const int initPos, const int s
 			foreach(OpcodeJump *opJump, indents.values(jump)) {
 				opJump->setBadJump(true);
 			}
+			hasBadJump = true;
 //			return false;
 			/*int opID=0;
 			bool repaired=false;
@@ -106,6 +114,12 @@ bool Script::openScript(const QByteArray &script, const int initPos, const int s
 		}
 	}
 
+	// Serializing again gives the same bytes, unless a jump is invalid
+	_dirty = hasBadJump || pos != scriptSize;
+	if(!_dirty) {
+		_byteArray = script.mid(initPos, scriptSize);
+	}
+
 	return true;
 }
 
@@ -685,6 +699,7 @@ Script *Script::splitScriptAtReturn()
 	for( ; opcodeID < size ; ++opcodeID) {
 		_opcodes.removeLast();
 	}
+	setDirty();
 
 	return s;
 }
@@ -826,8 +841,29 @@ bool Script::verifyOpcodeJumpRange(OpcodeJump *opcodeJump, QString &errorStr) co
 
 bool Script::compile(int &opcodeID, QString &errorStr)
 {
+	QList<ScriptCompileError> errors;
+
+	if(!compile(errors)) {
+		opcodeID = errors.first().opcodeID;
+		errorStr = errors.first().errorStr;
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * Computes jumps, every error found is appended to errors
+ * (only groupID and scriptID are not set).
+ * The size of the script in bytes is set in byteSize.
+ */
+bool Script::compile(QList<ScriptCompileError> &errors, quint32 *byteSize)
+{
+	const int errorCount = errors.size();
 	quint32 pos=0;
+	int opcodeID;
 	QHash<quint32, quint32> labelPositions;// Each label is unique
+	labelPositions.reserve(_opcodes.size() / 4);
 
 	// Search labels
 	opcodeID = 0;
@@ -836,9 +872,9 @@ bool Script::compile(int &opcodeID, QString &errorStr)
 			if(!labelPositions.contains(static_cast<OpcodeLabel *>(opcode)->label())) {
 				labelPositions.insert(static_cast<OpcodeLabel *>(opcode)->label(), pos);
 			} else {
-				errorStr = QObject::tr("Label %1 is declared several times.")
-				           .arg(static_cast<OpcodeLabel *>(opcode)->label());
-				return false;
+				errors.append(ScriptCompileError(opcodeID,
+				              QObject::tr("Label %1 is declared several times.")
+				              .arg(static_cast<OpcodeLabel *>(opcode)->label())));
 			}
 		} else {
 			pos += opcode->size();
@@ -860,20 +896,15 @@ bool Script::compile(int &opcodeID, QString &errorStr)
 				opcodeJump->setJump(jump);
 
 				if(!opcodeJump->isLongJump() && quint32(qAbs(jump)) > opcodeJump->maxJump()) {
-					errorStr = QObject::tr("Label %1 is unreachable, please use a long jump.").arg(opcodeJump->label());
-					return false;
-				}
-				if(opcodeJump->isLongJump() && quint32(qAbs(jump)) > opcodeJump->maxJump()) {
-					errorStr = QObject::tr("Label %1 is unreachable because your script exceeds 65535 bytes, please reduce the size of the script.").arg(opcodeJump->label());
-					return false;
-				}
-				if(opcodeJump->id() != Opcode::JMPF
+					errors.append(ScriptCompileError(opcodeID, QObject::tr("Label %1 is unreachable, please use a long jump.").arg(opcodeJump->label())));
+				} else if(opcodeJump->isLongJump() && quint32(qAbs(jump)) > opcodeJump->maxJump()) {
+					errors.append(ScriptCompileError(opcodeID, QObject::tr("Label %1 is unreachable because your script exceeds 65535 bytes, please reduce the size of the script.").arg(opcodeJump->label())));
+				} else if(opcodeJump->id() != Opcode::JMPF
 						&& opcodeJump->id() != Opcode::JMPFL
 						&& opcodeJump->id() != Opcode::JMPB
 						&& opcodeJump->id() != Opcode::JMPBL
 						&& jump - opcodeJump->jumpPosData() < 0) {
-					errorStr = QObject::tr("The label %1 is unreachable because it is located before the opcode.").arg(opcodeJump->label());
-					return false;
+					errors.append(ScriptCompileError(opcodeID, QObject::tr("The label %1 is unreachable because it is located before the opcode.").arg(opcodeJump->label())));
 				}
 			}
 		}
@@ -882,18 +913,43 @@ bool Script::compile(int &opcodeID, QString &errorStr)
 	}
 
 	if(pos > 65535) {
-		errorStr = QObject::tr("Script too big, it should not exceed 65535 bytes. Actual size: %1.").arg(pos);
-		return false;
+		errors.append(ScriptCompileError(opcodeID, QObject::tr("Script too big, it should not exceed 65535 bytes. Actual size: %1.").arg(pos)));
 	}
 
-	return true;
+	if(byteSize) {
+		*byteSize = pos;
+	}
+
+	return errors.size() == errorCount;
 }
 
+/*!
+ * Returns the cached bytecode, scripts are only serialized again
+ * after a modification.
+ */
 QByteArray Script::toByteArray() const
+{
+	if(_dirty) {
+		_byteArray.clear();
+		_byteArray.reserve(byteSize());
+		serializeOpcodes(_byteArray);
+		_dirty = false;
+	}
+	return _byteArray;
+}
+
+/*!
+ * Appends the script to out.
+ */
+void Script::toByteArray(QByteArray &out) const
+{
+	out.append(toByteArray());
+}
+
+void Script::serializeOpcodes(QByteArray &out) const
 {
 	quint32 pos=0;
 	QHash<quint32, quint32> labelPositions;// Each label is unique
-	QByteArray ret;
 
 	// Search labels
 	foreach(const Opcode *opcode, _opcodes) {
@@ -914,15 +970,57 @@ QByteArray Script::toByteArray() const
 			opcode = convertOpcodeJumpDirection(opcodeJump);
 			delPlease = opcode != opcodeJump;
 		}
-		ret.append(opcode->toByteArray());
+		out.append(opcode->toByteArray());
 		pos += opcode->size();
 
 		if(delPlease) {
 			delete opcode;
 		}
 	}
+}
 
-	return ret;
+/*!
+ * Size of toByteArray() result, without serializing the opcodes.
+ */
+quint32 Script::byteSize() const
+{
+	if(!_dirty) {
+		return _byteArray.size();
+	}
+
+	quint32 size = 0;
+
+	foreach(const Opcode *opcode, _opcodes) {
+		if(!opcode->isLabel()) {
+			size += opcode->size();
+		}
+	}
+
+	return size;
+}
+
+/*!
+ * Must be called when an opcode is modified in place.
+ */
+void Script::setDirty()
+{
+	_dirty = true;
+	delete _analysis;
+	_analysis = 0;
+	if(_grpScript) {
+		_grpScript->setDirty();
+	}
+}
+
+/*!
+ * Control flow and dataflow of the script, kept until the next modification.
+ */
+const ScriptAnalysis &Script::analysis() const
+{
+	if(!_analysis) {
+		_analysis = new ScriptAnalysis(this);
+	}
+	return *_analysis;
 }
 
 bool Script::isVoid() const
@@ -938,22 +1036,26 @@ void Script::setOpcode(quint16 opcodeID, Opcode *opcode)
 	Opcode *curOpcode = _opcodes.at(opcodeID);
 	_opcodes.replace(opcodeID, opcode);
 	delete curOpcode;
+	setDirty();
 }
 
 void Script::delOpcode(quint16 opcodeID)
 {
 	delete _opcodes.takeAt(opcodeID);
+	setDirty();
 }
 
 Opcode *Script::removeOpcode(quint16 opcodeID)
 {
 	Opcode *opcode = _opcodes.takeAt(opcodeID);
+	setDirty();
 	return opcode;
 }
 
 void Script::insertOpcode(quint16 opcodeID, Opcode *opcode)
 {
 	_opcodes.insert(opcodeID, opcode);
+	setDirty();
 }
 
 bool Script::moveOpcode(quint16 opcodeID, MoveDirection direction)
@@ -970,6 +1072,7 @@ bool Script::moveOpcode(quint16 opcodeID, MoveDirection direction)
 		if(opcodeID == 0)	return false;
 		_opcodes.swap(opcodeID, opcodeID-1);
 	}
+	setDirty();
 	return true;
 }
 
@@ -1086,30 +1189,35 @@ void Script::shiftGroupIds(int groupId, int steps)
 {
 	foreach(Opcode *opcode, _opcodes)
 		opcode->shiftGroupIds(groupId, steps);
+	setDirty();
 }
 
 void Script::shiftTextIds(int textId, int steps)
 {
 	foreach(Opcode *opcode, _opcodes)
 		opcode->shiftTextIds(textId, steps);
+	setDirty();
 }
 
 void Script::shiftTutIds(int tutId, int steps)
 {
 	foreach(Opcode *opcode, _opcodes)
 		opcode->shiftTutIds(tutId, steps);
+	setDirty();
 }
 
 void Script::swapGroupIds(int groupId1, int groupId2)
 {
 	foreach(Opcode *opcode, _opcodes)
 		opcode->swapGroupIds(groupId1, groupId2);
+	setDirty();
 }
 
 void Script::setWindow(const FF7Window &win)
 {
 	if(win.opcodeID < _opcodes.size()) {
 		_opcodes.at(win.opcodeID)->setWindow(win);
+		setDirty();
 	}
 }
 
@@ -1180,6 +1288,10 @@ bool Script::removeTexts()
 		}
 	}
 
+	if(modified) {
+		setDirty();
+	}
+
 	return modified;
 }
 
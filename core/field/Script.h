@@ -23,6 +23,19 @@
 
 typedef QListIterator<Opcode *> OpcodesIterator;
 
+class ScriptAnalysis;
+class GrpScript;
+
+struct ScriptCompileError
+{
+	ScriptCompileError() :
+		groupID(-1), scriptID(-1), opcodeID(-1) {}
+	ScriptCompileError(int opcodeID, const QString &errorStr) :
+		groupID(-1), scriptID(-1), opcodeID(opcodeID), errorStr(errorStr) {}
+	int groupID, scriptID, opcodeID;
+	QString errorStr;
+};
+
 class Script
 {
 public:
@@ -45,7 +58,18 @@ public:
 	const QList<Opcode *> &opcodes() const;
 	bool isVoid() const;
 	bool compile(int &opcodeID, QString &errorStr);
+	bool compile(QList<ScriptCompileError> &errors, quint32 *byteSize=0);
 	QByteArray toByteArray() const;
+	void toByteArray(QByteArray &out) const;
+	quint32 byteSize() const;
+	inline bool isDirty() const {
+		return _dirty;
+	}
+	void setDirty();
+	inline void setGroup(GrpScript *grpScript) {
+		_grpScript = grpScript;
+	}
+	const ScriptAnalysis &analysis() const;
 	inline QByteArray serialize() const {
 		return toByteArray();
 	}
@@ -88,9 +112,14 @@ public:
 	QString toString(Field *field) const;
 private:
 	OpcodeJump *convertOpcodeJumpDirection(OpcodeJump *opcodeJump, bool *ok=0) const;
+	void serializeOpcodes(QByteArray &out) const;
 //	bool verifyOpcodeJumpRange(OpcodeJump *opcodeJump, QString &errorStr) const;
 	QList<Opcode *> _opcodes;
 	QString lastError;
+	mutable QByteArray _byteArray; // Last serialization, valid when not dirty
+	mutable bool _dirty;
+	mutable ScriptAnalysis *_analysis; // Built on demand, deleted on modification
+	GrpScript *_grpScript; // Owner, its size is invalidated with the script
 
 	bool valid;
 };
@@ -0,0 +1,324 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ScriptAnalysis.h"
+#include "Script.h"
+
+ScriptAnalysis::ScriptAnalysis()
+{
+}
+
+ScriptAnalysis::ScriptAnalysis(const Script *script)
+{
+	analyze(script);
+}
+
+void ScriptAnalysis::analyze(const Script *script)
+{
+	_blocks.clear();
+	_blockOf.clear();
+	_badJumps.clear();
+	_execOpcodes.clear();
+	_defs.clear();
+	_uses.clear();
+	_useDefs.clear();
+
+	buildBlocks(script);
+	computeReachability();
+	computeReachingDefinitions(script);
+}
+
+int ScriptAnalysis::blockOf(int opcodeID) const
+{
+	return _blockOf.value(opcodeID, -1);
+}
+
+bool ScriptAnalysis::isReachable(int opcodeID) const
+{
+	int blockID = blockOf(opcodeID);
+	return blockID >= 0 && _blocks.at(blockID).reachable;
+}
+
+/*!
+ * Opcodes never executed, labels excluded.
+ */
+QList<int> ScriptAnalysis::deadOpcodes() const
+{
+	QList<int> ret;
+
+	foreach(const BasicBlock &block, _blocks) {
+		if(!block.reachable) {
+			for(int opcodeID=block.first ; opcodeID<=block.last ; ++opcodeID) {
+				ret.append(opcodeID);
+			}
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * Definitions (index in definitions()) that can give its value
+ * to the use (index in uses()), -1 for the value before the script.
+ */
+QList<int> ScriptAnalysis::reachingDefinitions(int useID) const
+{
+	return _useDefs.value(useID);
+}
+
+/*!
+ * Reachable reads of vars which can be done before any write in the script.
+ */
+QList<VarAccess> ScriptAnalysis::exposedUses() const
+{
+	QList<VarAccess> ret;
+	int useID = 0;
+
+	foreach(const VarAccess &use, _uses) {
+		if(_useDefs.at(useID).contains(-1)) {
+			ret.append(use);
+		}
+		++useID;
+	}
+
+	return ret;
+}
+
+void ScriptAnalysis::buildBlocks(const Script *script)
+{
+	const QList<Opcode *> &opcodes = script->opcodes();
+	const int size = opcodes.size();
+	QHash<quint32, int> labels;
+	QBitArray leaders(size + 1);
+	int opcodeID;
+
+	if(size == 0) {
+		return;
+	}
+
+	// Block boundaries
+	leaders.setBit(0);
+	opcodeID = 0;
+	foreach(const Opcode *opcode, opcodes) {
+		const int id = opcode->id();
+		if(opcode->isLabel()) {
+			labels.insert(static_cast<const OpcodeLabel *>(opcode)->label(), opcodeID);
+			leaders.setBit(opcodeID);
+		} else if(opcode->isJump()
+		          || id == Opcode::RET || id == Opcode::RETTO
+		          || (id >= Opcode::REQ && id <= Opcode::PRQEW)) {
+			leaders.setBit(opcodeID + 1);
+			if(id >= Opcode::REQ && id <= Opcode::PRQEW) {
+				_execOpcodes.append(opcodeID);
+			}
+		}
+		++opcodeID;
+	}
+
+	_blockOf.resize(size);
+	for(opcodeID=0 ; opcodeID<size ; ++opcodeID) {
+		if(leaders.testBit(opcodeID)) {
+			BasicBlock block;
+			block.first = block.last = opcodeID;
+			block.reachable = false;
+			_blocks.append(block);
+		} else {
+			_blocks.last().last = opcodeID;
+		}
+		_blockOf[opcodeID] = _blocks.size() - 1;
+	}
+
+	// Edges
+	const int blockCount = _blocks.size();
+	for(int blockID=0 ; blockID<blockCount ; ++blockID) {
+		BasicBlock &block = _blocks[blockID];
+		Opcode *opcode = opcodes.at(block.last);
+		const int id = opcode->id();
+		bool fallThrough = id != Opcode::RET && id != Opcode::RETTO;
+
+		if(opcode->isJump()) {
+			OpcodeJump *opcodeJump = static_cast<OpcodeJump *>(opcode);
+			int target = opcodeJump->isBadJump()
+			             ? -1
+			             : labels.value(opcodeJump->label(), -1);
+			if(target < 0) {
+				_badJumps.append(block.last);
+			} else {
+				block.successors.append(_blockOf.at(target));
+			}
+			fallThrough = id != Opcode::JMPF && id != Opcode::JMPFL
+			              && id != Opcode::JMPB && id != Opcode::JMPBL;
+		}
+
+		if(fallThrough && blockID + 1 < blockCount
+		        && !block.successors.contains(blockID + 1)) {
+			block.successors.append(blockID + 1);
+		}
+
+		foreach(int successor, block.successors) {
+			_blocks[successor].predecessors.append(blockID);
+		}
+	}
+}
+
+void ScriptAnalysis::computeReachability()
+{
+	if(_blocks.isEmpty()) {
+		return;
+	}
+
+	QList<int> toVisit;
+	toVisit.append(0);
+	_blocks[0].reachable = true;
+
+	while(!toVisit.isEmpty()) {
+		foreach(int successor, _blocks.at(toVisit.takeLast()).successors) {
+			if(!_blocks.at(successor).reachable) {
+				_blocks[successor].reachable = true;
+				toVisit.append(successor);
+			}
+		}
+	}
+}
+
+void ScriptAnalysis::computeReachingDefinitions(const Script *script)
+{
+	const QList<Opcode *> &opcodes = script->opcodes();
+	const int blockCount = _blocks.size();
+
+	if(blockCount == 0) {
+		return;
+	}
+
+	// Accesses, reads before writes for the same opcode
+	QVector<int> blockDefStart(blockCount + 1);
+	for(int blockID=0 ; blockID<blockCount ; ++blockID) {
+		const BasicBlock &block = _blocks.at(blockID);
+		blockDefStart[blockID] = _defs.size();
+		for(int opcodeID=block.first ; opcodeID<=block.last ; ++opcodeID) {
+			QList<FF7Var> vars;
+			opcodes.at(opcodeID)->getVariables(vars);
+			foreach(const FF7Var &var, vars) {
+				if(!var.write) {
+					_uses.append(VarAccess(opcodeID, var));
+				}
+			}
+			foreach(const FF7Var &var, vars) {
+				if(var.write) {
+					_defs.append(VarAccess(opcodeID, var));
+				}
+			}
+		}
+	}
+	blockDefStart[blockCount] = _defs.size();
+
+	// Each used var has a pseudo definition at the script entry
+	const int defCount = _defs.size();
+	QHash<int, QList<int> > defsByVar;
+	for(int defID=0 ; defID<defCount ; ++defID) {
+		defsByVar[varKey(_defs.at(defID).var)].append(defID);
+	}
+	int bitCount = defCount;
+	QList<int> entryDefs;
+	foreach(const VarAccess &use, _uses) {
+		QList<int> &defIDs = defsByVar[varKey(use.var)];
+		if(defIDs.isEmpty() || defIDs.last() < defCount) {
+			defIDs.append(bitCount);
+			entryDefs.append(bitCount);
+			++bitCount;
+		}
+	}
+
+	QHash<int, QBitArray> varBits;
+	QHashIterator<int, QList<int> > it(defsByVar);
+	while(it.hasNext()) {
+		it.next();
+		QBitArray bits(bitCount);
+		foreach(int defID, it.value()) {
+			bits.setBit(defID);
+		}
+		varBits.insert(it.key(), bits);
+	}
+
+	// Gen and kill sets
+	QVector<QBitArray> gen(blockCount, QBitArray(bitCount)),
+	        kill(blockCount, QBitArray(bitCount)),
+	        in(blockCount, QBitArray(bitCount)),
+	        out(blockCount, QBitArray(bitCount));
+	for(int blockID=0 ; blockID<blockCount ; ++blockID) {
+		for(int defID=blockDefStart.at(blockID) ; defID<blockDefStart.at(blockID + 1) ; ++defID) {
+			const QBitArray &bits = varBits[varKey(_defs.at(defID).var)];
+			gen[blockID] &= ~bits;
+			gen[blockID].setBit(defID);
+			kill[blockID] |= bits;
+		}
+		kill[blockID] &= ~gen.at(blockID);
+	}
+
+	QBitArray entry(bitCount);
+	foreach(int defID, entryDefs) {
+		entry.setBit(defID);
+	}
+
+	// Iterate until stable
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(int blockID=0 ; blockID<blockCount ; ++blockID) {
+			const BasicBlock &block = _blocks.at(blockID);
+			if(!block.reachable) {
+				continue;
+			}
+			QBitArray blockIn = blockID == 0 ? entry : QBitArray(bitCount);
+			foreach(int predecessor, block.predecessors) {
+				blockIn |= out.at(predecessor);
+			}
+			QBitArray blockOut = gen.at(blockID) | (blockIn & ~kill.at(blockID));
+			in[blockID] = blockIn;
+			if(blockOut != out.at(blockID)) {
+				out[blockID] = blockOut;
+				changed = true;
+			}
+		}
+	}
+
+	// Def-use chains
+	foreach(const VarAccess &use, _uses) {
+		const int blockID = _blockOf.at(use.opcodeID), key = varKey(use.var);
+		int lastDef = -1;
+
+		for(int defID=blockDefStart.at(blockID) ; defID<blockDefStart.at(blockID + 1)
+		    && _defs.at(defID).opcodeID < use.opcodeID ; ++defID) {
+			if(varKey(_defs.at(defID).var) == key) {
+				lastDef = defID;
+			}
+		}
+
+		QList<int> reaching;
+		if(lastDef >= 0) {
+			reaching.append(lastDef);
+		} else {
+			const QBitArray &blockIn = in.at(blockID);
+			foreach(int defID, defsByVar.value(key)) {
+				if(blockIn.testBit(defID)) {
+					reaching.append(defID < defCount ? defID : -1);
+				}
+			}
+		}
+		_useDefs.append(reaching);
+	}
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef SCRIPTANALYSIS_H
+#define SCRIPTANALYSIS_H
+
+#include <QtCore>
+#include "Opcode.h"
+
+class Script;
+
+struct BasicBlock
+{
+	int first, last; // Opcode IDs, inclusive
+	QList<int> successors, predecessors; // Block IDs
+	bool reachable;
+};
+
+struct VarAccess
+{
+	VarAccess(int opcodeID, const FF7Var &var) :
+		opcodeID(opcodeID), var(var) {}
+	int opcodeID;
+	FF7Var var;
+};
+
+/*
+ * Control flow graph of a script and reaching definitions of its vars.
+ * A var is identified by its bank and address, whatever its size.
+ */
+class ScriptAnalysis
+{
+public:
+	ScriptAnalysis();
+	explicit ScriptAnalysis(const Script *script);
+	void analyze(const Script *script);
+
+	inline const QList<BasicBlock> &blocks() const {
+		return _blocks;
+	}
+	int blockOf(int opcodeID) const;
+	bool isReachable(int opcodeID) const;
+	QList<int> deadOpcodes() const;
+	inline const QList<int> &badJumps() const {
+		return _badJumps;
+	}
+	inline const QList<int> &execOpcodes() const {
+		return _execOpcodes;
+	}
+	inline const QList<VarAccess> &definitions() const {
+		return _defs;
+	}
+	inline const QList<VarAccess> &uses() const {
+		return _uses;
+	}
+	QList<int> reachingDefinitions(int useID) const;
+	QList<VarAccess> exposedUses() const;
+private:
+	static inline int varKey(const FF7Var &var) {
+		return (var.bank << 8) | var.address;
+	}
+	void buildBlocks(const Script *script);
+	void computeReachability();
+	void computeReachingDefinitions(const Script *script);
+
+	QList<BasicBlock> _blocks;
+	QVector<int> _blockOf; // By opcode ID
+	QList<int> _badJumps, _execOpcodes;
+	QList<VarAccess> _defs, _uses; // In opcode order
+	QList< QList<int> > _useDefs; // Def IDs by use, -1 when the value comes from outside the script
+};
+
+#endif // SCRIPTANALYSIS_H
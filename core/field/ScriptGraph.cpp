@@ -0,0 +1,275 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ScriptGraph.h"
+#include "Section1File.h"
+
+ScriptGraph::ScriptGraph() :
+	_indexesDirty(false)
+{
+}
+
+void ScriptGraph::clear()
+{
+	_execs.clear();
+	_jumps.clear();
+	_jumpsTo.clear();
+	_fieldsByExec.clear();
+	_fieldsByMapJump.clear();
+	_indexesDirty = false;
+}
+
+void ScriptGraph::collectEdges(int fieldID, const Section1File *scripts,
+                               QList<ExecEdge> &execs, QList<MapJumpEdge> &jumps)
+{
+	int groupID = 0;
+	foreach(const GrpScript *group, scripts->grpScripts()) {
+		int scriptID = 0;
+		foreach(const Script *script, group->scripts()) {
+			int opcodeID = 0;
+			foreach(const Opcode *opcode, script->opcodes()) {
+				switch(opcode->id()) {
+				case Opcode::REQ:
+				case Opcode::REQSW:
+				case Opcode::REQEW: {
+					const OpcodeExec *exec = static_cast<const OpcodeExec *>(opcode);
+					ExecEdge edge;
+					edge.fieldID = fieldID;
+					edge.groupID = groupID;
+					edge.scriptID = scriptID;
+					edge.opcodeID = opcodeID;
+					edge.opcode = opcode->id();
+					edge.targetGroupID = exec->groupID;
+					edge.partyID = 0;
+					edge.targetScriptID = exec->scriptID;
+					edge.priority = exec->priority;
+					execs.append(edge);
+				}	break;
+				case Opcode::PREQ:
+				case Opcode::PRQSW:
+				case Opcode::PRQEW: {
+					const OpcodeExecChar *exec = static_cast<const OpcodeExecChar *>(opcode);
+					ExecEdge edge;
+					edge.fieldID = fieldID;
+					edge.groupID = groupID;
+					edge.scriptID = scriptID;
+					edge.opcodeID = opcodeID;
+					edge.opcode = opcode->id();
+					edge.targetGroupID = -1;
+					edge.partyID = exec->partyID;
+					edge.targetScriptID = exec->scriptID;
+					edge.priority = exec->priority;
+					execs.append(edge);
+				}	break;
+				case Opcode::MAPJUMP:
+				case Opcode::MINIGAME:
+				case Opcode::PMJMP: {
+					MapJumpEdge edge;
+					edge.fieldID = fieldID;
+					edge.groupID = groupID;
+					edge.scriptID = scriptID;
+					edge.opcodeID = opcodeID;
+					edge.opcode = opcode->id();
+					edge.targetFieldID = -1;
+					edge.targetX = edge.targetY = 0;
+					edge.targetI = 0;
+					edge.direction = 0;
+					if(opcode->id() == Opcode::MAPJUMP) {
+						const OpcodeMAPJUMP *mapJump = static_cast<const OpcodeMAPJUMP *>(opcode);
+						edge.mapID = mapJump->fieldID;
+						edge.targetX = mapJump->targetX;
+						edge.targetY = mapJump->targetY;
+						edge.targetI = mapJump->targetI;
+						edge.direction = mapJump->direction;
+					} else if(opcode->id() == Opcode::MINIGAME) {
+						const OpcodeMINIGAME *minigame = static_cast<const OpcodeMINIGAME *>(opcode);
+						edge.mapID = minigame->fieldID;
+						edge.targetX = minigame->targetX;
+						edge.targetY = minigame->targetY;
+						edge.targetI = minigame->targetI;
+					} else {
+						edge.mapID = static_cast<const OpcodePMJMP *>(opcode)->fieldID;
+					}
+					jumps.append(edge);
+				}	break;
+				}
+				++opcodeID;
+			}
+			++scriptID;
+		}
+		++groupID;
+	}
+}
+
+void ScriptGraph::setFieldEdges(int fieldID, const QList<ExecEdge> &execs,
+                                const QList<MapJumpEdge> &jumps)
+{
+	_execs.insert(fieldID, execs);
+	_jumps.insert(fieldID, jumps);
+	_indexesDirty = true;
+}
+
+void ScriptGraph::removeFieldEdges(int fieldID)
+{
+	_execs.remove(fieldID);
+	_jumps.remove(fieldID);
+	_indexesDirty = true;
+}
+
+void ScriptGraph::updateIndexes() const
+{
+	if(!_indexesDirty) {
+		return;
+	}
+
+	_jumpsTo.clear();
+	_fieldsByExec.clear();
+	_fieldsByMapJump.clear();
+
+	QHashIterator<int, QList<ExecEdge> > itExec(_execs);
+	while(itExec.hasNext()) {
+		itExec.next();
+		foreach(const ExecEdge &edge, itExec.value()) {
+			if(edge.targetGroupID >= 0) {
+				_fieldsByExec[(edge.targetGroupID << 8) | edge.targetScriptID].insert(edge.fieldID);
+			}
+		}
+	}
+
+	QHashIterator<int, QList<MapJumpEdge> > itJump(_jumps);
+	while(itJump.hasNext()) {
+		itJump.next();
+		foreach(const MapJumpEdge &edge, itJump.value()) {
+			if(!edge.isJump()) {
+				continue;
+			}
+			_fieldsByMapJump[edge.mapID].insert(edge.fieldID);
+			if(edge.targetFieldID >= 0) {
+				_jumpsTo[edge.targetFieldID].append(edge);
+			}
+		}
+	}
+
+	_indexesDirty = false;
+}
+
+QList<ExecEdge> ScriptGraph::callers(int fieldID, int groupID, int scriptID) const
+{
+	QList<ExecEdge> ret;
+
+	foreach(const ExecEdge &edge, _execs.value(fieldID)) {
+		if(edge.targetGroupID == groupID && edge.targetScriptID == scriptID) {
+			ret.append(edge);
+		}
+	}
+
+	return ret;
+}
+
+QList<ExecEdge> ScriptGraph::callees(int fieldID, int groupID, int scriptID) const
+{
+	QList<ExecEdge> ret;
+
+	foreach(const ExecEdge &edge, _execs.value(fieldID)) {
+		if(edge.groupID == groupID && edge.scriptID == scriptID) {
+			ret.append(edge);
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * MAPJUMP and MINIGAME edges going to the field.
+ */
+QList<MapJumpEdge> ScriptGraph::mapJumpsTo(int fieldID) const
+{
+	updateIndexes();
+	return _jumpsTo.value(fieldID);
+}
+
+QList<int> ScriptGraph::fieldsLeadingTo(int fieldID) const
+{
+	QList<int> ret;
+
+	foreach(const MapJumpEdge &edge, mapJumpsTo(fieldID)) {
+		if(!ret.contains(edge.fieldID)) {
+			ret.append(edge.fieldID);
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * Returns the map jumps of the shortest route between the two fields,
+ * or an empty list if there is none.
+ */
+QList<MapJumpEdge> ScriptGraph::shortestRoute(int fromFieldID, int toFieldID) const
+{
+	QHash<int, MapJumpEdge> reachedBy;
+	QQueue<int> queue;
+	QList<MapJumpEdge> route;
+
+	if(fromFieldID == toFieldID) {
+		return route;
+	}
+
+	queue.enqueue(fromFieldID);
+
+	while(!queue.isEmpty()) {
+		int fieldID = queue.dequeue();
+
+		foreach(const MapJumpEdge &edge, _jumps.value(fieldID)) {
+			if(!edge.isJump() || edge.targetFieldID < 0
+			        || edge.targetFieldID == fromFieldID
+			        || reachedBy.contains(edge.targetFieldID)) {
+				continue;
+			}
+			reachedBy.insert(edge.targetFieldID, edge);
+			if(edge.targetFieldID == toFieldID) {
+				for(int id = toFieldID ; id != fromFieldID ; ) {
+					const MapJumpEdge &step = reachedBy[id];
+					route.prepend(step);
+					id = step.fieldID;
+				}
+				return route;
+			}
+			queue.enqueue(edge.targetFieldID);
+		}
+	}
+
+	return route;
+}
+
+/*!
+ * Fields containing REQ, REQSW or REQEW to this group script.
+ */
+QSet<int> ScriptGraph::fieldsWithExec(quint8 groupID, quint8 scriptID) const
+{
+	updateIndexes();
+	return _fieldsByExec.value((groupID << 8) | scriptID);
+}
+
+/*!
+ * Fields containing MAPJUMP or MINIGAME to this map.
+ */
+QSet<int> ScriptGraph::fieldsWithMapJump(quint16 mapID) const
+{
+	updateIndexes();
+	return _fieldsByMapJump.value(mapID);
+}
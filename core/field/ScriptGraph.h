@@ -0,0 +1,88 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef SCRIPTGRAPH_H
+#define SCRIPTGRAPH_H
+
+#include <QtCore>
+#include "Opcode.h"
+
+class Section1File;
+
+struct ExecEdge
+{
+	int fieldID, groupID, scriptID, opcodeID; // Caller
+	int opcode; // REQ, REQSW, REQEW, PREQ, PRQSW or PRQEW
+	int targetGroupID; // -1 with PREQ, PRQSW and PRQEW
+	quint8 partyID; // PREQ, PRQSW and PRQEW only
+	quint8 targetScriptID, priority;
+};
+
+struct MapJumpEdge
+{
+	int fieldID, groupID, scriptID, opcodeID; // Caller
+	int opcode; // MAPJUMP, MINIGAME or PMJMP
+	quint16 mapID; // Index in Data::field_names
+	int targetFieldID; // -1 if the target is not in the archive
+	qint16 targetX, targetY; // Not set with PMJMP
+	quint16 targetI; // Not set with PMJMP
+	quint8 direction; // MAPJUMP only
+	inline bool isJump() const {
+		return opcode != Opcode::PMJMP; // PMJMP only preloads the target
+	}
+};
+
+/*
+ * Exec edges between group scripts of a field and map jumps between fields.
+ * Fields are identified by their ID in the archive.
+ */
+class ScriptGraph
+{
+public:
+	ScriptGraph();
+	void clear();
+	static void collectEdges(int fieldID, const Section1File *scripts,
+	                         QList<ExecEdge> &execs, QList<MapJumpEdge> &jumps);
+	void setFieldEdges(int fieldID, const QList<ExecEdge> &execs,
+	                   const QList<MapJumpEdge> &jumps);
+	void removeFieldEdges(int fieldID);
+
+	inline QList<ExecEdge> execEdges(int fieldID) const {
+		return _execs.value(fieldID);
+	}
+	QList<ExecEdge> callers(int fieldID, int groupID, int scriptID) const;
+	QList<ExecEdge> callees(int fieldID, int groupID, int scriptID) const;
+	inline QList<MapJumpEdge> mapJumps(int fieldID) const {
+		return _jumps.value(fieldID);
+	}
+	QList<MapJumpEdge> mapJumpsTo(int fieldID) const;
+	QList<int> fieldsLeadingTo(int fieldID) const;
+	QList<MapJumpEdge> shortestRoute(int fromFieldID, int toFieldID) const;
+	QSet<int> fieldsWithExec(quint8 groupID, quint8 scriptID) const;
+	QSet<int> fieldsWithMapJump(quint16 mapID) const;
+private:
+	void updateIndexes() const;
+
+	QHash<int, QList<ExecEdge> > _execs; // By field ID
+	QHash<int, QList<MapJumpEdge> > _jumps; // By field ID
+	mutable QHash<int, QList<MapJumpEdge> > _jumpsTo; // By target field ID
+	mutable QHash<int, QSet<int> > _fieldsByExec; // By group << 8 | script
+	mutable QHash<int, QSet<int> > _fieldsByMapJump; // By map ID
+	mutable bool _indexesDirty;
+};
+
+#endif // SCRIPTGRAPH_H
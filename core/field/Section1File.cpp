@@ -17,6 +17,7 @@
  ****************************************************************************/
 #include "Section1File.h"
 #include "Field.h"
+#include "FieldArchive.h"
 #include "core/Config.h"
 
 GrpScriptsIterator::GrpScriptsIterator(const GrpScriptsIterator &other) :
@@ -117,13 +118,14 @@ Opcode *GrpScriptsIterator::previousOpcode()
 }
 
 Section1File::Section1File(Field *field) :
-	FieldPart(field), _scale(0), _tut(0)
+	FieldPart(field), _scale(0), _tut(0), _revision(0)
 {
 }
 
 Section1File::Section1File(const Section1File &other) :
 	FieldPart(other.field()), _author(other.author()),
-	_scale(other.scale()), _texts(other.texts()), _tut(other.tut())
+	_scale(other.scale()), _texts(other.texts()), _tut(other.tut()),
+	_revision(0)
 {
 	foreach(const GrpScript *grpScript, other.grpScripts()) {
 		_grpScripts.append(new GrpScript(*grpScript));
@@ -141,6 +143,7 @@ void Section1File::clear()
 	_grpScripts.clear();
 	_texts.clear();
 	_author.clear();
+	++_revision;
 
 	setOpen(false);
 }
@@ -152,6 +155,8 @@ bool Section1File::open()
 
 bool Section1File::open(const QByteArray &data)
 {
+	++_revision;
+
 	quint16 version, posTexts;
 	int cur, dataSize = data.size();
 	const char *constData = data.constData();
@@ -296,96 +301,146 @@ bool Section1File::open(const QByteArray &data)
 
 QByteArray Section1File::save() const
 {
-	QByteArray data = field()->sectionData(Field::Scripts);
-	QByteArray grpScriptNames, positionsScripts, positionsAKAO, allScripts, realScript, positionsTexts, allTexts, allAKAOs;
-	quint32 posAKAO, posAKAOs, newPosAKAOs;
-	quint16 posTocAKAOs, posTexts, newPosScripts, newPosTexts, newNbAKAO, pos;
-	quint8 nbGrpScripts, newNbGrpScripts;
-	const char *constData = data.constData();
+	QByteArray ret = save(field()->sectionData(Field::Scripts));
+
+#ifdef SECTION1FILE_DEBUG
+	// Round-trip check: the saved section must reopen and save identically
+	if(!ret.isEmpty()) {
+		Section1File reopened(field());
+		if(!reopened.open(ret) || reopened.save(ret) != ret) {
+			qWarning() << "Section1File::save" << field()->name() << "round-trip mismatch";
+		}
+	}
+#endif
 
-	nbGrpScripts = (quint8)data.at(2);//nbGrpScripts
-	newNbGrpScripts = _grpScripts.size();
-	memcpy(&posTexts, constData + 4, 2);//posTexts (and end of the scripts section)
+	return ret;
+}
+
+/*!
+ * The section is built in one buffer: sizes are computed first,
+ * then scripts and texts are written in place and offsets are patched.
+ * The header and unmodified AKAOs are taken from \a data,
+ * the current section.
+ */
+QByteArray Section1File::save(const QByteArray &data) const
+{
+	QByteArray akaoToc;
+	quint32 posAKAO, posAKAOs = 0, newPosAKAOs;
+	quint16 posTocAKAOs = 0, newPosTexts, newNbAKAO, pos;
+	const quint8 newNbGrpScripts = _grpScripts.size();
+	const bool tutModified = _tut && _tut->isModified();
+
+	if(data.size() < 32) {
+		return QByteArray();
+	}
+	const char *constHeader = data.constData();
 
-	if(_tut && _tut->isModified()) {
+	if(tutModified) {
 		newNbAKAO = _tut->size();
 	} else {
-		memcpy(&newNbAKAO, constData + 6, 2);//nbAKAO
+		memcpy(&newNbAKAO, constHeader + 6, 2);//nbAKAO
+		if(newNbAKAO > 0) {
+			posTocAKAOs = 32 + quint8(data.at(2))*8;// Old nbGrpScripts
+			if(data.size() < int(posTocAKAOs + newNbAKAO * 4)) {
+				return QByteArray();
+			}
+			memcpy(&posAKAOs, data.constData() + posTocAKAOs, 4);
+		}
 	}
 
-	newPosScripts = 32 + newNbGrpScripts * 72 + newNbAKAO * 4;
-	pos = newPosScripts;
+	// First pass: sizes
+	quint32 scriptsSize = 0, textsSize = 0;
+	foreach(const GrpScript *grpScript, _grpScripts) {
+		scriptsSize += grpScript->byteSize();
+	}
+
+	const quint16 newNbText = textCount();
+	foreach(const FF7Text &text, texts()) {
+		textsSize += text.data().size() + 1;
+	}
+
+	const quint16 newPosScripts = 32 + newNbGrpScripts * 72 + newNbAKAO * 4;
+	const int posPositionsScripts = 32 + newNbGrpScripts * 8 + newNbAKAO * 4;
+	const int akaosSize = tutModified || newNbAKAO == 0 ? 0 : qMax(0, data.size() - int(posAKAOs));
+
+	QByteArray ret;
+	ret.reserve(newPosScripts + scriptsSize + 2 + newNbText * 2 + textsSize + 3 + akaosSize);
+	ret.fill('\0', newPosScripts);
 
-	// Creation newPosScripts + scripts
+	// Second pass: names and scripts
 	quint8 nbObjets3D = 0;
+	int grpScriptID = 0;
+	pos = newPosScripts;
 	foreach(GrpScript *grpScript, _grpScripts) {
-		grpScriptNames.append( grpScript->realName().leftJustified(8, QChar('\x00'), true) );
+		QByteArray name = grpScript->realName().toLatin1().leftJustified(8, '\x00', true);
+		memcpy(ret.data() + 32 + grpScriptID * 8, name.constData(), 8);
 		for(quint8 j=0 ; j<32 ; ++j) {
-			realScript = grpScript->toByteArray(j);
-			if(!realScript.isEmpty())	pos = newPosScripts + allScripts.size();
-			positionsScripts.append((char *)&pos, 2);
-			allScripts.append(realScript);
+			int scriptPos = ret.size();
+			grpScript->toByteArray(j, ret);
+			if(ret.size() != scriptPos)	pos = scriptPos;
+			memcpy(ret.data() + posPositionsScripts + (grpScriptID * 32 + j) * 2, &pos, 2);
 		}
 		if(grpScript->typeID() == GrpScript::Model)		++nbObjets3D;
+		++grpScriptID;
 	}
 
-	// Creation new positions Texts
-	newPosTexts = newPosScripts + allScripts.size();
+	// Texts
+	newPosTexts = ret.size();
 
-	quint16 newNbText = textCount();
+	ret.append((char *)&newNbText, 2);
+	const int posPositionsTexts = ret.size();
+	ret.append(QByteArray(newNbText * 2, '\0'));
 
+	int textID = 0;
 	foreach(const FF7Text &text, texts()) {
-		pos = 2 + newNbText*2 + allTexts.size();
-		positionsTexts.append((char *)&pos, 2);
-		allTexts.append(text.data());
-		allTexts.append('\xff');// end of text
+		pos = ret.size() - newPosTexts;
+		memcpy(ret.data() + posPositionsTexts + textID * 2, &pos, 2);
+		ret.append(text.data());
+		ret.append('\xff');// end of text
+		++textID;
 	}
 
 	// Word padding
-	int scriptsAndTextsSize = allScripts.size() + 2 + positionsTexts.size() + allTexts.size();
+	int scriptsAndTextsSize = ret.size() - newPosScripts;
 	if(scriptsAndTextsSize % 4 != 0) {
-		allTexts.append(QByteArray(4 - scriptsAndTextsSize % 4, '\0'));
+		ret.append(QByteArray(4 - scriptsAndTextsSize % 4, '\0'));
 	}
 
-	newPosAKAOs = newPosTexts + (2 + newNbText*2 + allTexts.size());
+	newPosAKAOs = ret.size();
 
-	if(_tut && _tut->isModified()) {
-		allAKAOs = _tut->save(positionsAKAO, newPosAKAOs);
+	if(tutModified) {
+		ret.append(_tut->save(akaoToc, newPosAKAOs));
 	} else if(newNbAKAO > 0) {
-		posTocAKAOs = 32 + nbGrpScripts*8;
-		memcpy(&posAKAOs, constData + posTocAKAOs, 4);
+		const char *constData = data.constData();
 		qint32 diff = newPosAKAOs - posAKAOs;
 
 		// Creation new positions AKAO
 		for(quint32 i=0 ; i<newNbAKAO ; ++i) {
 			memcpy(&posAKAO, constData + posTocAKAOs + i*4, 4);
 			posAKAO += diff;
-			positionsAKAO.append((char *)&posAKAO, 4);
+			akaoToc.append((char *)&posAKAO, 4);
 		}
 
-		allAKAOs = data.mid(posAKAOs);
+		ret.append(constData + posAKAOs, akaosSize);
 	}
+	memcpy(ret.data() + 32 + newNbGrpScripts * 8, akaoToc.constData(), qMin(akaoToc.size(), newNbAKAO * 4));
 
+	// Header
 	QByteArray mapauthor = _author.toLatin1().leftJustified(8, '\x00', true);
 	mapauthor[7] = '\x00';
 
-	return data.left(2) // Header
-			.append((char)newNbGrpScripts) // nbGrpScripts
-			.append((char)nbObjets3D) // nb3DObjects
-			.append((char *)&newPosTexts, 2) // PosTexts
-			.append((char *)&newNbAKAO, 2) // AKAO count
-			.append((char *)&_scale, 2)
-			.append(constData + 10, 6) // Empty
-			.append(mapauthor) // mapAuthor
-			.append(constData + 24, 8) // mapName
-			.append(grpScriptNames) // Names of grpScripts
-			.append(positionsAKAO) // PosAKAO
-			.append(positionsScripts) // PosScripts
-			.append(allScripts) // Scripts
-			.append((char *)&newNbText, 2) // nbTexts
-			.append(positionsTexts) // positionsTexts
-			.append(allTexts) // Texts
-			.append(allAKAOs); // AKAO / tutos
+	char *retData = ret.data();
+	memcpy(retData, constHeader, 2); // Version
+	retData[2] = (char)newNbGrpScripts; // nbGrpScripts
+	retData[3] = (char)nbObjets3D; // nb3DObjects
+	memcpy(retData + 4, &newPosTexts, 2); // PosTexts
+	memcpy(retData + 6, &newNbAKAO, 2); // AKAO count
+	memcpy(retData + 8, &_scale, 2);
+	memcpy(retData + 10, constHeader + 10, 6); // Empty
+	memcpy(retData + 16, mapauthor.constData(), 8); // mapAuthor
+	memcpy(retData + 24, constHeader + 24, 8); // mapName
+
+	return ret;
 }
 
 bool Section1File::exporter(QIODevice *device, ExportFormat format)
@@ -471,6 +526,18 @@ bool Section1File::isModified() const
 	return FieldPart::isModified() || (_tut && _tut->isModified());
 }
 
+void Section1File::setModified(bool modified)
+{
+	if(modified) {
+		++_revision;
+		FieldArchive *archive = field()->io() ? field()->io()->fieldArchive() : 0;
+		if(archive) {
+			archive->setScriptsModified(field());
+		}
+	}
+	FieldPart::setModified(modified);
+}
+
 int Section1File::modelID(quint8 grpScriptID) const
 {
 	if(_grpScripts.at(grpScriptID)->typeID() != GrpScript::Model)	return -1;
@@ -817,6 +884,36 @@ bool Section1File::compileScripts(int &groupID, int &scriptID, int &opcodeID, QS
 	return true;
 }
 
+/*!
+ * Compiles every script without stopping at the first error.
+ * Also checks that the scripts fit in the section.
+ */
+bool Section1File::compileScripts(QList<ScriptCompileError> &errors)
+{
+	const int errorCount = errors.size();
+	quint32 size = 0;
+	int groupID=0;
+
+	foreach(GrpScript *group, _grpScripts) {
+		int firstError = errors.size();
+		quint32 groupSize;
+		group->compile(errors, &groupSize);
+		for(int i=firstError ; i<errors.size() ; ++i) {
+			errors[i].groupID = groupID;
+		}
+		size += groupSize;
+		++groupID;
+	}
+
+	const int available = availableBytesForScripts();
+	if(int(size) > available) {
+		errors.append(ScriptCompileError(-1, QObject::tr("Scripts too big: %1 bytes used, %2 available.")
+		                                 .arg(size).arg(available)));
+	}
+
+	return errors.size() == errorCount;
+}
+
 void Section1File::removeTexts()
 {
 	foreach(GrpScript *group, _grpScripts) {
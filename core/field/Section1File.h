@@ -24,6 +24,8 @@
 #include "../FF7Text.h"
 #include "TutFileStandard.h"
 
+//#define SECTION1FILE_DEBUG // Checks that a saved section reopens and saves identically
+
 class GrpScriptsIterator : public QListIterator<GrpScript *>
 {
 public:
@@ -67,6 +69,11 @@ public:
 	bool exporter(QIODevice *device, ExportFormat format);
 	bool importer(QIODevice *device, ExportFormat format);
 	bool isModified() const;
+	void setModified(bool modified);
+	// Changes when scripts, texts or group names are modified
+	inline quint32 revision() const {
+		return _revision;
+	}
 
 	int modelID(quint8 grpScriptID) const;
 	void bgParamAndBgMove(QHash<quint8, quint8> &paramActifs, qint16 *z=0, qint16 *x=0, qint16 *y=0) const;
@@ -102,6 +109,7 @@ public:
 
 	void shiftTutIds(int row, int shift);
 	bool compileScripts(int &groupID, int &scriptID, int &opcodeID, QString &errorStr);
+	bool compileScripts(QList<ScriptCompileError> &errors);
 	void removeTexts();
 	void cleanTexts();
 
@@ -128,6 +136,8 @@ public:
 
 	int availableBytesForScripts() const;
 private:
+	QByteArray save(const QByteArray &data) const;
+
 	QString _author;
 	quint16 _scale;
 	// quint8 nbObjets3D;
@@ -135,6 +145,7 @@ private:
 	QList<GrpScript *> _grpScripts;
 	QList<FF7Text> _texts;
 	TutFileStandard *_tut;
+	quint32 _revision;
 };
 
 #endif // SECTION1FILE_H
@@ -107,15 +107,13 @@ QImage TdbFile::texture(quint8 faceID, TextureType type)
 
 	QImage img(32, 32, QImage::Format_ARGB32);
 	QRgb *px = (QRgb *)img.bits();
+	QRgb palette[16];
+	PsColor::fromPsColors(constData + offsetPalette, 16, palette, true);
 
 	for(int i=0 ; i<512 ; ++i) {
 		quint8 index = constData[offsetImage + i];
-		quint16 color;
-		memcpy(&color, constData + offsetPalette + (index & 0x0F)*2, 2);
-		px[i*2] = PsColor::fromPsColor(color, true);
-
-		memcpy(&color, constData + offsetPalette + (index >> 4)*2, 2);
-		px[i*2+1] = PsColor::fromPsColor(color, true);
+		px[i*2] = palette[index & 0x0F];
+		px[i*2+1] = palette[index >> 4];
 	}
 
 	return img;
@@ -0,0 +1,300 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "WalkmeshGrid.h"
+#include "IdFile.h"
+#include <cfloat>
+#include <cmath>
+
+WalkmeshGrid::WalkmeshGrid() :
+	_minX(0), _minY(0), _cellSize(1), _cols(0), _rows(0)
+{
+}
+
+void WalkmeshGrid::clear()
+{
+	_minX = _minY = 0;
+	_cellSize = 1;
+	_cols = _rows = 0;
+	_cellStart.clear();
+	_items.clear();
+}
+
+static void triangleBounds(const Triangle &triangle, int &minX, int &minY,
+                           int &maxX, int &maxY)
+{
+	minX = maxX = triangle.vertices[0].x;
+	minY = maxY = triangle.vertices[0].y;
+	for(int i=1 ; i<3 ; ++i) {
+		minX = qMin(minX, int(triangle.vertices[i].x));
+		minY = qMin(minY, int(triangle.vertices[i].y));
+		maxX = qMax(maxX, int(triangle.vertices[i].x));
+		maxY = qMax(maxY, int(triangle.vertices[i].y));
+	}
+}
+
+void WalkmeshGrid::build(const QList<Triangle> &triangles)
+{
+	clear();
+
+	const int count = triangles.size();
+	if(count == 0) {
+		return;
+	}
+
+	int minX, minY, maxX, maxY;
+	triangleBounds(triangles.first(), minX, minY, maxX, maxY);
+	foreach(const Triangle &triangle, triangles) {
+		int tMinX, tMinY, tMaxX, tMaxY;
+		triangleBounds(triangle, tMinX, tMinY, tMaxX, tMaxY);
+		minX = qMin(minX, tMinX);
+		minY = qMin(minY, tMinY);
+		maxX = qMax(maxX, tMaxX);
+		maxY = qMax(maxY, tMaxY);
+	}
+
+	const int width = maxX - minX + 1, height = maxY - minY + 1;
+
+	// About one triangle per cell
+	_minX = minX;
+	_minY = minY;
+	_cellSize = qMax(1, int(std::ceil(std::sqrt(double(width) * double(height) / count))));
+	_cols = width / _cellSize + 1;
+	_rows = height / _cellSize + 1;
+
+	// First pass: count triangles per cell
+	_cellStart.fill(0, _cols * _rows + 1);
+	int *cellStart = _cellStart.data();
+	foreach(const Triangle &triangle, triangles) {
+		int tMinX, tMinY, tMaxX, tMaxY;
+		triangleBounds(triangle, tMinX, tMinY, tMaxX, tMaxY);
+		const int cx0 = (tMinX - _minX) / _cellSize, cx1 = (tMaxX - _minX) / _cellSize,
+		        cy0 = (tMinY - _minY) / _cellSize, cy1 = (tMaxY - _minY) / _cellSize;
+		for(int cy=cy0 ; cy<=cy1 ; ++cy) {
+			for(int cx=cx0 ; cx<=cx1 ; ++cx) {
+				cellStart[cellIndex(cx, cy) + 1] += 1;
+			}
+		}
+	}
+
+	for(int i=1 ; i<_cellStart.size() ; ++i) {
+		cellStart[i] += cellStart[i - 1];
+	}
+
+	// Second pass: fill cells, triangle IDs stay sorted in each cell
+	_items.resize(cellStart[_cellStart.size() - 1]);
+	QVector<int> cursor(_cellStart);
+	int *items = _items.data(), *cur = cursor.data(), triangleID = 0;
+	foreach(const Triangle &triangle, triangles) {
+		int tMinX, tMinY, tMaxX, tMaxY;
+		triangleBounds(triangle, tMinX, tMinY, tMaxX, tMaxY);
+		const int cx0 = (tMinX - _minX) / _cellSize, cx1 = (tMaxX - _minX) / _cellSize,
+		        cy0 = (tMinY - _minY) / _cellSize, cy1 = (tMaxY - _minY) / _cellSize;
+		for(int cy=cy0 ; cy<=cy1 ; ++cy) {
+			for(int cx=cx0 ; cx<=cx1 ; ++cx) {
+				items[cur[cellIndex(cx, cy)]++] = triangleID;
+			}
+		}
+		++triangleID;
+	}
+}
+
+bool WalkmeshGrid::contains(const Triangle &triangle, int x, int y)
+{
+	const Vertex_sr &a = triangle.vertices[0],
+	        &b = triangle.vertices[1],
+	        &c = triangle.vertices[2];
+
+	const qint64 area = qint64(b.x - a.x) * (c.y - a.y) - qint64(b.y - a.y) * (c.x - a.x);
+	if(area == 0) {
+		return false; // Degenerated
+	}
+
+	const qint64 d1 = qint64(b.x - a.x) * (y - a.y) - qint64(b.y - a.y) * (x - a.x),
+	        d2 = qint64(c.x - b.x) * (y - b.y) - qint64(c.y - b.y) * (x - b.x),
+	        d3 = qint64(a.x - c.x) * (y - c.y) - qint64(a.y - c.y) * (x - c.x);
+
+	// Both windings are accepted
+	return !((d1 < 0 || d2 < 0 || d3 < 0) && (d1 > 0 || d2 > 0 || d3 > 0));
+}
+
+bool WalkmeshGrid::intersect(const Triangle &triangle,
+                             const QVector3D &origin, const QVector3D &direction,
+                             float &distance)
+{
+	const QVector3D v0(triangle.vertices[0].x, triangle.vertices[0].y, triangle.vertices[0].z),
+	        v1(triangle.vertices[1].x, triangle.vertices[1].y, triangle.vertices[1].z),
+	        v2(triangle.vertices[2].x, triangle.vertices[2].y, triangle.vertices[2].z);
+	const QVector3D e1 = v1 - v0, e2 = v2 - v0;
+	const QVector3D p = QVector3D::crossProduct(direction, e2);
+	const float det = QVector3D::dotProduct(e1, p);
+
+	if(qFuzzyIsNull(det)) {
+		return false; // Parallel or degenerated
+	}
+
+	const float invDet = 1.0f / det;
+	const QVector3D s = origin - v0;
+	const float u = QVector3D::dotProduct(s, p) * invDet;
+	if(u < 0.0f || u > 1.0f) {
+		return false;
+	}
+
+	const QVector3D q = QVector3D::crossProduct(s, e1);
+	const float v = QVector3D::dotProduct(direction, q) * invDet;
+	if(v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+
+	const float t = QVector3D::dotProduct(e2, q) * invDet;
+	if(t < 0.0f) {
+		return false;
+	}
+
+	distance = t;
+
+	return true;
+}
+
+int WalkmeshGrid::findTriangle(const QList<Triangle> &triangles, int x, int y) const
+{
+	if(isEmpty()
+	        || x < _minX || x >= _minX + _cols * _cellSize
+	        || y < _minY || y >= _minY + _rows * _cellSize) {
+		return -1;
+	}
+
+	const int cell = cellIndex((x - _minX) / _cellSize, (y - _minY) / _cellSize);
+	const int *items = _items.constData();
+
+	for(int i=_cellStart.at(cell) ; i<_cellStart.at(cell + 1) ; ++i) {
+		if(contains(triangles.at(items[i]), x, y)) {
+			return items[i];
+		}
+	}
+
+	return -1;
+}
+
+int WalkmeshGrid::pickInCell(const QList<Triangle> &triangles, int cell,
+                             const QVector3D &origin, const QVector3D &direction,
+                             float &distance) const
+{
+	const int *items = _items.constData();
+	int ret = -1;
+
+	for(int i=_cellStart.at(cell) ; i<_cellStart.at(cell + 1) ; ++i) {
+		float t;
+		if(intersect(triangles.at(items[i]), origin, direction, t)
+		        && (ret < 0 || t < distance)) {
+			distance = t;
+			ret = items[i];
+		}
+	}
+
+	return ret;
+}
+
+/*!
+ * Returns the first triangle hit by the ray origin + t * direction (t >= 0),
+ * walking the grid cells crossed by the ray in order, or -1.
+ */
+int WalkmeshGrid::pickTriangle(const QList<Triangle> &triangles,
+                               const QVector3D &origin, const QVector3D &direction,
+                               float *distance) const
+{
+	if(isEmpty()) {
+		return -1;
+	}
+
+	const float o[2] = { float(origin.x()), float(origin.y()) },
+	        d[2] = { float(direction.x()), float(direction.y()) },
+	        lo[2] = { float(_minX), float(_minY) },
+	        hi[2] = { float(_minX + _cols * _cellSize), float(_minY + _rows * _cellSize) };
+	float tEnter = 0.0f, tExit = FLT_MAX;
+
+	// Clip the ray to the grid bounds
+	for(int axis=0 ; axis<2 ; ++axis) {
+		if(qFuzzyIsNull(d[axis])) {
+			if(o[axis] < lo[axis] || o[axis] >= hi[axis]) {
+				return -1;
+			}
+		} else {
+			float t0 = (lo[axis] - o[axis]) / d[axis],
+			        t1 = (hi[axis] - o[axis]) / d[axis];
+			if(t0 > t1) {
+				qSwap(t0, t1);
+			}
+			tEnter = qMax(tEnter, t0);
+			tExit = qMin(tExit, t1);
+		}
+	}
+
+	if(tEnter > tExit) {
+		return -1;
+	}
+
+	const int size[2] = { _cols, _rows };
+	int cell[2], step[2];
+	float tMax[2], tDelta[2];
+
+	for(int axis=0 ; axis<2 ; ++axis) {
+		const float start = o[axis] + d[axis] * tEnter;
+		cell[axis] = qBound(0, int((start - lo[axis]) / _cellSize), size[axis] - 1);
+		if(qFuzzyIsNull(d[axis])) {
+			step[axis] = 0;
+			tMax[axis] = tDelta[axis] = FLT_MAX;
+		} else {
+			step[axis] = d[axis] > 0.0f ? 1 : -1;
+			const float boundary = lo[axis] + (cell[axis] + (step[axis] > 0 ? 1 : 0)) * _cellSize;
+			tMax[axis] = (boundary - o[axis]) / d[axis];
+			tDelta[axis] = _cellSize / qAbs(d[axis]);
+		}
+	}
+
+	int ret = -1;
+	float best = FLT_MAX;
+
+	forever {
+		float t;
+		const int triangleID = pickInCell(triangles, cellIndex(cell[0], cell[1]),
+		                                  origin, direction, t);
+		if(triangleID >= 0 && t < best) {
+			best = t;
+			ret = triangleID;
+		}
+
+		const float cellExit = qMin(tMax[0], tMax[1]);
+		// Every hit farther than this cell will be found in the next cells
+		if((ret >= 0 && best <= cellExit) || cellExit >= tExit) {
+			break;
+		}
+
+		const int axis = tMax[0] < tMax[1] ? 0 : 1;
+		cell[axis] += step[axis];
+		if(cell[axis] < 0 || cell[axis] >= size[axis]) {
+			break;
+		}
+		tMax[axis] += tDelta[axis];
+	}
+
+	if(ret >= 0 && distance) {
+		*distance = best;
+	}
+
+	return ret;
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2015 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef WALKMESHGRID_H
+#define WALKMESHGRID_H
+
+#include <QtCore>
+#include <QVector3D>
+
+struct Triangle;
+
+/*
+ * Uniform 2D grid over the XY bounding boxes of the walkmesh triangles.
+ * Each cell lists the triangles overlapping it (packed in one array).
+ */
+class WalkmeshGrid
+{
+public:
+	WalkmeshGrid();
+	void build(const QList<Triangle> &triangles);
+	void clear();
+	inline bool isEmpty() const {
+		return _cellStart.isEmpty();
+	}
+	int findTriangle(const QList<Triangle> &triangles, int x, int y) const;
+	int pickTriangle(const QList<Triangle> &triangles,
+	                 const QVector3D &origin, const QVector3D &direction,
+	                 float *distance = 0) const;
+	static bool contains(const Triangle &triangle, int x, int y);
+	static bool intersect(const Triangle &triangle,
+	                      const QVector3D &origin, const QVector3D &direction,
+	                      float &distance);
+private:
+	inline int cellIndex(int cellX, int cellY) const {
+		return cellY * _cols + cellX;
+	}
+	int pickInCell(const QList<Triangle> &triangles, int cell,
+	               const QVector3D &origin, const QVector3D &direction,
+	               float &distance) const;
+	int _minX, _minY, _cellSize, _cols, _rows;
+	QVector<int> _cellStart; // _cols * _rows + 1 entries
+	QVector<int> _items;
+};
+
+#endif // WALKMESHGRID_H
@@ -17,16 +17,13 @@
  ****************************************************************************/
 #include <QApplication>
 #include "Window.h"
+#include "BatchRunner.h"
 #include "core/Var.h"
 #include "core/Config.h"
 #include "Data.h"
 
-int main(int argc, char *argv[])
+static void init(QCoreApplication *app)
 {
-	QGLFormat::setDefaultFormat(QGLFormat(QGL::DirectRendering));
-
-	QApplication app(argc, argv);
-	app.setWindowIcon(QIcon(":/images/logo-shinra.png"));
 #if (QT_VERSION < QT_VERSION_CHECK(5, 0, 0))
 	QTextCodec::setCodecForTr(QTextCodec::codecForName("UTF-8"));
 #endif
@@ -35,16 +32,41 @@ int main(int argc, char *argv[])
 
 	QString lang = QLocale::system().name().toLower();
 	lang = Config::value("lang", lang.left(lang.indexOf("_"))).toString();
-	QTranslator translator1;
-	if(translator1.load("qt_" % lang, app.applicationDirPath()) || translator1.load("qt_" % lang, QLibraryInfo::location(QLibraryInfo::TranslationsPath)))
-		app.installTranslator(&translator1);
-	QTranslator translator2;
-	if(translator2.load("Makou_Reactor_" % lang, Config::programResourceDir())) {
-		app.installTranslator(&translator2);
+	QTranslator *translator1 = new QTranslator(app);
+	if(translator1->load("qt_" % lang, app->applicationDirPath()) || translator1->load("qt_" % lang, QLibraryInfo::location(QLibraryInfo::TranslationsPath)))
+		app->installTranslator(translator1);
+	QTranslator *translator2 = new QTranslator(app);
+	if(translator2->load("Makou_Reactor_" % lang, Config::programResourceDir())) {
+		app->installTranslator(translator2);
 		Config::setValue("lang", lang);
 	} else {
 		Config::setValue("lang", "en");
 	}
+}
+
+int main(int argc, char *argv[])
+{
+	// Headless mode: no window, JSON output
+	if(argc > 1 && qstrcmp(argv[1], "--batch") == 0) {
+		QCoreApplication app(argc, argv);
+		init(&app);
+
+		if(!Var::load()) {
+			qWarning() << "The file 'var.cfg' could not be loaded.";
+		}
+		if(!Data::load()) {
+			qWarning() << "Error loading data!";
+		}
+
+		BatchRunner runner;
+		return runner.exec(app.arguments().mid(2));
+	}
+
+	QGLFormat::setDefaultFormat(QGLFormat(QGL::DirectRendering));
+
+	QApplication app(argc, argv);
+	app.setWindowIcon(QIcon(":/images/logo-shinra.png"));
+	init(&app);
 
 	if(!Var::load()) {
 		QMessageBox::warning(0, QObject::tr("Error"), QObject::tr("The file 'var.cfg' could not be loaded.\nMake sure it is valid or delete it."));
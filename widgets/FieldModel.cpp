@@ -17,10 +17,163 @@
  ****************************************************************************/
 #include "FieldModel.h"
 #include "core/field/FieldModelFilePS.h"
+#include <cstddef>
+
+#define FIELD_MODEL_GL_CACHE_SIZE	64
+
+FieldModelGLBuffers::FieldModelGLBuffers(QGLWidget *glWidget,
+                                         const FieldModelMesh &mesh) :
+	_glWidget(glWidget), _vertexBuffer(QGLBuffer::VertexBuffer),
+	_indexBuffer(QGLBuffer::IndexBuffer), _useBuffers(false),
+	_indexBase(0), _currentTexture(-1)
+{
+	// Falls back to client-side arrays if VBOs are not supported
+	if(_vertexBuffer.create() && _indexBuffer.create()) {
+		_vertexBuffer.bind();
+		_vertexBuffer.allocate(mesh.vertices().constData(),
+		                       mesh.vertices().size() * sizeof(FieldModelMeshVertex));
+		_vertexBuffer.release();
+		_indexBuffer.bind();
+		_indexBuffer.allocate(mesh.indices().constData(),
+		                      mesh.indices().size() * sizeof(quint32));
+		_indexBuffer.release();
+		_useBuffers = true;
+	}
+
+	foreach(const QImage &image, mesh.textures()) {
+		// Detached copy: the texture is owned by this object only
+		QImage copy = image.copy();
+		_images.append(copy);
+		_textures.append(glWidget->bindTexture(copy, GL_TEXTURE_2D, GL_RGBA,
+		                                       QGLContext::MipmapBindOption));
+	}
+}
+
+FieldModelGLBuffers::~FieldModelGLBuffers()
+{
+	foreach(GLuint texture, _textures) {
+		_glWidget->deleteTexture(texture);
+	}
+	_vertexBuffer.destroy();
+	_indexBuffer.destroy();
+}
+
+void FieldModelGLBuffers::bind(const FieldModelMesh &mesh)
+{
+	const char *vertexBase;
+
+	if(_useBuffers) {
+		_vertexBuffer.bind();
+		_indexBuffer.bind();
+		vertexBase = 0;
+		_indexBase = 0;
+	} else {
+		vertexBase = (const char *)mesh.vertices().constData();
+		_indexBase = mesh.indices().constData();
+	}
+
+	const GLsizei stride = sizeof(FieldModelMeshVertex);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, stride,
+	                vertexBase + offsetof(FieldModelMeshVertex, x));
+	glEnableClientState(GL_COLOR_ARRAY);
+	glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+	               vertexBase + offsetof(FieldModelMeshVertex, r));
+	glTexCoordPointer(2, GL_FLOAT, stride,
+	                  vertexBase + offsetof(FieldModelMeshVertex, u));
+	_currentTexture = -1;
+}
+
+void FieldModelGLBuffers::drawBone(const FieldModelMesh &mesh, int boneID)
+{
+	const FieldModelMeshBone &bone = mesh.bone(boneID);
+
+	for(int i=bone.firstGroup ; i<bone.firstGroup + bone.groupCount ; ++i) {
+		const FieldModelMeshGroup &group = mesh.groups().at(i);
+
+		if(group.texture != _currentTexture) {
+			if(group.texture < 0) {
+				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+				glDisable(GL_TEXTURE_2D);
+			} else {
+				if(_currentTexture < 0) {
+					glEnable(GL_TEXTURE_2D);
+					glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+				}
+				glBindTexture(GL_TEXTURE_2D, _textures.at(group.texture));
+			}
+			_currentTexture = group.texture;
+		}
+
+		glDrawElements(GL_TRIANGLES, group.indexCount, GL_UNSIGNED_INT,
+		               _indexBase + group.firstIndex);
+	}
+}
+
+void FieldModelGLBuffers::release()
+{
+	if(_currentTexture >= 0) {
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glDisable(GL_TEXTURE_2D);
+		_currentTexture = -1;
+	}
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if(_useBuffers) {
+		_vertexBuffer.release();
+		_indexBuffer.release();
+	}
+}
+
+FieldModelGLCache::FieldModelGLCache(QGLWidget *glWidget) :
+	_glWidget(glWidget)
+{
+}
+
+FieldModelGLCache::~FieldModelGLCache()
+{
+	clear();
+}
+
+/*!
+ * Releases all GPU resources, the GL context of the
+ * widget must be current.
+ */
+void FieldModelGLCache::clear()
+{
+	qDeleteAll(_buffers);
+	_buffers.clear();
+	_serials.clear();
+}
+
+/*!
+ * Returns the GPU resources for \a mesh, uploaded on the
+ * first call. The oldest meshes are released when the cache
+ * is full.
+ */
+FieldModelGLBuffers *FieldModelGLCache::buffers(const FieldModelMesh &mesh)
+{
+	FieldModelGLBuffers *ret = _buffers.value(mesh.serial());
+	if(ret) {
+		return ret;
+	}
+
+	if(_serials.size() >= FIELD_MODEL_GL_CACHE_SIZE) {
+		delete _buffers.take(_serials.takeFirst());
+	}
+
+	ret = new FieldModelGLBuffers(_glWidget, mesh);
+	_buffers.insert(mesh.serial(), ret);
+	_serials.append(mesh.serial());
+
+	return ret;
+}
 
 FieldModel::FieldModel(QWidget *parent, const QGLWidget *shareWidget) :
 	QGLWidget(parent, shareWidget), blockAll(false), distance(-0.25/*-35*/),
-	animationID(0), currentFrame(0), animated(true), data(0),
+	animationID(0), currentFrame(0), animated(true), data(0), cache(this),
 	xRot(270*16), yRot(90*16), zRot(0)
 {
 	connect(&timer, SIGNAL(timeout()), SLOT(animate()));
@@ -28,6 +181,8 @@ FieldModel::FieldModel(QWidget *parent, const QGLWidget *shareWidget) :
 
 FieldModel::~FieldModel()
 {
+	makeCurrent();
+	cache.clear();
 }
 
 void FieldModel::clear()
@@ -104,87 +259,33 @@ void FieldModel::initializeGL()
 //	gluPerspective(70, (double)width()/(double)height(), 0.001, 1000.0);
 }
 
-void FieldModel::drawP(QGLWidget *glWidget, FieldModelFile *data, float scale,
-                       const FieldModelBone &bone,
-                       GLuint &texture_id, quint64 &lastTexID,
-                       float globalColor[3])
+// QMatrix4x4 stores qreal with Qt 4 and float with Qt 5
+template<typename T>
+static void toGLMatrix(const T *data, GLfloat m[16])
 {
-	if (scale == 0.0f) {
-		return;
+	for (int i = 0 ; i < 16 ; ++i) {
+		m[i] = data[i];
 	}
+}
 
-	foreach(FieldModelPart *part, bone.parts()) {
-
-		foreach(FieldModelGroup *g, part->groups()) {
-			if(g->hasTexture()) {
-				if(texture_id != (GLuint)-1) {
-					glWidget->deleteTexture(texture_id);
-				} else {
-					glEnable(GL_TEXTURE_2D);
-				}
-				texture_id = glWidget->bindTexture(data->loadedTexture(g),
-				                                   GL_TEXTURE_2D, GL_RGBA,
-				                                   QGLContext::MipmapBindOption);
-			} else if(!g->hasTexture() && texture_id != (GLuint)-1) {
-				glWidget->deleteTexture(texture_id);
-				glDisable(GL_TEXTURE_2D);
-				texture_id = -1;
-				lastTexID = quint64(-1);
-			}
-
-			int curPolyType = 0;
-
-			foreach(const Poly *p, g->polygons()) {
-				if(curPolyType != p->count()) {
-					if(curPolyType != 0) {
-						glEnd();
-					}
-
-					if(p->count() == 3) {
-						glBegin(GL_TRIANGLES);
-					} else {
-						glBegin(GL_QUADS);
-					}
-					curPolyType = p->count();
-				}
+void FieldModel::drawP(FieldModelGLBuffers *buffers, const FieldModelMesh &mesh,
+                       int boneID, const QMatrix4x4 *matrix)
+{
+	if (boneID >= mesh.boneCount()) {
+		return;
+	}
 
-				if(p->isMonochrome()) {
-					const QRgb &color = p->color();
-					glColor3ub(qRed(color) * globalColor[0],
-					           qGreen(color) * globalColor[1],
-					           qBlue(color) * globalColor[2]);
-				}
+	if (matrix) {
+		GLfloat m[16];
+		toGLMatrix(matrix->constData(), m);
+		glPushMatrix();
+		glMultMatrixf(m);
+	}
 
-				for(quint16 j=0 ; j<(quint8)p->count() ; ++j) {
-					const PolyVertex &vertex = p->vertex(j);
-
-					if(!p->isMonochrome()) {
-						QRgb color = p->color(j);
-						// TODO: color projector effect
-						/* float spot = qMax(vertex.x * 0.0f + vertex.y * 0.0f + (1.0 - (vertex.z/scale)) * -1.0f, 0.0f);
-						if (spot >= qCos(180.0)) {
-							spot = 1.0;
-						} else {
-							spot = qPow(spot, 0.0);
-						} */
-						glColor3ub(qRed(color) * globalColor[0],
-						           qGreen(color) * globalColor[1],
-						           qBlue(color) * globalColor[2]);
-					}
-
-					if(g->hasTexture() && p->hasTexture()) {
-						const TexCoord &coord = p->texCoord(j);
-						glTexCoord2d(coord.x, coord.y);
-					}
-
-					glVertex3f(vertex.x/scale, vertex.y/scale, vertex.z/scale);
-				}
-			}
+	buffers->drawBone(mesh, boneID);
 
-			if(curPolyType != 0) {
-				glEnd();
-			}
-		}
+	if (matrix) {
+		glPopMatrix();
 	}
 }
 
@@ -263,82 +364,43 @@ void FieldModel::resizeGL(int width, int height)
 	glMatrixMode(GL_MODELVIEW);
 }
 
-void FieldModel::paintModel(QGLWidget *glWidget, FieldModelFile *data,
+void FieldModel::paintModel(FieldModelGLCache &cache, FieldModelFile *data,
                             int animationID, int currentFrame, float scale)
 {
 	if(!data || !data->isValid() || scale == 0.0f) {
 		return;
 	}
 
-	float globalColor[] = { 1.0f, 1.0f, 1.0f };
-
-	/* if(!data->translateAfter()) { // TODO: for PC too
-		FieldModelFilePS *filePS = static_cast<FieldModelFilePS *>(data);
-		globalColor[0] = qRed(filePS->globalColor()) / 255.0f;
-		globalColor[1] = qGreen(filePS->globalColor()) / 255.0f;
-		globalColor[2] = qBlue(filePS->globalColor()) / 255.0f;
-	} */
-
-	QStack<int> parent;
-	int i;
-	GLuint texture_id = -1;
-	quint64 lastTexID = quint64(-1);
-
-	if(data->boneCount() <= 1) {
-		drawP(glWidget, data, scale, data->bone(0), texture_id, lastTexID,
-		      globalColor);
-		if(texture_id != (GLuint)-1) {
-			glWidget->deleteTexture(texture_id);
-			glDisable(GL_TEXTURE_2D);
-		}
-		return;
-	}
-
-	if (animationID >= data->animationCount()) {
+	const FieldModelMesh &mesh = data->mesh();
+	if(mesh.isEmpty()) {
 		return;
 	}
 
-	QList<PolyVertex> rot = data->animation(animationID).rotations(currentFrame);
-	parent.push(-1);
-
-	for(i = 0 ; i < data->boneCount() ; ++i) {
-		const FieldModelBone &bone = data->bone(i);
+	const QMatrix4x4 *matrices = 0;
 
-		while(!parent.isEmpty() && parent.top() != bone.parent()) {
-			parent.pop();
-			glPopMatrix();
-		}
-		parent.push(i);
-		glPushMatrix();
-
-		if(!data->translateAfter()) {
-			glTranslatef(0.0, 0.0, bone.size() / scale);
+	if(data->boneCount() > 1) {
+		matrices = data->boneMatrices(animationID, currentFrame);
+		if(!matrices) {
+			return;
 		}
+	}
 
-		if (i < rot.size()) {
-			const PolyVertex &rotation = rot.at(i);
-			glRotatef(rotation.y, 0.0, 1.0, 0.0);
-			glRotatef(rotation.x, 1.0, 0.0, 0.0);
-			glRotatef(rotation.z, 0.0, 0.0, 1.0);
-		}
+	FieldModelGLBuffers *buffers = cache.buffers(mesh);
 
-		drawP(glWidget, data, scale, bone, texture_id, lastTexID,
-		      globalColor);
+	glPushMatrix();
+	glScalef(1.0f / scale, 1.0f / scale, 1.0f / scale);
+	buffers->bind(mesh);
 
-		if(data->translateAfter()) {
-			glTranslatef(0.0, 0.0, bone.size() / scale);
+	if(!matrices) {
+		drawP(buffers, mesh, 0, 0);
+	} else {
+		for(int i = 0 ; i < data->boneCount() ; ++i) {
+			drawP(buffers, mesh, i, matrices + i);
 		}
 	}
 
-	if(texture_id != (GLuint)-1) {
-		glWidget->deleteTexture(texture_id);
-		glDisable(GL_TEXTURE_2D);
-	}
-
-	while(!parent.isEmpty() && parent.top() != -1) {
-		parent.pop();
-		glPopMatrix();
-	}
+	buffers->release();
+	glPopMatrix();
 }
 
 void FieldModel::paintGL()
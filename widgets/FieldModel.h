@@ -20,6 +20,7 @@
 
 #include <QtWidgets>
 #include <QGLWidget>
+#include <QGLBuffer>
 #ifdef Q_OS_MAC
 #include <OpenGL/glu.h>
 #else
@@ -28,6 +29,41 @@
 #include "core/field/FieldModelFile.h"
 #include "core/field/FieldPC.h"
 
+// GPU copy of a FieldModelMesh
+class FieldModelGLBuffers
+{
+public:
+	FieldModelGLBuffers(QGLWidget *glWidget, const FieldModelMesh &mesh);
+	~FieldModelGLBuffers();
+	void bind(const FieldModelMesh &mesh);
+	void drawBone(const FieldModelMesh &mesh, int boneID);
+	void release();
+private:
+	Q_DISABLE_COPY(FieldModelGLBuffers)
+	QGLWidget *_glWidget;
+	QGLBuffer _vertexBuffer, _indexBuffer;
+	bool _useBuffers;
+	const quint32 *_indexBase;
+	QList<QImage> _images;
+	QList<GLuint> _textures;
+	int _currentTexture;
+};
+
+// GPU resources of the last drawn meshes, for one GL context
+class FieldModelGLCache
+{
+public:
+	explicit FieldModelGLCache(QGLWidget *glWidget);
+	~FieldModelGLCache();
+	void clear();
+	FieldModelGLBuffers *buffers(const FieldModelMesh &mesh);
+private:
+	Q_DISABLE_COPY(FieldModelGLCache)
+	QGLWidget *_glWidget;
+	QHash<quint32, FieldModelGLBuffers *> _buffers;
+	QList<quint32> _serials;
+};
+
 class FieldModel : public QGLWidget
 {
 	Q_OBJECT
@@ -39,16 +75,16 @@ public:
 	void clear();
 	int boneCount() const;
 	int frameCount() const;
-	static void paintModel(QGLWidget *glWidget, FieldModelFile *data, int animationID, int currentFrame=0, float scale=1.0f);
+	static void paintModel(FieldModelGLCache &cache, FieldModelFile *data, int animationID, int currentFrame=0, float scale=1.0f);
 public slots:
 	void setFieldModelFile(FieldModelFile *fieldModel, int animationID = 0);
 private slots:
 	void animate();
 private:
 	void updateTimer();
-	inline void paintModel() { paintModel(this, data, animationID, currentFrame); }
-	static void drawP(QGLWidget *glWidget, FieldModelFile *data, float scale, const FieldModelBone &bone,
-					  GLuint &texture_id, quint64 &lastTexID, float globalColor[3]);
+	inline void paintModel() { paintModel(cache, data, animationID, currentFrame); }
+	static void drawP(FieldModelGLBuffers *buffers, const FieldModelMesh &mesh,
+	                  int boneID, const QMatrix4x4 *matrix);
 	void setXRotation(int angle);
 	void setYRotation(int angle);
 	void setZRotation(int angle);
@@ -61,6 +97,7 @@ private:
 	bool animated;
 
 	FieldModelFile *data;
+	FieldModelGLCache cache;
 	QTimer timer;
 
 	int xRot;
@@ -240,6 +240,7 @@ void GrpScriptList::renameOK(QTreeWidgetItem *item, int column)
 	QString newName = item->text(1).left(8);
 	item->setText(1, newName);
 	scripts->grpScript(selectedID())->setName(newName);
+	scripts->setModified(true);
 	emit changed();
 }
 
@@ -691,6 +691,7 @@ LgpDialog::LgpDialog(Lgp *lgp, QWidget *parent) :
 	replaceButton->setShortcut(QKeySequence("Ctrl+R"));
 	extractButton = new QPushButton(tr("Extract"), this);
 	extractButton->setShortcut(QKeySequence("Ctrl+E"));
+	extractAllButton = new QPushButton(tr("Extract All"), this);
 	addButton = new QPushButton(QIcon(":/images/plus.png"), tr("Add"), this);
 	addButton->setShortcut(QKeySequence::New);
 	removeButton = new QPushButton(QIcon(":/images/minus.png"), tr("Delete"), this);
@@ -703,6 +704,7 @@ LgpDialog::LgpDialog(Lgp *lgp, QWidget *parent) :
 	barLayout->addWidget(renameButton);
 	barLayout->addWidget(replaceButton);
 	barLayout->addWidget(extractButton);
+	barLayout->addWidget(extractAllButton);
 	barLayout->addWidget(addButton);
 	barLayout->addWidget(removeButton);
 	barLayout->addWidget(packButton);
@@ -715,6 +717,7 @@ LgpDialog::LgpDialog(Lgp *lgp, QWidget *parent) :
 	connect(renameButton, SIGNAL(released()), SLOT(renameCurrent()));
 	connect(replaceButton, SIGNAL(released()), SLOT(replaceCurrent()));
 	connect(extractButton, SIGNAL(released()), SLOT(extractCurrent()));
+	connect(extractAllButton, SIGNAL(released()), SLOT(extractAll()));
 	connect(addButton, SIGNAL(released()), SLOT(add()));
 	connect(removeButton, SIGNAL(released()), SLOT(removeCurrent()));
 	connect(packButton, SIGNAL(released()), SLOT(pack()));
@@ -840,6 +843,32 @@ void LgpDialog::extractCurrent()
 	}
 }
 
+void LgpDialog::extractAll()
+{
+	QString dirPath = QFileDialog::getExistingDirectory(this, tr("Extract All"), Config::value("lgpDialogSaveDirectory").toString());
+	if(dirPath.isNull()) {
+		return;
+	}
+
+	Config::setValue("lgpDialogSaveDirectory", dirPath);
+
+	progressDialog = new QProgressDialog(tr("Extracting..."), tr("Cancel"), 0, 0, this, Qt::Dialog | Qt::WindowCloseButtonHint);
+	progressDialog->setWindowModality(Qt::WindowModal);
+	progressDialog->setAutoClose(false);
+	progressDialog->show();
+
+	bool ok = lgp->extractAll(dirPath, this);
+
+	progressDialog->hide();
+	progressDialog->deleteLater();
+	progressDialog = 0;
+
+	if(!ok && lgp->error() != Lgp::AbortError) {
+		QMessageBox::warning(this, tr("Error"), tr("Cannot extract the archive (message: %1).")
+							 .arg(lgp->errorString()));
+	}
+}
+
 void LgpDialog::add()
 {
 	QString dirName;
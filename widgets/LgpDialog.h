@@ -199,6 +199,7 @@ private slots:
 	void renameCurrent();
 	void replaceCurrent();
 	void extractCurrent();
+	void extractAll();
 	void add();
 	void removeCurrent();
 	void setButtonsState();
@@ -206,7 +207,7 @@ private slots:
 private:
 	Lgp *lgp;
 	QTreeView *treeView;
-	QPushButton *extractButton, *renameButton,
+	QPushButton *extractButton, *extractAllButton, *renameButton,
 	            *replaceButton, *addButton,
 	            *removeButton, *packButton;
 	QProgressDialog *progressDialog;
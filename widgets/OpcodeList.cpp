@@ -19,10 +19,11 @@
 #include "ScriptEditor.h"
 #include "core/Config.h"
 #include "core/Clipboard.h"
+#include "core/Var.h"
 
 OpcodeList::OpcodeList(QWidget *parent) :
 	QTreeWidget(parent), isInit(false), _treeEnabled(true),
-	field(0), grpScript(0), script(0), errorLine(-1)
+	field(0), grpScript(0), script(0), opcodeTextsRevision(0), errorLine(-1)
 {
 	setColumnCount(1);
 	setHeaderLabels(QStringList(tr("Action")));
@@ -346,11 +347,20 @@ void OpcodeList::fill(Field *_field, GrpScript *_grpScript, Script *_script)
 	if(_script) {
 		saveExpandedItems();
 		clearHist();
+		opcodeTexts.clear();
 		field = _field;
 		grpScript = _grpScript;
 		script = _script;
 	}
 
+	// Texts, var names and group names are shown in opcodes
+	quint64 revision = (quint64(Var::revision()) << 32)
+	        | (field ? field->scriptsAndTexts()->revision() : 0);
+	if(revision != opcodeTextsRevision) {
+		opcodeTexts.clear();
+		opcodeTextsRevision = revision;
+	}
+
 	previousBG = QBrush();
 	blockSignals(true);
 	QTreeWidget::clear();
@@ -362,7 +372,6 @@ void OpcodeList::fill(Field *_field, GrpScript *_grpScript, Script *_script)
 		QList<QTreeWidgetItem *> items;
 		QTreeWidgetItem *parentItem = 0;
 		quint16 opcodeID = 0;
-		QPixmap fontPixmap(":/images/chiffres.png");
 
 		foreach(Opcode *curOpcode, script->opcodes()) {
 
@@ -378,13 +387,12 @@ void OpcodeList::fill(Field *_field, GrpScript *_grpScript, Script *_script)
 
 			int id = curOpcode->id();
 
-			QTreeWidgetItem *item = new QTreeWidgetItem(parentItem, QStringList(curOpcode->toString(field)));
+			QTreeWidgetItem *item = new QTreeWidgetItem(parentItem, QStringList(opcodeText(curOpcode)));
 			item->setData(0, Qt::UserRole, opcodeID);
 			item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
 			items.append(item);
 
-			QPixmap wordPixmap(32,11);
-			item->setIcon(0, QIcon(posNumber(opcodeID+1, fontPixmap, wordPixmap)));
+			item->setIcon(0, posNumber(opcodeID+1));
 			item->setToolTip(0, curOpcode->name());
 			if((id>=0x14 && id<=0x19) || (id>=0x30 && id<=0x32) || id==0xcb || id==0xcc)
 			{
@@ -561,6 +569,7 @@ void OpcodeList::undo()
 		// del opcodes
 		for(int i=hist.opcodeIDs.size()-1 ; i>=0 ; --i) {
 			hist.data.prepend(Script::copyOpcode(script->opcode(hist.opcodeIDs.at(i))));
+			invalidateText(script->opcode(hist.opcodeIDs.at(i)));
 			script->delOpcode(hist.opcodeIDs.at(i));
 		}
 		break;
@@ -573,15 +582,18 @@ void OpcodeList::undo()
 	case Modify:
 		// restore old version
 		sav = Script::copyOpcode(script->opcode(firstOpcode));
+		invalidateText(script->opcode(firstOpcode));
 		script->setOpcode(firstOpcode, hist.data.first());
 		hist.data.replace(0, sav);
 		break;
 	case ModifyAndAddLabel:
 		// del label
 		hist.data.prepend(Script::copyOpcode(script->opcode(firstOpcode+1)));
+		invalidateText(script->opcode(firstOpcode+1));
 		script->delOpcode(firstOpcode+1);
 		// restore old version
 		sav = Script::copyOpcode(script->opcode(firstOpcode));
+		invalidateText(script->opcode(firstOpcode));
 		script->setOpcode(firstOpcode, hist.data.first());
 		hist.data.replace(0, sav);
 		break;
@@ -628,16 +640,19 @@ void OpcodeList::redo()
 	case Remove:
 		for(int i=hist.opcodeIDs.size()-1 ; i>=0 ; --i) {
 			hist.data.prepend(Script::copyOpcode(script->opcode(hist.opcodeIDs.at(i))));
+			invalidateText(script->opcode(hist.opcodeIDs.at(i)));
 			script->delOpcode(hist.opcodeIDs.at(i));
 		}
 		break;
 	case Modify:
 		sav = Script::copyOpcode(script->opcode(firstOpcode));
+		invalidateText(script->opcode(firstOpcode));
 		script->setOpcode(firstOpcode, hist.data.first());
 		hist.data.replace(0, sav);
 		break;
 	case ModifyAndAddLabel:
 		sav = Script::copyOpcode(script->opcode(firstOpcode));
+		invalidateText(script->opcode(firstOpcode));
 		script->setOpcode(firstOpcode, hist.data.first());
 		hist.data.replace(0, sav);
 		script->insertOpcode(hist.opcodeIDs.at(1), hist.data.at(1));
@@ -680,6 +695,8 @@ void OpcodeList::scriptEditor(bool modify)
 
 	if(modify) {
 		oldVersion = Script::copyOpcode(script->opcode(opcodeID));
+		// The editor can modify or replace this opcode
+		invalidateText(script->opcode(opcodeID));
 	} else {
 		++opcodeID;
 	}
@@ -734,6 +751,7 @@ void OpcodeList::del(bool totalDel)
 	qSort(selectedIDs);
 	for(int i=selectedIDs.size()-1 ; i>=0 ; --i) {
 		oldVersions.prepend(Script::copyOpcode(script->opcode(selectedIDs.at(i))));
+		invalidateText(script->opcode(selectedIDs.at(i)));
 		if(totalDel) {
 			script->delOpcode(selectedIDs.at(i));
 		} else {
@@ -905,8 +923,41 @@ int OpcodeList::selectedOpcode()
 			: script->opcode(opcodeID)->id();
 }
 
-QPixmap &OpcodeList::posNumber(int num, const QPixmap &fontPixmap, QPixmap &wordPixmap)
+/*!
+ * Display string of an opcode, formatted once per script selection
+ * while the scripts, texts and var names are not modified.
+ */
+const QString &OpcodeList::opcodeText(const Opcode *opcode)
 {
+	QHash<const Opcode *, QString>::iterator it = opcodeTexts.find(opcode);
+	if(it == opcodeTexts.end()) {
+		it = opcodeTexts.insert(opcode, opcode->toString(field));
+	}
+	return it.value();
+}
+
+/*!
+ * Must be called before an opcode is modified or deleted.
+ */
+void OpcodeList::invalidateText(const Opcode *opcode)
+{
+	opcodeTexts.remove(opcode);
+}
+
+/*!
+ * Line number icon, shared by every list.
+ */
+QIcon OpcodeList::posNumber(int num)
+{
+	static QHash<int, QIcon> icons;
+
+	QHash<int, QIcon>::const_iterator it = icons.constFind(num);
+	if(it != icons.constEnd()) {
+		return it.value();
+	}
+
+	static QPixmap fontPixmap(":/images/chiffres.png");
+	QPixmap wordPixmap(32,11);
 	QString strNum = QString("%1").arg(num, 5, 10, QChar(' '));
 	wordPixmap.fill(QColor(0,0,0,0));
 	QPainter painter(&wordPixmap);
@@ -923,7 +974,10 @@ QPixmap &OpcodeList::posNumber(int num, const QPixmap &fontPixmap, QPixmap &word
 		painter.drawTiledPixmap(25, 1, 5, 9, fontPixmap, 5*strNum.mid(4,1).toInt(), 0);
 
 	painter.end();
-	return wordPixmap;
+
+	QIcon icon(wordPixmap);
+	icons.insert(num, icon);
+	return icon;
 }
 
 void OpcodeList::gotoLabel(QTreeWidgetItem *item)
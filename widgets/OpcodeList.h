@@ -99,7 +99,9 @@ private:
 	void changeHist(HistoricType type, const QList<int> &opcodeIDs, const QList<Opcode *> &data);
 	void clearHist();
 
-	static QPixmap &posNumber(int num, const QPixmap &fontPixmap, QPixmap &wordPixmap);
+	const QString &opcodeText(const Opcode *opcode);
+	void invalidateText(const Opcode *opcode);
+	static QIcon posNumber(int num);
 
 	bool hasCut, isInit, _treeEnabled;
 
@@ -110,6 +112,8 @@ private:
 	GrpScript *grpScript;
 	Script *script;
 	QHash<const Script *, QList<const Opcode *> > expandedItems;
+	QHash<const Opcode *, QString> opcodeTexts; // Cleared when the script changes
+	quint64 opcodeTextsRevision; // Var names and scripts revisions of the cache
 
 	QBrush previousBG, previousErrorBg;
 	int errorLine;
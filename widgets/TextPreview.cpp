@@ -17,6 +17,7 @@
  ****************************************************************************/
 #include "TextPreview.h"
 #include "core/FF7Text.h"
+#include "core/FF7TextLayout.h"
 #include "Data.h"
 #include "core/Config.h"
 
@@ -25,11 +26,12 @@ bool TextPreview::curFrame = true;
 int TextPreview::startMulticolor = DARKGREY;
 int TextPreview::multicolor = -1;
 int TextPreview::fontColor = WHITE;
-QImage TextPreview::fontImage;
+int TextPreview::fontImageColor = WHITE;
+QImage TextPreview::fontImages[8];
 
 TextPreview::TextPreview(QWidget *parent) :
 	QWidget(parent), _currentPage(0), _currentWin(0),
-	acceptMove(false), readOnly(false)
+	acceptMove(false), spacedCharsW(13), readOnly(false)
 {
 	pagesPos.append(0);
 
@@ -38,39 +40,18 @@ TextPreview::TextPreview(QWidget *parent) :
 	setFixedSize(320, 224);
 	clear();
 
-	if(names.isEmpty()) {
-		fontImage = QImage(":/images/font.png");
-		fillNames();
-	}
-}
-
-void TextPreview::fillNames()
-{
-	QStringList dataNames = Data::char_names;
-	for(int i=0 ; i<9 ; ++i) {
-		QString customName = Config::value(QString("customCharName%1").arg(i)).toString();
-		if(!customName.isEmpty()) {
-			dataNames.replace(i, customName);
+	if(fontImages[0].isNull()) {
+		QImage fontImage(":/images/font.png");
+		for(int i=0 ; i<8 ; ++i) {
+			fontImage.setColorTable(fontPalettes[i]);
+			fontImages[i] = fontImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
 		}
 	}
-	dataNames.replace(9, tr("Member 1"));
-	dataNames.replace(10, tr("Member 2"));
-	dataNames.replace(11, tr("Member 3"));
-//	bool jp = Config::value("jp_txt", false).toBool();
-//	Config::setValue("jp_txt", false);
-
-	for(int i=0 ; i<12 ; ++i) {
-		QByteArray nameData = FF7Text(dataNames.at(i), false).data();
-		names.append(nameData);
-		namesWidth[i] = calcFF7TextWidth(nameData);
-	}
-//	Config::setValue("jp_txt", jp);
 }
 
 void TextPreview::updateNames()
 {
-	names.clear();
-	fillNames();
+	FF7TextLayout::updateNames();
 }
 
 QPixmap TextPreview::getIconImage(int iconId)
@@ -78,19 +59,6 @@ QPixmap TextPreview::getIconImage(int iconId)
 	return QPixmap(":/images/keys.png").copy(iconId*16, 0, 16, 16);
 }
 
-int TextPreview::calcFF7TextWidth(const QByteArray &ff7Text)
-{
-	int width = 0;
-
-	foreach(const quint8 &c, ff7Text) {
-		if(c<0xe0) {
-			width += charFullWidth(0, c);
-		}
-	}
-
-	return width;
-}
-
 void TextPreview::clear()
 {
 	ff7Text.clear();
@@ -218,111 +186,7 @@ QSize TextPreview::calcSize(const QByteArray &ff7Text)
 
 QSize TextPreview::calcSize(const QByteArray &ff7Text, QList<int> &pagesPos)
 {
-	const int baseWidth = 8 + Config::value("autoSizeMarginRight", 14).toInt();
-	int line=0, width=baseWidth - 3, height=25, size=ff7Text.size(), maxW=0, maxH=0;
-	pagesPos.clear();
-	pagesPos.append(0);
-	bool jp = Config::value("jp_txt", false).toBool(), spaced_characters=false;
-	int spacedCharsW = Config::value("spacedCharactersWidth", 13).toInt();
-
-	for(int i=0 ; i<size ; ++i) {
-		quint8 caract = (quint8)ff7Text.at(i);
-		if(caract==0xff) break;
-		switch(caract) {
-		case 0xe8: // New Page
-		case 0xe9: // New Page 2
-			if(line == 0)	width += 3;
-			if(height>maxH)	maxH = height;
-			if(width>maxW)	maxW = width;
-			++line;
-			width = baseWidth;
-			height = 25;
-			pagesPos.append(i+1);
-			break;
-		case 0xe7: // \n
-			if(line == 0)	width += 3;
-			if(width>maxW)	maxW = width;
-			++line;
-			width = baseWidth;
-			height += 16;
-			break;
-		case 0xfa: // Jap 1
-			++i;
-			caract = (quint8)ff7Text.at(i);
-			if(jp) {
-				width += spaced_characters ? spacedCharsW : charFullWidth(2, caract);
-			} else if(caract < 0xd2) {
-				width += spaced_characters ? spacedCharsW : 1;
-			}
-			break;
-		case 0xfb: // Jap 2
-			++i;
-			if(jp) {
-				caract = (quint8)ff7Text.at(i);
-				width += spaced_characters ? spacedCharsW : charFullWidth(3, caract);
-			}
-			break;
-		case 0xfc: // Jap 3
-			++i;
-			if(jp) {
-				caract = (quint8)ff7Text.at(i);
-				width += spaced_characters ? spacedCharsW : charFullWidth(4, caract);
-			}
-			break;
-		case 0xfd: // Jap 4
-			++i;
-			if(jp) {
-				caract = (quint8)ff7Text.at(i);
-				width += spaced_characters ? spacedCharsW : charFullWidth(5, caract);
-			}
-			break;
-		case 0xfe: // Jap 5 + add
-			++i;
-			if(i >= size)		break;
-			caract = (quint8)ff7Text.at(i);
-			if(caract == 0xdd)
-				++i;
-			else if(caract == 0xde || caract == 0xdf || caract == 0xe1) {
-				if(caract == 0xe1)		width += spaced_characters ? spacedCharsW * 4 : 12;
-				int zeroId = !jp ? 0x10 : 0x33;
-				width += spaced_characters ? spacedCharsW : charFullWidth(0, zeroId);
-			} else if(caract == 0xe2)
-				i += 4;
-			else if(caract == 0xe9)
-				spaced_characters = !spaced_characters;
-			else if(caract < 0xd2 && jp)
-				width += spaced_characters ? spacedCharsW : charFullWidth(6, caract);
-			break;
-		default:
-			if(!jp && caract==0xe0) {// {CHOICE}
-				width += spaced_characters ? spacedCharsW * 10 : 30;
-			} else if(!jp && caract==0xe1) {// \t
-				width += spaced_characters ? spacedCharsW * 4 : 12;
-			} else if(!jp && caract>=0xe2 && caract<=0xe4) {// duo
-				const char *duo = optimisedDuo[caract-0xe2];
-				width += spaced_characters ? spacedCharsW : charFullWidth(1, (quint8)duo[0]);
-				width += spaced_characters ? spacedCharsW : charFullWidth(1, (quint8)duo[1]);
-			} else if(caract>=0xea && caract<=0xf5) {// Character names
-				width += spaced_characters ? spacedCharsW * names.at(caract-0xea).size() : namesWidth[caract-0xea];
-			} else if(caract>=0xf6 && caract<=0xf9) {// Keys
-				width += 17;
-			} else {
-				if(jp) {
-					width += spaced_characters ? spacedCharsW : charFullWidth(1, caract);
-				} else {
-					width += spaced_characters ? spacedCharsW : charFullWidth(0, caract);
-				}
-			}
-			break;
-		}
-	}
-
-	if(height>maxH)	maxH = height;
-	if(width>maxW)	maxW = width;
-	if(maxW>322)	maxW = 322;
-	if(maxH>226)	maxH = 226;
-
-	return QSize(maxW, maxH);
+	return FF7TextLayout().windowSize(ff7Text, pagesPos);
 }
 
 QSize TextPreview::getCalculatedSize() const
@@ -459,7 +323,7 @@ bool TextPreview::drawTextArea(QPainter *painter)
 	multicolor = -1;
 	int savFontColor = fontColor;
 	WindowType mode = Normal;
-	int spacedCharsW = Config::value("spacedCharactersWidth", 13).toInt();
+	spacedCharsW = Config::value("spacedCharactersWidth", 13).toInt();
 
 	/* Window Background */
 
@@ -498,7 +362,7 @@ bool TextPreview::drawTextArea(QPainter *painter)
 				else if(charId==0xe1)//\t
 					x += spaced_characters ? spacedCharsW * 4 : 12;
 				else if(charId>=0xe2 && charId<=0xe4) {
-					const quint8 *opti = (const quint8 *)optimisedDuo[charId-0xe2];
+					const quint8 *opti = (const quint8 *)FF7TextLayout::optimisedDuo[charId-0xe2];
 					letter(&x, &y, opti[0], painter, 0);
 					letter(&x, &y, opti[1], painter, 0);
 				} else {
@@ -508,7 +372,7 @@ bool TextPreview::drawTextArea(QPainter *painter)
 				letter(&x, &y, charId, painter, 1);
 			}
 		} else if(charId>=0xea && charId<=0xf5) {
-			word(&x, &y, names.at(charId-0xea), painter);
+			word(&x, &y, FF7TextLayout::name(charId-0xea), painter);
 		} else if(charId>=0xf6 && charId<=0xf9) {
 			painter->drawPixmap(x, y - 2, getIconImage(charId-0xf6));
 			x += 17;
@@ -690,8 +554,8 @@ void TextPreview::wheelEvent(QWheelEvent *event)
 
 void TextPreview::letter(int *x, int *y, int charId, QPainter *painter, quint8 tableId)
 {
-	int charWidth = charW(tableId, charId);
-	int leftPadd = leftPadding(tableId, charId);
+	int charWidth = FF7TextLayout::charWidth(tableId, charId);
+	int leftPadd = FF7TextLayout::leftPadding(tableId, charId);
 
 	if(*x + leftPadd + charWidth > maxW) {
 		*x = 8;
@@ -704,8 +568,18 @@ void TextPreview::letter(int *x, int *y, int charId, QPainter *painter, quint8 t
 	}
 
 	if(!spaced_characters)	*x += leftPadd;
-	painter->drawImage(*x, *y, letterImage(tableId, charId));
-	*x += spaced_characters ? Config::value("spacedCharactersWidth", 13).toInt() : charWidth;
+	if(Data::windowBin.isValid() &&
+			(tableId != 0 || !Data::windowBin.isJp())) {
+		quint8 table = tableId == 0 ? 0 : tableId - 1;
+		painter->drawImage(QPoint(*x, *y),
+		                   Data::windowBin.letterAtlas(table, WindowBinFile::FontColor(fontColor)),
+		                   Data::windowBin.letterRect(table, charId));
+	} else {
+		int charIdImage = charId + posTable[tableId];
+		painter->drawImage(QPoint(*x, *y), fontImages[fontImageColor],
+		                   QRect((charIdImage%21)*12, (charIdImage/21)*12, 12, 12));
+	}
+	*x += spaced_characters ? spacedCharsW : charWidth;
 }
 
 void TextPreview::word(int *x, int *y, const QByteArray &charIds, QPainter *painter, quint8 tableId)
@@ -715,43 +589,9 @@ void TextPreview::word(int *x, int *y, const QByteArray &charIds, QPainter *pain
 	}
 }
 
-quint8 TextPreview::charW(int tableId, int charId)
-{
-	return Data::windowBin.isValid() &&
-			(tableId != 0 || !Data::windowBin.isJp())
-			? Data::windowBin.charWidth(tableId == 0 ? 0 : tableId - 1, charId)
-			: CHAR_WIDTH(charWidth[tableId][charId]);
-}
-
-quint8 TextPreview::leftPadding(int tableId, int charId)
-{
-	return Data::windowBin.isValid() &&
-			(tableId != 0 || !Data::windowBin.isJp())
-			? Data::windowBin.charLeftPadding(tableId == 0 ? 0 : tableId - 1, charId)
-			: LEFT_PADD(charWidth[tableId][charId]);
-}
-
-quint8 TextPreview::charFullWidth(int tableId, int charId)
-{
-	return charW(tableId, charId) + leftPadding(tableId, charId);
-}
-
-QImage TextPreview::letterImage(int tableId, int charId)
-{
-	if(Data::windowBin.isValid() &&
-			(tableId != 0 || !Data::windowBin.isJp())) {
-		return Data::windowBin.letter(tableId == 0 ? 0 : tableId - 1, charId, WindowBinFile::FontColor(fontColor));
-	} else {
-		int charIdImage = charId + posTable[tableId];
-		return fontImage.copy((charIdImage%21)*12, (charIdImage/21)*12, 12, 12);
-	}
-}
-
 void TextPreview::setFontColor(int id, bool blink)
 {
-	if(!Data::windowBin.isValid()) {
-		fontImage.setColorTable(fontPalettes[blink ? DARKGREY : id]);
-	}
+	fontImageColor = blink ? DARKGREY : id;
 	fontColor = id;
 }
 
@@ -784,138 +624,3 @@ quint16 TextPreview::posTable[7] =
 	1113,/* +(21*10) */
 	1323/* (21*10) */
 };
-
-quint8 TextPreview::charWidth[7][256] =
-{
-	{ // International
-		3, 3, 72, 10, 7, 10, 9, 3, 72, 72, 7, 7, 39, 5, 38, 6,
-		8, 71, 8, 8, 8, 8, 8, 8, 8, 8, 69, 4, 7, 8, 7, 6,
-		10, 9, 7, 8, 8, 7, 7, 8, 8, 3, 6, 7, 7, 11, 8, 9,
-		7, 9, 7, 7, 7, 8, 9, 11, 8, 9, 7, 4, 6, 4, 7, 8,
-		4, 7, 7, 6, 7, 7, 6, 7, 7, 3, 4, 6, 3, 11, 7, 7,
-		7, 7, 5, 6, 6, 7, 7, 11, 7, 7, 6, 5, 3, 5, 8, 68,
-		73, 76, 72, 73, 73, 9, 8, 7, 7, 7, 7, 7, 7, 7, 7, 7,
-		7, 7, 4, 4, 4, 4, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
-		11, 6, 7, 8, 11, 6, 7, 7, 9, 9, 11, 4, 5, 8, 12, 9,
-		11, 7, 7, 7, 9, 7, 7, 7, 9, 8, 4, 6, 6, 9, 11, 7,
-		6, 3, 8, 7, 8, 8, 9, 7, 7, 9, 1, 9, 9, 9, 12, 11,
-		8, 12, 6, 6, 4, 4, 7, 7, 7, 9, 7, 9, 5, 5, 7, 7,
-		8, 3, 4, 6, 13, 9, 7, 9, 7, 7, 3, 4, 4, 3, 9, 9,
-		8, 9, 8, 8, 8, 3, 6, 7, 5, 6, 3, 6, 5, 6, 5, 5,
-		1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	},{ // Jap - 0
-		13, 13, 11, 13, 12, 13, 12, 12, 12, 13, 12, 12, 11, 12, 12, 10,
-		12, 12, 12, 11, 13, 11, 12, 9, 12, 12, 12, 13, 10, 12, 12, 12,
-		12, 12, 12, 12, 12, 12, 8, 11, 12, 13, 12, 10, 12, 12, 12, 12,
-		12, 11, 13, 8, 70, 8, 8, 9, 8, 8, 7, 8, 8, 39, 41, 8,
-		12, 11, 9, 11, 10, 12, 12, 12, 11, 11, 10, 12, 10, 10, 10, 8,
-		11, 11, 10, 9, 11, 10, 11, 9, 10, 11, 11, 11, 9, 10, 10, 11,
-		11, 10, 10, 11, 11, 10, 6, 9, 10, 10, 11, 12, 10, 11, 11, 11,
-		11, 12, 10, 12, 11, 10, 9, 12, 11, 12, 9, 11, 10, 12, 9, 12,
-		11, 11, 10, 11, 11, 10, 10, 9, 8, 8, 11, 10, 8, 11, 9, 10,
-		11, 11, 11, 11, 9, 10, 10, 12, 10, 11, 9, 10, 9, 8, 9, 9,
-		9, 9, 7, 8, 8, 9, 8, 8, 7, 8, 9, 8, 9, 10, 69, 41,
-		73, 74, 4, 9, 10, 9, 9, 9, 9, 9, 9, 9, 69, 7, 8, 9,
-		11, 9, 9, 9, 10, 9, 9, 11, 9, 9, 11, 9, 11, 10, 70, 9,
-		9, 13, 12, 13, 13, 70, 10, 6, 6, 11, 13, 10, 9, 72, 72, 72,
-		72, 9, 9, 1, 1, 1, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	},{ // Jap - 1
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 10,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 11,
-		13, 12, 10, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	},{ // Jap - 2
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13,
-		13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 9, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 12, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	},{ // Jap - 3
-		12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		10, 13, 13, 12, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	},{ // Jap - 4
-		13, 13, 13, 13, 13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	},{ // Jap - 5
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 11, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 12, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 12, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 11, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
-		13, 13, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	}
-};
-
-const char *TextPreview::optimisedDuo[3] =
-{
-	"\x0c\x00",//', '
-	"\x0e\x02",//'."'
-	"\xa9\x02" //'..."'
-};
-
-QList<QByteArray> TextPreview::names;
-
-int TextPreview::namesWidth[12];
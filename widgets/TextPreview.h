@@ -69,7 +69,6 @@ signals:
 	void positionChanged(const QPoint &);
 	void pageChanged(int);
 private:
-	static void fillNames();
 	bool drawTextArea(QPainter *painter);
 	static QPoint realPos(const FF7Window &ff7Window);
 	QList<FF7Window> ff7Windows;
@@ -81,28 +80,21 @@ private:
 	static bool curFrame;
 	bool acceptMove;
 	bool spaced_characters;
+	int spacedCharsW; // Config value read once per draw
 	QPoint moveStartPosition;
 	bool readOnly;
 
 	static int startMulticolor;
 	static int multicolor;
 	static int fontColor;
-	static QImage fontImage;
+	static int fontImageColor;
+	static QImage fontImages[8]; // Tinted with fontPalettes
 	void letter(int *x, int *y, int charId, QPainter *painter, quint8 tableId=0);
 	void word(int *x, int *y, const QByteArray &charIds, QPainter *painter, quint8 tableId=0);
-	static quint8 charW(int tableId, int charId);
-	static quint8 leftPadding(int tableId, int charId);
-	static quint8 charFullWidth(int tableId, int charId);
-	static QImage letterImage(int tableId, int charId);
 	static void setFontColor(int id, bool blink=false);
 	static QVector<QRgb> fontPalettes[8];
 	static QTimer timer;
-	static int calcFF7TextWidth(const QByteArray &ff7Text);
 	static quint16 posTable[7];
-	static quint8 charWidth[7][256];
-	static const char *optimisedDuo[3];
-	static QList<QByteArray> names;
-	static int namesWidth[12];
 protected:
 	void paintEvent(QPaintEvent *event);
 	void mousePressEvent(QMouseEvent *event);
@@ -74,6 +74,7 @@ WalkmeshManager::WalkmeshManager(QWidget *parent, const QGLWidget *shareWidget)
 		connect(slider3, SIGNAL(valueChanged(int)), walkmesh, SLOT(setZRotation(int)));
 		connect(resetCamera, SIGNAL(clicked()), SLOT(resetCamera()));
 		connect(showModels, SIGNAL(toggled(bool)), SLOT(setModelsVisible(bool)));
+		connect(walkmesh, SIGNAL(triangleSelected(int)), SLOT(selectTriangle(int)));
 	}
 }
 
@@ -832,19 +833,27 @@ void WalkmeshManager::setCurrentId(int i)
 	if(walkmesh)	walkmesh->setSelectedTriangle(i);
 }
 
+void WalkmeshManager::selectTriangle(int triangleID)
+{
+	if(!idFile || !idFile->isOpen() || triangleID >= idList->count()) {
+		return;
+	}
+
+	tabWidget->setCurrentIndex(1);
+	idList->setCurrentRow(triangleID);
+}
+
 void WalkmeshManager::addTriangle()
 {
 	int row = idList->currentRow();
 
 	if(idFile->isOpen()) {
-		Triangle tri;
+		Triangle tri = Triangle();
+		// The copy does not take the place of the original in its neighbors
 		Access acc;
-		if(row < idFile->triangleCount()) {
+		acc.a[0] = acc.a[1] = acc.a[2] = -1;
+		if(row >= 0 && row < idFile->triangleCount()) {
 			tri = idFile->triangle(row);
-			acc = idFile->access(row);
-		} else {
-			tri = Triangle();
-			acc = Access();
 		}
 		idFile->insertTriangle(row+1, tri, acc);
 		idList->insertItem(row+1, tr("Triangle %1").arg(row+1));
@@ -894,6 +903,11 @@ void WalkmeshManager::editIdTriangle(int id, const Vertex_s &values)
 			if(oldV.x != values.x || oldV.y != values.y || oldV.z != values.z) {
 				oldV = IdFile::fromVertex_s(values);
 				idFile->setTriangle(triangleID, old);
+				// Accesses on the moved edges may have changed
+				const Access &access = idFile->access(triangleID);
+				idAccess[0]->setValue(access.a[0]);
+				idAccess[1]->setValue(access.a[1]);
+				idAccess[2]->setValue(access.a[2]);
 				if(walkmesh)	walkmesh->updateGL();
 
 				emit modified();
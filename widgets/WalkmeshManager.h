@@ -48,6 +48,7 @@ private slots:
 	void editCaPos(double value);
 	void editCaZoom(int value);
 	void setCurrentId(int i);
+	void selectTriangle(int triangleID);
 	void addTriangle();
 	void removeTriangle();
 	void editIdTriangle(const Vertex_s &values);
@@ -16,7 +16,6 @@
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "WalkmeshWidget.h"
-#include "FieldModel.h"
 
 WalkmeshWidget::WalkmeshWidget(QWidget *parent, const QGLWidget *shareWidget) :
 	QGLWidget(/*QGLFormat(QGL::SampleBuffers),*/ parent, shareWidget),
@@ -24,13 +23,20 @@ WalkmeshWidget::WalkmeshWidget(QWidget *parent, const QGLWidget *shareWidget) :
 	xTrans(0.0f), yTrans(0.0f), transStep(360.0f), lastKeyPressed(-1),
 	_camID(0), _selectedTriangle(-1), _selectedDoor(-1), _selectedGate(-1),
 	_selectedArrow(-1), fovy(70.0), walkmesh(0), camera(0), infFile(0),
-	bgFile(0), scripts(0), field(0), modelsVisible(true)/*, thread(0)*/
+	bgFile(0), scripts(0), field(0), modelCache(this),
+	modelsVisible(true)/*, thread(0)*/
 {
 	setMinimumSize(320, 240);
 //	setAutoFillBackground(false);
 //	arrow = QPixmap(":/images/field-arrow-red.png");
 }
 
+WalkmeshWidget::~WalkmeshWidget()
+{
+	makeCurrent();
+	modelCache.clear();
+}
+
 void WalkmeshWidget::clear()
 {
 	walkmesh = 0;
@@ -41,6 +47,8 @@ void WalkmeshWidget::clear()
 	field = 0;
 //	if(thread)	thread->deleteLater();
 	fieldModels.clear();
+	makeCurrent();
+	modelCache.clear();
 	updateGL();
 }
 
@@ -53,6 +61,8 @@ void WalkmeshWidget::fill(Field *field)
 	this->scripts = field->scriptsAndTexts();
 	this->field = field;
 	this->fieldModels.clear();
+	makeCurrent();
+	modelCache.clear();
 	if(modelsVisible) {
 		openModels();
 	}
@@ -440,6 +450,14 @@ void WalkmeshWidget::paintGL()
 					previousModelId = modelId;
 					FF7Position position = i.value();
 
+					if(!position.hasZ && !position.hasId) {
+						int triangleID = walkmesh->findTriangle(position.x, position.y);
+						if(triangleID >= 0) {
+							position.hasId = true;
+							position.id = triangleID;
+						}
+					}
+
 					if(!position.hasZ && position.hasId && position.id < walkmesh->triangleCount()) {
 						position.z = walkmesh->triangle(position.id).vertices[0].z;
 					} else if(!position.hasZ) {
@@ -463,7 +481,7 @@ void WalkmeshWidget::paintGL()
 //							glTranslatef(trans.first().x/5.0f, trans.first().y/5.0f, trans.first().z/5.0f);
 //						}
 
-						FieldModel::paintModel(this, fieldModel, 0, 0, 8.0f);
+						FieldModel::paintModel(modelCache, fieldModel, 0, 0, 8.0f);
 
 						glPopMatrix();
 					}
@@ -515,6 +533,50 @@ void WalkmeshWidget::mouseMoveEvent(QMouseEvent *event)
 	updateGL();
 }
 
+void WalkmeshWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+	if(event->button() == Qt::LeftButton) {
+		int triangleID = triangleAt(event->pos());
+		if(triangleID >= 0) {
+			setSelectedTriangle(triangleID);
+			emit triangleSelected(triangleID);
+		}
+	}
+}
+
+/*!
+ * Returns the walkmesh triangle under the widget position pos, or -1.
+ */
+int WalkmeshWidget::triangleAt(const QPoint &pos)
+{
+	if(!walkmesh || !walkmesh->isOpen()) {
+		return -1;
+	}
+
+	makeCurrent();
+
+	// Matrices from the last paintGL()
+	GLdouble modelView[16], projection[16];
+	GLint viewport[4];
+	glGetDoublev(GL_MODELVIEW_MATRIX, modelView);
+	glGetDoublev(GL_PROJECTION_MATRIX, projection);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	const GLdouble winX = pos.x(), winY = viewport[3] - pos.y();
+	GLdouble nearX, nearY, nearZ, farX, farY, farZ;
+
+	if(!gluUnProject(winX, winY, 0.0, modelView, projection, viewport, &nearX, &nearY, &nearZ)
+			|| !gluUnProject(winX, winY, 1.0, modelView, projection, viewport, &farX, &farY, &farZ)) {
+		return -1;
+	}
+
+	// The walkmesh is drawn in 1/4096 units
+	const QVector3D origin(nearX * 4096.0, nearY * 4096.0, nearZ * 4096.0),
+			target(farX * 4096.0, farY * 4096.0, farZ * 4096.0);
+
+	return walkmesh->pickTriangle(origin, target - origin);
+}
+
 void WalkmeshWidget::keyPressEvent(QKeyEvent *event)
 {
 	if(lastKeyPressed == event->key()
@@ -26,6 +26,7 @@
 #include <GL/glu.h>
 #endif
 #include "core/field/Field.h"
+#include "FieldModel.h"
 //#include "FieldModelThread.h"
 
 class WalkmeshWidget : public QGLWidget
@@ -33,9 +34,13 @@ class WalkmeshWidget : public QGLWidget
 	Q_OBJECT
 public:
 	explicit WalkmeshWidget(QWidget *parent=0, const QGLWidget *shareWidget=0);
+	virtual ~WalkmeshWidget();
 	void clear();
 	void fill(Field *field);
 	void updatePerspective();
+	int triangleAt(const QPoint &pos);
+signals:
+	void triangleSelected(int triangleID);
 public slots:
 	void setXRotation(int);
 	void setYRotation(int);
@@ -71,6 +76,7 @@ private:
 	Section1File *scripts;
 	Field *field;
 	QMap<int, FieldModelFile *> fieldModels;
+	FieldModelGLCache modelCache;
 //	FieldModelThread *thread;
 	QPoint moveStart;
 //	QPixmap arrow;
@@ -82,6 +88,7 @@ protected:
 	virtual void wheelEvent(QWheelEvent *event);
 	virtual void mousePressEvent(QMouseEvent *event);
 	virtual void mouseMoveEvent(QMouseEvent *event);
+	virtual void mouseDoubleClickEvent(QMouseEvent *event);
 	virtual void keyPressEvent(QKeyEvent *event);
 	virtual void focusInEvent(QFocusEvent *event);
 	virtual void focusOutEvent(QFocusEvent *event);